@@ -42,10 +42,12 @@ namespace GlObjects
 /// @param	orientation		Orientation of the mirror. The normal of an unrotated mirror is (0,0,1).
 /// @param	w,h				Size of the mirror in world units
 /// @param	tw,th			Size of the texture in texels
+/// @param	pBudget			Budget that manages the memory used by the texture. If 0, the memory is not managed.
 ///
 /// @warn	This function may throw <tt>std::bad_alloc</tt>.
 
-Mirror::Mirror( Vector3 const & position, Quaternion const & orientation, float w, float h, int tw, int th )
+Mirror::Mirror( Vector3 const & position, Quaternion const & orientation, float w, float h, int tw, int th,
+				TextureBudget * pBudget /* = 0*/ )
 	:m_Frame( position, orientation, Vector3( 1.0f, 1.0f, 1.0f ) ),
 	m_MirrorWidth( w ),
 	m_MirrorHeight( h ),
@@ -60,6 +62,12 @@ Mirror::Mirror( Vector3 const & position, Quaternion const & orientation, float
 
 	m_pMaterial = new Glx::Material( m_pTexture, GL_REPLACE, Glx::Rgba::WHITE, Glx::Rgba::BLACK, 0.f, Glx::Rgba::BLACK, GL_FLAT );
 	if ( m_pMaterial == 0 ) throw std::bad_alloc();
+
+	if ( pBudget != 0 )
+	{
+		m_pTexture->Apply();
+		pBudget->Add( this, TextureBudget::GetBoundTextureSize() );
+	}
 }
 
 
@@ -119,6 +127,13 @@ Mirror::~Mirror()
 
 bool Mirror::Begin( Glx::Camera const & camera )
 {
+	// If the texture has been evicted, restore it so that the reflection can be copied into it
+
+	if ( GetBudget() != 0 )
+	{
+		GetBudget()->Use( this );
+	}
+
 	Vector3 const		mirrorNormal	= m_Frame.GetZAxis();
 	Point const			mirrorPosition	= m_Frame.GetTranslation();
 	Plane const			mirrorPlane( mirrorNormal, Dot( mirrorNormal, mirrorPosition ) );
@@ -259,6 +274,14 @@ void Mirror::End()
 
 void Mirror::Apply() const
 {
+	// Drawing the mirror binds its texture, so it counts as a use. Otherwise, a mirror that is visible but was not
+	// re-rendered this frame could be evicted.
+
+	if ( GetBudget() != 0 )
+	{
+		GetBudget()->Use( const_cast< Mirror * >( this ) );
+	}
+
 	m_pMaterial->Apply();
 
 	glBegin( GL_QUADS );
@@ -281,4 +304,30 @@ void Mirror::Apply() const
 }
 
 
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void Mirror::Evict()
+{
+	m_pTexture->Apply();
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, 0, 0, 0, GL_RGB, GL_UNSIGNED_BYTE, 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool Mirror::Reload()
+{
+	m_pTexture->Apply();
+	glCopyTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, 0, 0, m_pTexture->GetWidth(), m_pTexture->GetHeight(), 0 );
+
+	return true;
+}
+
+
 } // namespace GlObjects
@@ -20,6 +20,7 @@
 #include "Glx/Camera.h"
 #include "Glx/Texture.h"
 #include "Glx/Material.h"
+#include "GlObjects/TextureLoader/TextureBudget.h"
 
 class Vector3;
 class Quaternion;
@@ -35,12 +36,13 @@ namespace GlObjects
 
 /// A flat rectangular reflective surface
 
-class Mirror
+class Mirror : private TextureBudget::Resident
 {
 public:
 
 	/// Constructor
-	Mirror( Vector3 const & position, Quaternion const & orientation, float w, float h, int tw, int th );
+	Mirror( Vector3 const & position, Quaternion const & orientation, float w, float h, int tw, int th,
+			TextureBudget * pBudget = 0 );
 //	Mirror( Glx::Frame const & frame, int tw, int th );
 
 	/// Destructor
@@ -59,6 +61,12 @@ public:
 
 private:
 
+	// Releases the memory used by the reflection texture
+	virtual void Evict();
+
+	// Restores the reflection texture. It is re-rendered by the next Begin() and End().
+	virtual bool Reload();
+
 	Glx::Texture *	m_pTexture;							///< Surface texture of the mirror
 	Glx::Material *	m_pMaterial;						///< Surface material of the mirror
 	float			m_MirrorWidth, m_MirrorHeight;		///< Size of the mirror
@@ -29,7 +29,7 @@
 #endif // defined( USING_REFLECTION )
 
 #include "GlObjects/SkyBox/SkyBox.h"
-#include "GlObjects/TextureLoader/TextureLoader.h"
+#include "GlObjects/TextureLoader/TextureCache.h"
 #include "Glx/Glx.h"
 #include "Math/Matrix33.h"
 #include "Math/Matrix44.h"
@@ -80,7 +80,7 @@ static GlObjects::Reflection *	s_pReflection				= 0;
 static GlObjects::Mirror *		s_pMirror					= 0;
 #endif // defined( USING_REFLECTION )
 
-static Glx::Texture *			s_pReflectionTexture		= 0;
+static GlObjects::TextureCache::Handle	s_ReflectionTexture;
 static Glx::Material *			s_pReflectionMaterial		= 0;
 static Quaternion				s_ReflectionOrientation		= Quaternion::Identity();
 
@@ -99,8 +99,6 @@ static Glx::Material *			s_pSphereMaterial			= 0;
 
 static float					s_Reflectivity				= 0.5f;
 
-static GlObjects::TextureLoader	s_TextureLoader;
-
 /********************************************************************************************************************/
 /*																													*/
 /*																													*/
@@ -171,12 +169,12 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPreviousInst, LPSTR lpszCmdL
 
 			// Create the reflection texture
 
-			s_pReflectionTexture		= s_TextureLoader.Load( "res/water2_256.tga", GL_CLAMP ).release();
-			if ( !s_pReflectionTexture ) exit( 1 );
+			s_ReflectionTexture			= GlObjects::TextureCache::GetShared().Load( "res/water2_256.tga", GL_CLAMP );
+			if ( !s_ReflectionTexture.IsValid() ) exit( 1 );
+
+			// The texture is bound through its handle when the reflection is drawn, so the material is not textured
 
-			s_pReflectionMaterial = new Glx::Material( s_pReflectionTexture,
-													   GL_MODULATE,
-													   Glx::Rgba( 1.0f, 1.0f, 1.0f, 1.0f - s_Reflectivity ) );
+			s_pReflectionMaterial = new Glx::Material( Glx::Rgba( 1.0f, 1.0f, 1.0f, 1.0f - s_Reflectivity ) );
 			if ( !s_pReflectionMaterial ) exit( 1 );
 		}
 
@@ -219,6 +217,7 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPreviousInst, LPSTR lpszCmdL
 		delete s_pSky;
 		delete s_pFont;
 		delete s_pReflectionMaterial;
+		s_ReflectionTexture.Reset();
 #if defined( USING_REFLECTION )
 		delete s_pReflection;
 #else // defined( USING_REFLECTION )
@@ -419,6 +418,14 @@ static void Display()
 
 #if defined( USING_REFLECTION )
 
+	// Draw the reflected sky. It is drawn with the camera's view, so the reflection pass does not draw the sky again.
+
+	s_pLighting->Disable();
+
+	s_pSky->ApplyReflected( s_pReflection->m_Plane );
+
+	glDepthMask( GL_TRUE );
+
 	// Create the reflection in the frame buffer
 
 	if ( s_pReflection->Begin( *s_pCamera ) )
@@ -519,6 +526,12 @@ static void DrawScene( bool bReflectionPass )
 
 		s_pReflectionMaterial->Apply();
 
+		// Bind the texture through its handle, so the budget sees the use and reloads it if it has been evicted
+
+		Glx::Enable( GL_TEXTURE_2D );
+		glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+		s_ReflectionTexture.Apply();
+
 		glBegin( GL_QUADS );
 		glNormal3f( 0.0f, 0.0f, 1.0f );
 		glTexCoord2f( 0.0f, 0.0f ); glVertex3f( -MIRROR_W*0.5f, -MIRROR_H*0.5f, 0.0f );
@@ -527,6 +540,7 @@ static void DrawScene( bool bReflectionPass )
 		glTexCoord2f( 0.0f, 1.0f ); glVertex3f( -MIRROR_W*0.5f,  MIRROR_H*0.5f, 0.0f );
 		glEnd();
 
+		Glx::Disable( GL_TEXTURE_2D );
 		Glx::Disable( GL_BLEND );
 
 		s_pLighting->Disable();
@@ -567,24 +581,25 @@ static void DrawScene( bool bReflectionPass )
 	}
 
 	// Draw the sky.
-	// The reflection pass version is a standard skybox, but because the main pass skybox is drawn after the reflection, it must be drawn as far back as possible and
-	// depth-testing must be enabled.
+	// With a Reflection, the reflected sky has already been drawn (see Display()). With a Mirror, the reflection
+	// pass version is a standard skybox. The main pass skybox is drawn last, at the far plane, so that the pixels
+	// covered by the reflection and the shapes are not drawn again.
 
-	s_pLighting->Disable();
+#if !defined( USING_REFLECTION )
 
-	if ( !bReflectionPass )
-	{
-		s_pSky->Apply( s_pCamera->GetPosition(), s_pCamera->GetFarDistance() * float( Math::SQRT_OF_3_OVER_3 ), true );
-	}
-	else
+	if ( bReflectionPass )
 	{
+		s_pLighting->Disable();
+
 		s_pSky->Apply( s_pCamera->GetPosition(), s_pCamera->GetFarDistance() * float( Math::SQRT_OF_3_OVER_3 ) );
 		Glx::Enable( GL_DEPTH_TEST );
+
+		s_pLighting->Enable();
+		glDepthMask( GL_TRUE );
+		Glx::Disable( GL_TEXTURE_2D );
 	}
 
-	s_pLighting->Enable();
-	glDepthMask( GL_TRUE );
-	Glx::Disable( GL_TEXTURE_2D );
+#endif // !defined( USING_REFLECTION )
 
 	// Draw the back shape
 
@@ -632,6 +647,19 @@ static void DrawScene( bool bReflectionPass )
 	auxSolidTorus( .2, .5 );
 
 	glPopMatrix();
+
+	// Draw the sky behind everything else (main pass only)
+
+	if ( !bReflectionPass )
+	{
+		s_pLighting->Disable();
+
+		s_pSky->ApplyAtFarPlane( *s_pCamera );
+
+		s_pLighting->Enable();
+		glDepthMask( GL_TRUE );
+		Glx::Disable( GL_TEXTURE_2D );
+	}
 }
 
 /********************************************************************************************************************/
@@ -20,16 +20,511 @@
 #include <windows.h>
 #include <gl/gl.h>
 
+#include "GlObjects/TextureLoader/BufferObjects.h"
+#include "GlObjects/TextureLoader/TextureCache.h"
 #include "GlObjects/TextureLoader/TextureLoader.h"
+#include "GlObjects/TextureLoader/CubeMapTexture.h"
+#include "GlObjects/TextureLoader/Image.h"
+#include "GlObjects/TextureLoader/PanoramaConverter.h"
 #include "Glx/Glx.h"
+#include "Math/Matrix44.h"
+#include "Math/Plane.h"
 #include "TgaFile/TgaFile.h"
 #include "Misc/SafeStr.h"
 
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <process.h>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+// Corners of each face of the unit cube. Texture coordinates (0,0), (1,0), (1,1), and (0,1) are mapped to the
+// corners in order.
+
+GLfloat const	s_aVertices[ GlObjects::SkyBox::NUM_FACES ][ 4 ][ 3 ] =
+{
+	{	{ -1.f, -1.f, -1.f }, {  1.f, -1.f, -1.f }, {  1.f,  1.f, -1.f }, { -1.f,  1.f, -1.f }	},	// -Z
+	{	{ -1.f,  1.f,  1.f }, {  1.f,  1.f,  1.f }, {  1.f, -1.f,  1.f }, { -1.f, -1.f,  1.f }	},	// +Z
+	{	{  1.f,  1.f, -1.f }, {  1.f, -1.f, -1.f }, {  1.f, -1.f,  1.f }, {  1.f,  1.f,  1.f }	},	// +X
+	{	{ -1.f, -1.f, -1.f }, { -1.f,  1.f, -1.f }, { -1.f,  1.f,  1.f }, { -1.f, -1.f,  1.f }	},	// -X
+	{	{ -1.f,  1.f, -1.f }, {  1.f,  1.f, -1.f }, {  1.f,  1.f,  1.f }, { -1.f,  1.f,  1.f }	},	// +Y
+	{	{  1.f, -1.f, -1.f }, { -1.f, -1.f, -1.f }, { -1.f, -1.f,  1.f }, {  1.f, -1.f,  1.f }	},	// -Y
+};
+
+// Texture coordinates of each corner, for faces that are separate 2D textures
+
+GLfloat const	s_aTexCoords[ GlObjects::SkyBox::NUM_FACES ][ 4 ][ 2 ] =
+{
+	{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// -Z
+	{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// +Z
+	{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// +X
+	{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// -X
+	{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// +Y
+	{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	}	// -Y
+};
+
+// Indexes of the corners of each face. The faces are drawn as ranges of this list.
+
+GLushort const	s_aIndexes[ GlObjects::SkyBox::NUM_FACES * 4 ] =
+{
+	 0,  1,  2,  3,		// -Z
+	 4,  5,  6,  7,		// +Z
+	 8,  9, 10, 11,		// +X
+	12, 13, 14, 15,		// -X
+	16, 17, 18, 19,		// +Y
+	20, 21, 22, 23		// -Y
+};
+
+// Offsets of the arrays in the vertex buffer
+
+size_t const	VERTEX_OFFSET	= 0;
+size_t const	TEXCOORD_OFFSET	= sizeof( s_aVertices );
+
+// Draws a range of consecutive faces. pIndexes is the address of the index list, or 0 if it is in the bound element
+// array buffer.
+
+void DrawFaces( GLushort const * pIndexes, int first, int count )
+{
+	glDrawElements( GL_QUADS, count * 4, GL_UNSIGNED_SHORT, pIndexes + first * 4 );
+}
+
+// Returns a mask of the faces of the unit cube that may be visible with the current modelview and projection
+// matrices. A face is invisible if all of its corners are on the outside of the same side of the view frustum. The
+// far plane is ignored because the box is sized to fit inside it.
+
+unsigned FindVisibleFaces()
+{
+	GLfloat	p[ 16 ];
+	GLfloat	mv[ 16 ];
+
+	glGetFloatv( GL_PROJECTION_MATRIX, p );
+	glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+
+	// Concatenate the matrices (they are column-major)
+
+	GLfloat	m[ 16 ];
+
+	for ( int c = 0; c < 4; c++ )
+	{
+		for ( int r = 0; r < 4; r++ )
+		{
+			m[ c * 4 + r ] = p[ 0 * 4 + r ] * mv[ c * 4 + 0 ] +
+							 p[ 1 * 4 + r ] * mv[ c * 4 + 1 ] +
+							 p[ 2 * 4 + r ] * mv[ c * 4 + 2 ] +
+							 p[ 3 * 4 + r ] * mv[ c * 4 + 3 ];
+		}
+	}
+
+	unsigned	visible	= 0;
+
+	for ( int face = 0; face < GlObjects::SkyBox::NUM_FACES; face++ )
+	{
+		unsigned	outside	= ~0u;	// Sides that every corner so far is outside of
+
+		for ( int i = 0; i < 4; i++ )
+		{
+			GLfloat const ( & v )[ 3 ] = s_aVertices[ face ][ i ];
+
+			GLfloat const	x	= m[ 0 ] * v[0] + m[ 4 ] * v[1] + m[  8 ] * v[2] + m[ 12 ];
+			GLfloat const	y	= m[ 1 ] * v[0] + m[ 5 ] * v[1] + m[  9 ] * v[2] + m[ 13 ];
+			GLfloat const	z	= m[ 2 ] * v[0] + m[ 6 ] * v[1] + m[ 10 ] * v[2] + m[ 14 ];
+			GLfloat const	w	= m[ 3 ] * v[0] + m[ 7 ] * v[1] + m[ 11 ] * v[2] + m[ 15 ];
+
+			unsigned	code	= 0;
+
+			if ( x < -w ) code |= 0x01;
+			if ( x >  w ) code |= 0x02;
+			if ( y < -w ) code |= 0x04;
+			if ( y >  w ) code |= 0x08;
+			if ( z < -w ) code |= 0x10;
+
+			outside &= code;
+		}
+
+		if ( outside == 0 )
+		{
+			visible |= 1 << face;
+		}
+	}
+
+	return visible;
+}
+
+// Returns the location of the view point in the current modelview matrix. The upper-left 3x3 of the matrix must be
+// orthonormal.
+
+Vector3 GetViewPoint()
+{
+	GLfloat	m[ 16 ];
+
+	glGetFloatv( GL_MODELVIEW_MATRIX, m );
+
+	// The view point is -R^T * t, where R is the upper-left 3x3 and t is the translation (the matrix is column-major)
+
+	return Vector3( -( m[0] * m[12] + m[1] * m[13] + m[ 2] * m[14] ),
+					-( m[4] * m[12] + m[5] * m[13] + m[ 6] * m[14] ),
+					-( m[8] * m[12] + m[9] * m[13] + m[10] * m[14] ) );
+}
+
+// The cube map face corresponding to each face of the skybox
+
+GlObjects::CubeMapTexture::Face const	s_aCubeFaces[ GlObjects::SkyBox::NUM_FACES ] =
+{
+	GlObjects::CubeMapTexture::FACE_NEGATIVE_Z,
+	GlObjects::CubeMapTexture::FACE_POSITIVE_Z,
+	GlObjects::CubeMapTexture::FACE_POSITIVE_X,
+	GlObjects::CubeMapTexture::FACE_NEGATIVE_X,
+	GlObjects::CubeMapTexture::FACE_POSITIVE_Y,
+	GlObjects::CubeMapTexture::FACE_NEGATIVE_Y
+};
+
+// Creates the name of the file containing a face
+
+void MakeFaceFileName( char * path, size_t size, char const * fileName, int face )
+{
+	static char const	aSuffixes[ GlObjects::SkyBox::NUM_FACES ][4] =
+						{
+							"_-Z",
+							"_+Z",
+							"_+X",
+							"_-X",
+							"_+Y",
+							"_-Y"
+						};
+
+	SafeStrcpy( path, fileName, size );
+	SafeStrcat( path, aSuffixes[ face ], size );
+	SafeStrcat( path, ".tga", size );
+}
+
+// Returns the key that identifies a cube map of the faces in the mask: the face and the normalized path of the file
+// of each face (the panorama, for every face of a panorama)
+
+std::string MakeCubeMapKey( char const * fileName, bool bPanorama, unsigned faceMask )
+{
+	std::string	key;
+
+	for ( int face = 0; face < GlObjects::SkyBox::NUM_FACES; face++ )
+	{
+		if ( ( faceMask & ( 1 << face ) ) != 0 )
+		{
+			char path[ _MAX_PATH ];
+
+			if ( bPanorama )
+			{
+				SafeStrcpy( path, fileName, sizeof( path ) );
+			}
+			else
+			{
+				MakeFaceFileName( path, sizeof( path ), fileName, face );
+			}
+
+			key += char( '0' + face );
+			key += GlObjects::TextureCache::NormalizePath( path );
+			key += '|';
+		}
+	}
+
+	return key;
+}
+
+// Returns a copy of a square skybox face with its texels rearranged into the orientation of its cube map face.
+//
+// A cube map face is addressed by the direction of the texel (as specified by ARB_texture_cube_map) rather than by
+// the texture coordinates of the skybox quad, so each texel of the cube map face is mapped to a direction, and the
+// direction is mapped back to the quad. The arithmetic is done in units of half a texel, so it is exact.
+
+std::auto_ptr< GlObjects::Image > RemapToCubeFace( GlObjects::Image const & source, int face )
+{
+	int const		size		= source.GetWidth();
+	int const		texelSize	= source.GetTexelSize();
+	uint8 const *	pSource		= source.GetData();
+
+	assert( source.GetHeight() == size );
+
+	std::auto_ptr< GlObjects::Image >	qRemapped( new GlObjects::Image( size, size, source.GetFormat(), texelSize ) );
+	uint8 * const						pDest		= qRemapped->GetBuffer();
+
+	GLfloat const ( & aCorners )[ 4 ][ 3 ] = s_aVertices[ face ];
+
+	int	p0[ 3 ];	// First corner
+	int	e1[ 3 ];	// Edge along which s increases
+	int	e3[ 3 ];	// Edge along which t increases
+
+	for ( int k = 0; k < 3; k++ )
+	{
+		p0[k] = int( aCorners[0][k] );
+		e1[k] = int( aCorners[1][k] ) - p0[k];
+		e3[k] = int( aCorners[3][k] ) - p0[k];
+	}
+
+	for ( int j = 0; j < size; j++ )
+	{
+		int const	tc	= 2 * j + 1 - size;
+
+		for ( int i = 0; i < size; i++ )
+		{
+			int const	sc	= 2 * i + 1 - size;
+			int			d[ 3 ];
+
+			switch ( s_aCubeFaces[ face ] )
+			{
+			case GlObjects::CubeMapTexture::FACE_POSITIVE_X:
+				d[0] =  size;	d[1] = -tc;		d[2] = -sc;
+				break;
+			case GlObjects::CubeMapTexture::FACE_NEGATIVE_X:
+				d[0] = -size;	d[1] = -tc;		d[2] =  sc;
+				break;
+			case GlObjects::CubeMapTexture::FACE_POSITIVE_Y:
+				d[0] =  sc;		d[1] =  size;	d[2] =  tc;
+				break;
+			case GlObjects::CubeMapTexture::FACE_NEGATIVE_Y:
+				d[0] =  sc;		d[1] = -size;	d[2] = -tc;
+				break;
+			case GlObjects::CubeMapTexture::FACE_POSITIVE_Z:
+				d[0] =  sc;		d[1] = -tc;		d[2] =  size;
+				break;
+			default:	// FACE_NEGATIVE_Z
+				d[0] = -sc;		d[1] = -tc;		d[2] = -size;
+				break;
+			}
+
+			// Project the direction onto the edges of the quad. The result is 4 * the texel coordinate + 2.
+
+			int const	r[ 3 ]	= { d[0] - size * p0[0], d[1] - size * p0[1], d[2] - size * p0[2] };
+			int const	u		= r[0] * e1[0] + r[1] * e1[1] + r[2] * e1[2];
+			int const	v		= r[0] * e3[0] + r[1] * e3[1] + r[2] * e3[2];
+			int const	x	= ( u - 2 ) / 4;
+			int const	y	= ( v - 2 ) / 4;
+
+			assert( x >= 0 && x < size && y >= 0 && y < size );
+
+			memcpy( pDest + ( j * size + i ) * texelSize, pSource + ( y * size + x ) * texelSize, texelSize );
+		}
+	}
+
+	return qRemapped;
+}
+
+// Decodes the faces in the mask and rearranges them into the orientation of their cube map faces. If the file is a
+// panorama, the faces are converted from it instead. Returns false if a face can't be decoded or if the faces can't
+// share a cube map (they must be square and have the same size and format). GL is not used, so this can be called by
+// any thread.
+
+bool DecodeCubeFaces( char const *						fileName,
+					  bool								bPanorama,
+					  unsigned							faceMask,
+					  std::auto_ptr< GlObjects::Image >	aqFaces[] )
+{
+	using GlObjects::CubeMapTexture;
+	using GlObjects::Image;
+	using GlObjects::SkyBox;
+
+	if ( bPanorama )
+	{
+		std::auto_ptr< Image >	aqCubeFaces[ CubeMapTexture::NUM_FACES ];
+
+		if ( !GlObjects::PanoramaConverter().Load( fileName, aqCubeFaces ) )
+		{
+			return false;
+		}
+
+		for ( int face = 0; face < SkyBox::NUM_FACES; face++ )
+		{
+			if ( ( faceMask & ( 1 << face ) ) != 0 )
+			{
+				aqFaces[ face ] = aqCubeFaces[ s_aCubeFaces[ face ] ];
+			}
+		}
+
+		return faceMask != 0;
+	}
+
+	Image const *	pFirst	= 0;
+
+	for ( int face = 0; face < SkyBox::NUM_FACES; face++ )
+	{
+		if ( ( faceMask & ( 1 << face ) ) != 0 )
+		{
+			char path[ _MAX_PATH ];
+
+			MakeFaceFileName( path, sizeof( path ), fileName, face );
+
+			std::auto_ptr< Image >	qImage	= GlObjects::TextureLoader::Decode( path );
+
+			if ( qImage.get() == 0 || qImage->GetWidth() != qImage->GetHeight() )
+			{
+				return false;
+			}
+
+			if ( pFirst != 0 &&
+				 ( qImage->GetWidth() != pFirst->GetWidth() ||
+				   qImage->GetFormat() != pFirst->GetFormat() ||
+				   qImage->GetTexelSize() != pFirst->GetTexelSize() ) )
+			{
+				return false;
+			}
+
+			aqFaces[ face ] = RemapToCubeFace( *qImage, face );
+
+			if ( pFirst == 0 )
+			{
+				pFirst = aqFaces[ face ].get();
+			}
+		}
+	}
+
+	return pFirst != 0;
+}
+
+// Creates a cube map from faces that have been rearranged by RemapToCubeFace(). At least one face must be present.
+// Faces that are not present are left undefined.
+
+std::auto_ptr< GlObjects::CubeMapTexture > UploadCubeFaces( std::auto_ptr< GlObjects::Image > const aqFaces[] )
+{
+	using GlObjects::CubeMapTexture;
+	using GlObjects::Image;
+
+	Image const *	pFirst	= 0;
+
+	for ( int face = 0; face < GlObjects::SkyBox::NUM_FACES && pFirst == 0; face++ )
+	{
+		pFirst = aqFaces[ face ].get();
+	}
+
+	assert( pFirst != 0 );
+
+	std::auto_ptr< CubeMapTexture >	qCubeMap( new CubeMapTexture( pFirst->GetWidth(),
+																  pFirst->GetFormat(), pFirst->GetType() ) );
+
+	for ( int face = 0; face < GlObjects::SkyBox::NUM_FACES; face++ )
+	{
+		if ( aqFaces[ face ].get() != 0 )
+		{
+			qCubeMap->SetFace( s_aCubeFaces[ face ], 0, aqFaces[ face ]->GetData() );
+		}
+	}
+
+	return qCubeMap;
+}
+
+// Returns the number of bytes of texture memory used by a cube map of the faces
+
+size_t GetCubeFacesSize( std::auto_ptr< GlObjects::Image > const aqFaces[] )
+{
+	size_t	size	= 0;
+
+	for ( int face = 0; face < GlObjects::SkyBox::NUM_FACES; face++ )
+	{
+		if ( aqFaces[ face ].get() != 0 )
+		{
+			size += aqFaces[ face ]->GetSize();
+		}
+	}
+
+	return size;
+}
+
+} // anonymous namespace
+
 
 namespace GlObjects
 {
 
 
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A load of the full faces in the background (see LOAD_PROGRESSIVELY)
+
+struct SkyBox::BackgroundLoad
+{
+	std::string				fileName;					///< Base name of the files (or the name of the panorama)
+	bool					bPanorama;					///< @c true if the faces are converted from a panorama
+	TextureCache *			pCache;						///< Cache to load through if the faces are not cube-mapped
+	unsigned				faceMask;					///< Which faces to load
+	HANDLE					hThread;					///< The thread doing the load
+	bool					bSucceeded;					///< @c true if the faces were decoded into aqFaces
+	std::auto_ptr< Image >	aqFaces[ NUM_FACES ];		///< The decoded faces, in cube map orientation
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A cube map shared by every skybox that draws the same faces from the same files
+
+struct SkyBox::SharedCubeMap : public TextureBudget::Resident
+{
+	typedef std::map< std::string, SharedCubeMap * > Map;
+
+	std::string						fileName;			///< Base name of the files (or the name of the panorama)
+	bool							bPanorama;			///< @c true if the faces are converted from a panorama
+	unsigned						faceMask;			///< Which faces are in the cube map
+	std::auto_ptr< CubeMapTexture >	qCubeMap;			///< The cube map, or 0 if it has been evicted
+	int								referenceCount;		///< Number of skyboxes using the cube map
+	Map::iterator					position;			///< Location of this cube map in s_Map
+
+	static Map						s_Map;				///< The shared cube maps, by key (see MakeCubeMapKey())
+
+	// Destroys the cube map
+	virtual void Evict();
+
+	// Loads the cube map again
+	virtual bool Reload();
+};
+
+SkyBox::SharedCubeMap::Map	SkyBox::SharedCubeMap::s_Map;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void SkyBox::SharedCubeMap::Evict()
+{
+	qCubeMap.reset();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The faces are decoded and uploaded again on the calling thread.
+
+bool SkyBox::SharedCubeMap::Reload()
+{
+	try
+	{
+		std::auto_ptr< Image >	aqFaces[ NUM_FACES ];
+
+		if ( !DecodeCubeFaces( fileName.c_str(), bPanorama, faceMask, aqFaces ) )
+		{
+			return false;
+		}
+
+		qCubeMap = UploadCubeFaces( aqFaces );
+	}
+	catch ( ... )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
 /********************************************************************************************************************/
 /*																													*/
 /*																													*/
@@ -41,42 +536,102 @@ namespace GlObjects
 ///						are needed.
 /// @param	faceMask	Which faces of the skybox are to be drawn. This value is set by ORing the appropriate Faces
 ///						values together.
+/// @param	pCache		Cache that the textures are loaded through. If 0, TextureCache::GetShared() is used. Skyboxes
+///						that use the same files share the same textures. If the faces are loaded into a cube map, the
+///						cube map is shared by the skyboxes that use the same files instead, and it is managed by
+///						the cache's budget.
+/// @param	mode		How the faces are loaded. If LOAD_PROGRESSIVELY, a preview of the faces is drawn until the full
+///						faces have been loaded in the background.
+/// @param	previewSize	Width and height of the preview faces if @a mode is LOAD_PROGRESSIVELY. If 1, each face of the
+///						preview is the average color of the face.
 /// @warning			This function may throw a <tt>std::runtime_error</tt>, or a <tt>std::bad_alloc</tt>.
+///
+/// @note	The faces are loaded into a cube map if cube maps are supported and the faces are square and have the same
+///			size and format. Otherwise, each face is loaded as a separate texture.
+///
+/// @note	Progressive loading requires cube maps. If they are not supported, the faces are loaded immediately.
 
-SkyBox::SkyBox( char const * fileName, unsigned faceMask/* = FACE_ALL_FACES*/ )
+SkyBox::SkyBox( char const *	fileName,
+				unsigned		faceMask	/* = FACE_ALL_FACES*/,
+				TextureCache *	pCache		/* = 0*/,
+				LoadMode		mode		/* = LOAD_IMMEDIATELY*/,
+				int				previewSize	/* = 8*/ )
+	: m_FaceMask( faceMask & FACE_ALL_FACES ),
+	m_CulledFaceCount( 0 ),
+	m_VertexBuffer( 0 ),
+	m_IndexBuffer( 0 ),
+	m_pCubeMap( 0 ),
+	m_pBackgroundLoad( 0 )
 {
-	assert( Glx::Extension::IsSupported( "GL_EXT_bgra" ) );
+	Initialize( fileName, false, pCache, mode, previewSize );
+}
 
-	for ( int face = 0; face < NUM_FACES; face++ )
-	{
-		if ( ( faceMask & ( 1 << face ) ) != 0 )
-		{
-			static GlObjects::TextureLoader	textureLoader;
-			static char const				aSuffixes[ NUM_FACES ][4] =
-											{
-												"_-Z",
-												"_+Z",
-												"_+X",
-												"_-X",
-												"_+Y",
-												"_-Y"
-											};
 
-			// Create the full name of the file
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	source		What the faces are loaded from. If SOURCE_PANORAMA, @a fileName is the name of an
+///						equirectangular panorama, which is converted into the faces by a PanoramaConverter.
+///						Otherwise, it is the base name of the face files (see the other constructor).
+/// @param	fileName	Name of the panorama, or base name of the face files
+/// @param	faceMask	Which faces of the skybox are to be drawn
+/// @param	pCache		Cache that the textures are loaded through. If 0, TextureCache::GetShared() is used.
+/// @param	mode		How the faces are loaded
+/// @param	previewSize	Width and height of the preview faces if @a mode is LOAD_PROGRESSIVELY
+/// @warning			This function may throw a <tt>std::runtime_error</tt>, or a <tt>std::bad_alloc</tt>. It throws a
+///						<tt>std::runtime_error</tt> if a panorama can't be loaded into a cube map.
+///
+/// @note	A panorama requires cube maps. The faces converted from it are cached on disk next to it, so only the first
+///			load of a panorama pays for the conversion.
 
-			char path[ _MAX_PATH ];
+SkyBox::SkyBox( Source			source,
+				char const *	fileName,
+				unsigned		faceMask	/* = FACE_ALL_FACES*/,
+				TextureCache *	pCache		/* = 0*/,
+				LoadMode		mode		/* = LOAD_IMMEDIATELY*/,
+				int				previewSize	/* = 8*/ )
+	: m_FaceMask( faceMask & FACE_ALL_FACES ),
+	m_CulledFaceCount( 0 ),
+	m_VertexBuffer( 0 ),
+	m_IndexBuffer( 0 ),
+	m_pCubeMap( 0 ),
+	m_pBackgroundLoad( 0 )
+{
+	Initialize( fileName, source == SOURCE_PANORAMA, pCache, mode, previewSize );
+}
 
-			SafeStrcpy( path, fileName, sizeof( path ) );
-			SafeStrcat( path, aSuffixes[ face ], sizeof( path ) );
-			SafeStrcat( path, ".tga", sizeof( path ) );
 
-			m_aTextures[ face ] = textureLoader.Load( path, GL_CLAMP ).release();
-		}
-		else
-		{
-			m_aTextures[ face ] = 0;
-		}
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @warning	This function may throw a <tt>std::runtime_error</tt>, or a <tt>std::bad_alloc</tt>.
+
+void SkyBox::Initialize( char const * fileName, bool bPanorama, TextureCache * pCache, LoadMode mode, int previewSize )
+{
+	assert( Glx::Extension::IsSupported( "GL_EXT_bgra" ) );
+
+	CreateBuffers();
+
+	if ( mode == LOAD_PROGRESSIVELY && StartBackgroundLoad( fileName, bPanorama, pCache, previewSize ) )
+	{
+		return;
+	}
+
+	if ( LoadCubeMap( fileName, bPanorama, pCache ) )
+	{
+		return;
+	}
+
+	if ( bPanorama )
+	{
+		throw std::runtime_error( "Unable to load the panorama into a cube map" );
 	}
+
+	LoadFaces( fileName, pCache );
 }
 
 
@@ -85,11 +640,25 @@ SkyBox::SkyBox( char const * fileName, unsigned faceMask/* = FACE_ALL_FACES*/ )
 /*																													*/
 /********************************************************************************************************************/
 
+/// The textures (or the cube map) are released. They are destroyed if no other skybox is using them. If the faces are
+/// still being loaded in the background, the load is finished first.
+
 SkyBox::~SkyBox()
 {
-	for ( int face = 0; face < NUM_FACES; face++ )
+	if ( m_pBackgroundLoad != 0 )
+	{
+		WaitForSingleObject( m_pBackgroundLoad->hThread, INFINITE );
+		CloseHandle( m_pBackgroundLoad->hThread );
+		delete m_pBackgroundLoad;
+	}
+
+	ReleaseCubeMap();
+
+	if ( m_VertexBuffer != 0 )
 	{
-		delete m_aTextures[ face ];
+		GLuint const	aBuffers[ 2 ]	= { m_VertexBuffer, m_IndexBuffer };
+
+		BufferObjects::s_glDeleteBuffersARB( 2, aBuffers );
 	}
 }
 
@@ -106,12 +675,17 @@ SkyBox::~SkyBox()
 ///				- glEnable( GL_DEPTH_TEST ), if @a bTestZ is @c true
 ///				- glDisable( GL_DEPTH_TEST ), if @a bTestZ is @c false
 ///				- glDepthMask( GL_FALSE )
-///				- glEnable( GL_TEXTURE_2D )
+///				- glEnable( GL_TEXTURE_2D ), if the skybox is not cube-mapped
 ///				- glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE )
+///				- glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 ) and glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 ), if
+///				  buffer objects are supported
 ///
 ///
 /// @note	Depth-testing is necessary only if you do not render the skybox first. Obviously, if depth-testing is
 ///			enabled, the depth-buffer must be initialized beforehand.
+///
+/// @note	Faces that are outside the view frustum are not drawn and their textures are not bound. The frustum is
+///			taken from the current projection and modelview matrices, so the camera must already be applied.
 
 
 void SkyBox::Apply( Glx::Camera const & camera, bool bTestZ/* = false*/ )
@@ -142,16 +716,19 @@ void SkyBox::Apply( Glx::Camera const & camera, bool bTestZ/* = false*/ )
 ///				- glEnable( GL_DEPTH_TEST ), if @a bTestZ is @c true
 ///				- glDisable( GL_DEPTH_TEST ), if @a bTestZ is @c false
 ///				- glDepthMask( GL_FALSE )
-///				- glEnable( GL_TEXTURE_2D )
+///				- glEnable( GL_TEXTURE_2D ), if the skybox is not cube-mapped
 ///				- glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE )
+///				- glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 ) and glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 ), if
+///				  buffer objects are supported
 ///
 /// @note	Depth-testing is necessary only if you do not render the skybox first. Obviously, if depth-testing is
 ///			enabled, the depth-buffer must be initialized beforehand.
+///
+/// @note	Faces that are outside the view frustum are not drawn and their textures are not bound. The frustum is
+///			taken from the current projection and modelview matrices, so the camera must already be applied.
 
 void SkyBox::Apply( Vector3 const & vp, float r, bool bTestZ/* = false*/ )
 {
-	glPushMatrix();
-
 	if ( bTestZ )
 	{
 		Glx::Enable( GL_DEPTH_TEST );
@@ -162,54 +739,792 @@ void SkyBox::Apply( Vector3 const & vp, float r, bool bTestZ/* = false*/ )
 	}
 	glDepthMask( GL_FALSE );
 
-	// The skybox is drawn as a scaled and tranlated unit cube
+	Draw( vp, r );
+}
 
-	glTranslatef( vp.m_X,  vp.m_Y, vp.m_Z );
-	glScalef( r, r, r );
 
-	Glx::Enable( GL_TEXTURE_2D );
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	camera	The camera for the scene
+///
+/// @note	This function sets the following states:
+///				- glEnable( GL_DEPTH_TEST )
+///				- glDepthMask( GL_FALSE )
+///				- glEnable( GL_TEXTURE_2D ), if the skybox is not cube-mapped
+///				- glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE )
+///				- glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 ) and glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 ), if
+///				  buffer objects are supported
+///
+/// @note	The depth function is set to GL_LEQUAL while the skybox is drawn, and then it is restored.
+///
+/// @note	The depth-buffer must be cleared to 1 and the rest of the scene must already be drawn.
+
+void SkyBox::ApplyAtFarPlane( Glx::Camera const & camera )
+{
+	ApplyAtFarPlane( camera.GetPosition() );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The skybox is drawn after the rest of the scene, so pixels that are already covered are rejected by the depth
+/// test before they are textured. The projection is altered so that the z of every vertex is equal to its w. That
+/// puts every fragment exactly on the far plane, and the box is never clipped by the near or far planes, so its size
+/// doesn't matter.
+///
+/// @param	vp	Location of the view point (the skybox is centered at this point)
+///
+/// @note	This function sets the following states:
+///				- glEnable( GL_DEPTH_TEST )
+///				- glDepthMask( GL_FALSE )
+///				- glEnable( GL_TEXTURE_2D ), if the skybox is not cube-mapped
+///				- glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE )
+///				- glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 ) and glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 ), if
+///				  buffer objects are supported
+///
+/// @note	The depth function is set to GL_LEQUAL while the skybox is drawn, and then it is restored.
+///
+/// @note	The depth-buffer must be cleared to 1 and the rest of the scene must already be drawn.
+
+void SkyBox::ApplyAtFarPlane( Vector3 const & vp )
+{
+	GLint	depthFunc;
+
+	glGetIntegerv( GL_DEPTH_FUNC, &depthFunc );
+
+	Glx::Enable( GL_DEPTH_TEST );
+	glDepthFunc( GL_LEQUAL );
+	glDepthMask( GL_FALSE );
+
+	// Copy the w row of the projection matrix to the z row (the matrix is column-major)
+
+	GLfloat	projection[ 16 ];
+
+	glGetFloatv( GL_PROJECTION_MATRIX, projection );
+
+	projection[  2 ] = projection[  3 ];
+	projection[  6 ] = projection[  7 ];
+	projection[ 10 ] = projection[ 11 ];
+	projection[ 14 ] = projection[ 15 ];
+
+	glMatrixMode( GL_PROJECTION );
+	glPushMatrix();
+	glLoadMatrixf( projection );
+	glMatrixMode( GL_MODELVIEW );
+
+	Draw( vp, 1.f );
+
+	glMatrixMode( GL_PROJECTION );
+	glPopMatrix();
+	glMatrixMode( GL_MODELVIEW );
+
+	glDepthFunc( depthFunc );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function draws what a planar reflector shows of the sky, using the camera's view rather than a reflected
+/// one. If the skybox is cube-mapped, a single quad covering the viewport is drawn at the far plane, and the cube map
+/// is looked up in the direction of each corner's eye ray reflected by the plane, so the box is not drawn at all.
+/// Otherwise, the box is reflected by the plane and drawn with ApplyAtFarPlane().
+///
+/// Drawn before a reflection pass, it fills the background of the reflection, so the reflection pass does not need
+/// to draw the sky again.
+///
+/// @param	plane	The reflection plane (for example, Reflection::m_Plane)
+///
+/// @note	This function sets the following states:
+///				- glEnable( GL_DEPTH_TEST )
+///				- glDepthMask( GL_FALSE )
+///				- glEnable( GL_TEXTURE_2D ), if the skybox is not cube-mapped
+///				- glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE )
+///				- glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 ) and glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 ), if
+///				  buffer objects are supported and the skybox is not cube-mapped
+///
+/// @note	The depth function is set to GL_LEQUAL while the sky is drawn, and then it is restored. If the skybox is
+///			not cube-mapped, the front face is reversed while the reflected box is drawn, and then it is restored.
+///
+/// @note	The current projection must be a perspective projection and the current modelview must be the camera's
+///			view, without the reflection. The depth-buffer must be cleared to 1.
+
+void SkyBox::ApplyReflected( Plane const & plane )
+{
+	// Swap in the full faces if they have finished loading
+
+	if ( m_pBackgroundLoad != 0 )
+	{
+		FinishBackgroundLoad();
+	}
+
+	if ( !IsCubeMapped() )
+	{
+		// Reflect the world and draw the box centered on the view point. The reflection reverses the winding order.
+
+		GLint	frontFace;
+
+		glGetIntegerv( GL_FRONT_FACE, &frontFace );
+
+		glMatrixMode( GL_MODELVIEW );
+		glPushMatrix();
+		glMultMatrixf( &Matrix44( plane.GetReflectionMatrix() ).m_M[0][0] );
+		glFrontFace( ( frontFace == GL_CCW ) ? GL_CW : GL_CCW );
+
+		ApplyAtFarPlane( GetViewPoint() );
+
+		glFrontFace( frontFace );
+		glPopMatrix();
+
+		return;
+	}
+
+	CubeMapTexture * const	pCubeMap	= GetCubeMap();
+
+	if ( pCubeMap == 0 )
+	{
+		return;
+	}
+
+	GLint	depthFunc;
+
+	glGetIntegerv( GL_DEPTH_FUNC, &depthFunc );
+
+	Glx::Enable( GL_DEPTH_TEST );
+	glDepthFunc( GL_LEQUAL );
+	glDepthMask( GL_FALSE );
+
+	static GLfloat const	aCorners[ 4 ][ 2 ]	= { { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+
+	GLfloat	projection[ 16 ];
+	GLfloat	modelView[ 16 ];
+
+	glGetFloatv( GL_PROJECTION_MATRIX, projection );
+	glGetFloatv( GL_MODELVIEW_MATRIX, modelView );
+
+	// Find the lookup direction of each corner. The eye ray through the corner at z = -1 comes from the projection,
+	// it is rotated into the world by the transpose of the modelview's upper-left 3x3, and then it is reflected by
+	// the plane. The directions are linear across the screen, so interpolating them between the corners is exact.
+
+	Vector3 const &	n	= plane.m_N;
+	GLfloat			aDirections[ 4 ][ 3 ];
+
+	for ( int i = 0; i < 4; i++ )
+	{
+		GLfloat const	e[ 3 ]	=
+		{
+			( aCorners[i][0] + projection[8] ) / projection[0],
+			( aCorners[i][1] + projection[9] ) / projection[5],
+			-1.f
+		};
+
+		GLfloat	d[ 3 ];
+
+		for ( int k = 0; k < 3; k++ )
+		{
+			d[k] = modelView[k*4+0] * e[0] + modelView[k*4+1] * e[1] + modelView[k*4+2] * e[2];
+		}
+
+		GLfloat const	dn	= d[0] * n.m_X + d[1] * n.m_Y + d[2] * n.m_Z;
+
+		aDirections[i][0] = d[0] - 2.f * dn * n.m_X;
+		aDirections[i][1] = d[1] - 2.f * dn * n.m_Y;
+		aDirections[i][2] = d[2] - 2.f * dn * n.m_Z;
+	}
+
+	// Draw the quad in normalized device coordinates, on the far plane
+
+	glMatrixMode( GL_PROJECTION );
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode( GL_MODELVIEW );
+	glPushMatrix();
+	glLoadIdentity();
+
 	glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
+	Glx::Enable( GL_TEXTURE_CUBE_MAP_ARB );
+	pCubeMap->Apply();
+
+	glBegin( GL_QUADS );
+	for ( int i = 0; i < 4; i++ )
+	{
+		glTexCoord3fv( aDirections[i] );
+		glVertex3f( aCorners[i][0], aCorners[i][1], 1.f );
+	}
+	glEnd();
+
+	Glx::Disable( GL_TEXTURE_CUBE_MAP_ARB );
+
+	glPopMatrix();
+	glMatrixMode( GL_PROJECTION );
+	glPopMatrix();
+	glMatrixMode( GL_MODELVIEW );
+
+	glDepthFunc( depthFunc );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void SkyBox::Draw( Vector3 const & vp, float r )
+{
+	// Swap in the full faces if they have finished loading
+
+	if ( m_pBackgroundLoad != 0 )
+	{
+		FinishBackgroundLoad();
+	}
+
+	glPushMatrix();
+
+	// The skybox is drawn as a scaled and tranlated unit cube
+
+	glTranslatef( vp.m_X,  vp.m_Y, vp.m_Z );
+	glScalef( r, r, r );
+
+	// Skip the faces that are outside the view frustum
 
-	static GLfloat const aTexCoords[ NUM_FACES ][ 4 ][ 2 ] =
+	unsigned const	faces	= m_FaceMask & FindVisibleFaces();
+
+	m_CulledFaceCount = 0;
+	for ( int face = 0; face < NUM_FACES; face++ )
+	{
+		if ( ( ( m_FaceMask & ~faces ) & ( 1 << face ) ) != 0 )
+		{
+			++m_CulledFaceCount;
+		}
+	}
+
+	if ( faces == 0 )
 	{
-		{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// -Z
-		{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// +Z
-		{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// +X
-		{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// -X
-		{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	},	// +Y
-		{	{ 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }	}	// -Y
-	};
+		glPopMatrix();
+		return;
+	}
+
+	glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
+
+	// If the geometry is in buffer objects, then the array addresses are offsets into the buffers. Otherwise, they
+	// are the addresses of the separate arrays in client memory.
+
+	void const *		pVertices	= s_aVertices;
+	void const *		pTexCoords	= s_aTexCoords;
+	GLushort const *	pIndexes	= s_aIndexes;
 
-	static GLfloat const aVertices[ NUM_FACES ][ 4 ][ 3 ] =
+	if ( m_VertexBuffer != 0 )
 	{
-		{	{ -1.f, -1.f, -1.f }, {  1.f, -1.f, -1.f }, {  1.f,  1.f, -1.f }, { -1.f,  1.f, -1.f }	},	// -Z
-		{	{ -1.f,  1.f,  1.f }, {  1.f,  1.f,  1.f }, {  1.f, -1.f,  1.f }, { -1.f, -1.f,  1.f }	},	// +Z
-		{	{  1.f,  1.f, -1.f }, {  1.f, -1.f, -1.f }, {  1.f, -1.f,  1.f }, {  1.f,  1.f,  1.f }	},	// +X
-		{	{ -1.f, -1.f, -1.f }, { -1.f,  1.f, -1.f }, { -1.f,  1.f,  1.f }, { -1.f, -1.f,  1.f }	},	// -X
-		{	{ -1.f,  1.f, -1.f }, {  1.f,  1.f, -1.f }, {  1.f,  1.f,  1.f }, { -1.f,  1.f,  1.f }	},	// +Y
-		{	{  1.f, -1.f, -1.f }, { -1.f, -1.f, -1.f }, { -1.f, -1.f,  1.f }, {  1.f, -1.f,  1.f }	},	// -Y
-	};
+		BufferObjects::s_glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_VertexBuffer );
+		BufferObjects::s_glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBuffer );
+		pVertices	= reinterpret_cast< void const * >( VERTEX_OFFSET );
+		pTexCoords	= reinterpret_cast< void const * >( TEXCOORD_OFFSET );
+		pIndexes	= 0;
+	}
 
 	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
 	glEnableClientState( GL_VERTEX_ARRAY );
-	glTexCoordPointer( 2, GL_FLOAT, 2 * sizeof( GLfloat ), aTexCoords );
-	glVertexPointer( 3, GL_FLOAT, 3 * sizeof( GLfloat ), aVertices );
+	glVertexPointer( 3, GL_FLOAT, 3 * sizeof( GLfloat ), pVertices );
 
-	for ( int face = 0; face < NUM_FACES; face++ )
+	if ( IsCubeMapped() )
+	{
+		// The direction of each corner from the center is its cube map texture coordinate. Consecutive faces are
+		// drawn together. If the cube map was evicted and can't be reloaded, nothing is drawn.
+
+		CubeMapTexture * const	pCubeMap	= GetCubeMap();
+
+		if ( pCubeMap != 0 )
+		{
+			Glx::Enable( GL_TEXTURE_CUBE_MAP_ARB );
+			pCubeMap->Apply();
+
+			glTexCoordPointer( 3, GL_FLOAT, 3 * sizeof( GLfloat ), pVertices );
+
+			int face = 0;
+			while ( face < NUM_FACES )
+			{
+				if ( ( faces & ( 1 << face ) ) != 0 )
+				{
+					int const	first	= face;
+
+					while ( face < NUM_FACES && ( faces & ( 1 << face ) ) != 0 )
+					{
+						++face;
+					}
+
+					DrawFaces( pIndexes, first, face - first );
+				}
+				else
+				{
+					++face;
+				}
+			}
+
+			Glx::Disable( GL_TEXTURE_CUBE_MAP_ARB );
+		}
+	}
+	else
 	{
-		if ( m_aTextures[ face ] )
+		Glx::Enable( GL_TEXTURE_2D );
+
+		glTexCoordPointer( 2, GL_FLOAT, 2 * sizeof( GLfloat ), pTexCoords );
+
+		for ( int face = 0; face < NUM_FACES; face++ )
 		{
-			m_aTextures[ face ]->Apply();
+			if ( ( faces & ( 1 << face ) ) != 0 && m_aTextures[ face ].IsValid() )
+			{
+				m_aTextures[ face ].Apply();
 
-			glDrawArrays( GL_QUADS, face * 4, 4 );
+				DrawFaces( pIndexes, face, 1 );
+			}
 		}
 	}
 
 	glDisableClientState( GL_VERTEX_ARRAY );
 	glDisableClientState( GL_TEXTURE_COORD_ARRAY );
 
+	if ( m_VertexBuffer != 0 )
+	{
+		BufferObjects::s_glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+		BufferObjects::s_glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+	}
+
 	glPopMatrix();
 }
 
 
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The geometry never changes, so it is uploaded once. If buffer objects are not supported, the geometry is drawn
+/// from client memory instead.
+
+void SkyBox::CreateBuffers()
+{
+	if ( !Glx::Extension::IsSupported( "GL_ARB_vertex_buffer_object" ) || !BufferObjects::Initialize() )
+	{
+		return;
+	}
+
+	GLuint	aBuffers[ 2 ];
+
+	BufferObjects::s_glGenBuffersARB( 2, aBuffers );
+	m_VertexBuffer	= aBuffers[ 0 ];
+	m_IndexBuffer	= aBuffers[ 1 ];
+
+	BufferObjects::s_glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_VertexBuffer );
+	BufferObjects::s_glBufferDataARB( GL_ARRAY_BUFFER_ARB,
+									  sizeof( s_aVertices ) + sizeof( s_aTexCoords ), 0,
+									  GL_STATIC_DRAW_ARB );
+	BufferObjects::s_glBufferSubDataARB( GL_ARRAY_BUFFER_ARB, VERTEX_OFFSET, sizeof( s_aVertices ), s_aVertices );
+	BufferObjects::s_glBufferSubDataARB( GL_ARRAY_BUFFER_ARB, TEXCOORD_OFFSET, sizeof( s_aTexCoords ), s_aTexCoords );
+	BufferObjects::s_glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+
+	BufferObjects::s_glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBuffer );
+	BufferObjects::s_glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB,
+									  sizeof( s_aIndexes ), s_aIndexes,
+									  GL_STATIC_DRAW_ARB );
+	BufferObjects::s_glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If another skybox has already loaded a cube map of the same faces from the same files, it is shared instead.
+
+bool SkyBox::LoadCubeMap( char const * fileName, bool bPanorama, TextureCache * pCache )
+{
+	if ( !CubeMapTexture::IsSupported() || m_FaceMask == 0 )
+	{
+		return false;
+	}
+
+	try
+	{
+		std::string const	key	= MakeCubeMapKey( fileName, bPanorama, m_FaceMask );
+
+		if ( UseSharedCubeMap( key ) )
+		{
+			return true;
+		}
+
+		std::auto_ptr< Image >	aqFaces[ NUM_FACES ];
+
+		if ( !DecodeCubeFaces( fileName, bPanorama, m_FaceMask, aqFaces ) )
+		{
+			return false;
+		}
+
+		ShareCubeMap( key, fileName, bPanorama, pCache, aqFaces );
+	}
+	catch ( ... )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool SkyBox::UseSharedCubeMap( std::string const & key )
+{
+	SharedCubeMap::Map::iterator const	i	= SharedCubeMap::s_Map.find( key );
+
+	if ( i == SharedCubeMap::s_Map.end() )
+	{
+		return false;
+	}
+
+	++i->second->referenceCount;
+
+	ReleaseCubeMap();
+	m_pCubeMap = i->second;
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The cube map is registered with the budget of the cache (TextureCache::GetShared() if @a pCache is 0), so it can be
+/// evicted and reloaded like the textures in the cache.
+///
+/// @warning	This function may throw a <tt>std::runtime_error</tt>, or a <tt>std::bad_alloc</tt>.
+
+void SkyBox::ShareCubeMap( std::string const &			key,
+						   char const *					fileName,
+						   bool							bPanorama,
+						   TextureCache *				pCache,
+						   std::auto_ptr< Image > const	aqFaces[] )
+{
+	if ( pCache == 0 )
+	{
+		pCache = &TextureCache::GetShared();
+	}
+
+	std::auto_ptr< SharedCubeMap >	qShared( new SharedCubeMap );
+
+	qShared->fileName		= fileName;
+	qShared->bPanorama		= bPanorama;
+	qShared->faceMask		= m_FaceMask;
+	qShared->qCubeMap		= UploadCubeFaces( aqFaces );
+	qShared->referenceCount	= 1;
+
+	if ( pCache->GetBudget() != 0 )
+	{
+		pCache->GetBudget()->Add( qShared.get(), GetCubeFacesSize( aqFaces ) );
+	}
+
+	qShared->position = SharedCubeMap::s_Map.insert( SharedCubeMap::Map::value_type( key, qShared.get() ) ).first;
+
+	ReleaseCubeMap();
+	m_pCubeMap = qShared.release();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void SkyBox::ReleaseCubeMap()
+{
+	if ( m_pCubeMap != 0 )
+	{
+		if ( --m_pCubeMap->referenceCount == 0 )
+		{
+			SharedCubeMap::s_Map.erase( m_pCubeMap->position );
+			delete m_pCubeMap;
+		}
+
+		m_pCubeMap = 0;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// While the faces are loading in the background, the preview is returned. A shared cube map is marked as used by its
+/// budget, which reloads it if it has been evicted.
+
+CubeMapTexture * SkyBox::GetCubeMap()
+{
+	if ( m_pCubeMap == 0 )
+	{
+		return m_qPreview.get();
+	}
+
+	TextureBudget * const	pBudget	= m_pCubeMap->GetBudget();
+
+	if ( pBudget != 0 && !pBudget->Use( m_pCubeMap ) )
+	{
+		return 0;
+	}
+
+	return m_pCubeMap->qCubeMap.get();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @warning	This function may throw a <tt>std::runtime_error</tt>, or a <tt>std::bad_alloc</tt>.
+
+void SkyBox::LoadFaces( char const * fileName, TextureCache * pCache )
+{
+	if ( pCache == 0 )
+	{
+		pCache = &TextureCache::GetShared();
+	}
+
+	for ( int face = 0; face < NUM_FACES; face++ )
+	{
+		if ( ( m_FaceMask & ( 1 << face ) ) != 0 )
+		{
+			char path[ _MAX_PATH ];
+
+			MakeFaceFileName( path, sizeof( path ), fileName, face );
+
+			m_aTextures[ face ] = pCache->Load( path, GL_CLAMP );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A preview of each face is put in a small cube map right away, and a thread is started to decode the full faces.
+/// A face that can't be previewed (for example, because it is compressed) is gray until the full faces are loaded.
+/// The preview of a panorama is converted from a preview of the whole panorama. If another skybox has already loaded
+/// a cube map of the same faces from the same files, it is shared instead and there is nothing to load.
+///
+/// @return		@c false if cube maps are not supported, or the preview or the thread can't be created
+
+bool SkyBox::StartBackgroundLoad( char const * fileName, bool bPanorama, TextureCache * pCache, int previewSize )
+{
+	assert( previewSize > 0 );
+
+	if ( !CubeMapTexture::IsSupported() || m_FaceMask == 0 )
+	{
+		return false;
+	}
+
+	try
+	{
+		if ( UseSharedCubeMap( MakeCubeMapKey( fileName, bPanorama, m_FaceMask ) ) )
+		{
+			return true;
+		}
+
+		// Create the preview
+
+		std::auto_ptr< Image >	aqPreviews[ NUM_FACES ];
+
+		// The preview of a panorama is converted from a preview of the panorama
+
+		if ( bPanorama )
+		{
+			Image	panorama;
+
+			try
+			{
+				panorama.LoadTgaPreview( fileName, previewSize * 4 );
+			}
+			catch ( ... )
+			{
+			}
+
+			if ( !panorama.IsEmpty() )
+			{
+				PanoramaConverter const	converter( previewSize, PanoramaConverter::FILTER_BILINEAR, 1 );
+				std::auto_ptr< Image >	aqCubeFaces[ CubeMapTexture::NUM_FACES ];
+
+				converter.Convert( panorama, aqCubeFaces );
+
+				for ( int face = 0; face < NUM_FACES; face++ )
+				{
+					if ( ( m_FaceMask & ( 1 << face ) ) != 0 )
+					{
+						aqPreviews[ face ] = aqCubeFaces[ s_aCubeFaces[ face ] ];
+					}
+				}
+			}
+		}
+
+		for ( int face = 0; face < NUM_FACES; face++ )
+		{
+			if ( ( m_FaceMask & ( 1 << face ) ) != 0 )
+			{
+				Image	preview;
+
+				if ( !bPanorama )
+				{
+					char path[ _MAX_PATH ];
+
+					MakeFaceFileName( path, sizeof( path ), fileName, face );
+
+					try
+					{
+						preview.LoadTgaPreview( path, previewSize );
+					}
+					catch ( ... )
+					{
+					}
+
+					if ( !preview.IsEmpty() )
+					{
+						aqPreviews[ face ] = RemapToCubeFace( preview, face );
+					}
+				}
+
+				if ( aqPreviews[ face ].get() == 0 )
+				{
+					static uint8 const	aGray[ 4 ]	= { 128, 128, 128, 255 };
+
+					std::auto_ptr< Image >	qGray( new Image( previewSize, previewSize, GL_BGRA_EXT, 4 ) );
+
+					for ( size_t i = 0; i < qGray->GetSize(); i += 4 )
+					{
+						memcpy( qGray->GetBuffer() + i, aGray, 4 );
+					}
+
+					aqPreviews[ face ] = qGray;
+				}
+			}
+		}
+
+		m_qPreview = UploadCubeFaces( aqPreviews );
+
+		// Start loading the full faces
+
+		std::auto_ptr< BackgroundLoad >	qLoad( new BackgroundLoad );
+
+		qLoad->fileName		= fileName;
+		qLoad->bPanorama	= bPanorama;
+		qLoad->pCache		= pCache;
+		qLoad->faceMask		= m_FaceMask;
+		qLoad->bSucceeded	= false;
+		qLoad->hThread		= (HANDLE)_beginthreadex( NULL, 0, BackgroundLoadThread, qLoad.get(), 0, NULL );
+
+		if ( qLoad->hThread == 0 )
+		{
+			m_qPreview.reset();
+			return false;
+		}
+
+		m_pBackgroundLoad = qLoad.release();
+	}
+	catch ( ... )
+	{
+		m_qPreview.reset();
+		return false;
+	}
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If the background load has finished, the full faces replace the preview. If another skybox has loaded a cube map
+/// of the same faces in the meantime, that cube map is shared and the decoded faces are discarded. If the full faces
+/// can't share a cube map, they are loaded as separate textures instead, which stalls this thread once. If a panorama
+/// can't be loaded, the preview is kept.
+///
+/// @note	This function must be called by the thread that owns the GL context.
+
+void SkyBox::FinishBackgroundLoad()
+{
+	assert( m_pBackgroundLoad != 0 );
+
+	if ( WaitForSingleObject( m_pBackgroundLoad->hThread, 0 ) != WAIT_OBJECT_0 )
+	{
+		return;
+	}
+
+	std::auto_ptr< BackgroundLoad >	qLoad( m_pBackgroundLoad );
+
+	m_pBackgroundLoad = 0;
+	CloseHandle( qLoad->hThread );
+
+	try
+	{
+		if ( qLoad->bSucceeded )
+		{
+			std::string const	key	= MakeCubeMapKey( qLoad->fileName.c_str(), qLoad->bPanorama, qLoad->faceMask );
+
+			if ( !UseSharedCubeMap( key ) )
+			{
+				ShareCubeMap( key, qLoad->fileName.c_str(), qLoad->bPanorama, qLoad->pCache, qLoad->aqFaces );
+			}
+			m_qPreview.reset();
+		}
+		else if ( !qLoad->bPanorama )
+		{
+			LoadFaces( qLoad->fileName.c_str(), qLoad->pCache );
+			m_qPreview.reset();
+		}
+	}
+	catch ( ... )
+	{
+		// Keep drawing the preview
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+unsigned __stdcall SkyBox::BackgroundLoadThread( void * pArg )
+{
+	BackgroundLoad * const	pLoad	= static_cast< BackgroundLoad * >( pArg );
+
+	try
+	{
+		pLoad->bSucceeded = DecodeCubeFaces( pLoad->fileName.c_str(), pLoad->bPanorama, pLoad->faceMask,
+											pLoad->aqFaces );
+	}
+	catch ( ... )
+	{
+		pLoad->bSucceeded = false;
+	}
+
+	return 0;
+}
+
+
 } // namespace GlObjects
@@ -19,16 +19,35 @@
 
 #include "Glx/Texture.h"
 #include "Glx/Camera.h"
+#include "GlObjects/TextureLoader/TextureCache.h"
+#include "GlObjects/TextureLoader/CubeMapTexture.h"
+#include <memory>
+#include <string>
+
+class Plane;
 
 namespace GlObjects
 {
 
+class Image;
+
 
 /********************************************************************************************************************/
 /*																													*/
 /*																													*/
 /********************************************************************************************************************/
 
+/// A textured box centered on the view point.
+///
+/// If cube maps are supported, the faces are loaded into a single cube map and the box is drawn with one texture
+/// bind. Otherwise, each face is a separate texture loaded through a TextureCache.
+///
+/// Like the textures in a TextureCache, a cube map is shared by every skybox that draws the same faces from the same
+/// files, and it is managed by the budget of the cache (see TextureCache::GetBudget()) given to the first of them.
+///
+/// The faces can also be converted from a single equirectangular panorama (see PanoramaConverter) by constructing
+/// the skybox with SOURCE_PANORAMA, which requires cube maps.
+
 class SkyBox
 {
 public:
@@ -49,7 +68,31 @@ public:
 		NUM_FACES		= 6,
 	};
 
-	SkyBox( char const * filename, unsigned faceMask = FACE_ALL_FACES );
+	/// How the faces are loaded
+	enum LoadMode
+	{
+		LOAD_IMMEDIATELY,		///< The full faces are loaded before the constructor returns
+		LOAD_PROGRESSIVELY		///< A preview is loaded right away and the full faces are loaded in the background
+	};
+
+	/// What the faces are loaded from
+	enum Source
+	{
+		SOURCE_FACES,			///< A separate file for each face
+		SOURCE_PANORAMA			///< A single equirectangular panorama
+	};
+
+	SkyBox( char const *	filename,
+			unsigned		faceMask	= FACE_ALL_FACES,
+			TextureCache *	pCache		= 0,
+			LoadMode		mode		= LOAD_IMMEDIATELY,
+			int				previewSize	= 8 );
+	SkyBox( Source			source,
+			char const *	filename,
+			unsigned		faceMask	= FACE_ALL_FACES,
+			TextureCache *	pCache		= 0,
+			LoadMode		mode		= LOAD_IMMEDIATELY,
+			int				previewSize	= 8 );
 	~SkyBox();
 
 	/// Draws the skybox
@@ -58,9 +101,78 @@ public:
 	/// Draws the skybox
 	void Apply( Vector3 const & vp, float r, bool bTestZ = false );
 
+	/// Draws the skybox at the far plane, behind the rest of the scene
+	void ApplyAtFarPlane( Glx::Camera const & camera );
+
+	/// Draws the skybox at the far plane, behind the rest of the scene
+	void ApplyAtFarPlane( Vector3 const & vp );
+
+	/// Draws the skybox as reflected by a plane, at the far plane
+	void ApplyReflected( Plane const & plane );
+
+	/// Returns @c true if the faces are drawn from a single cube map
+	bool IsCubeMapped() const					{ return m_pCubeMap != 0 || m_qPreview.get() != 0; }
+
+	/// Returns @c true if the full faces are still being loaded in the background
+	bool IsLoading() const						{ return m_pBackgroundLoad != 0; }
+
+	/// Returns the number of faces that were skipped by the last Apply() because they were outside the view frustum
+	int GetCulledFaceCount() const				{ return m_CulledFaceCount; }
+
 private:
 
-	Glx::Texture *	m_aTextures[ NUM_FACES ];
+	struct BackgroundLoad;
+	struct SharedCubeMap;
+
+	// Prevent copying
+	SkyBox( SkyBox const & );
+	SkyBox & operator =( SkyBox const & );
+
+	// Uploads the geometry and loads the faces (common to the constructors)
+	void Initialize( char const * fileName, bool bPanorama, TextureCache * pCache, LoadMode mode, int previewSize );
+
+	// Uploads the geometry to buffer objects, if they are supported
+	void CreateBuffers();
+
+	// Draws the visible faces of the box
+	void Draw( Vector3 const & vp, float r );
+
+	// Loads the faces into a cube map, or shares one that is already loaded. Returns false if they can't be.
+	bool LoadCubeMap( char const * fileName, bool bPanorama, TextureCache * pCache );
+
+	// Shares the cube map with the given key if it is loaded. Returns false if it isn't.
+	bool UseSharedCubeMap( std::string const & key );
+
+	// Uploads decoded faces into a cube map that can be shared with other skyboxes
+	void ShareCubeMap( std::string const & key, char const * fileName, bool bPanorama, TextureCache * pCache,
+					   std::auto_ptr< Image > const aqFaces[] );
+
+	// Releases the shared cube map, destroying it if no other skybox is using it
+	void ReleaseCubeMap();
+
+	// Returns the cube map to draw (reloading it if it has been evicted), or 0 if there isn't one
+	CubeMapTexture * GetCubeMap();
+
+	// Loads the faces as separate textures
+	void LoadFaces( char const * fileName, TextureCache * pCache );
+
+	// Loads a preview and starts loading the full faces in the background. Returns false if they can't be.
+	bool StartBackgroundLoad( char const * fileName, bool bPanorama, TextureCache * pCache, int previewSize );
+
+	// Replaces the preview with the full faces if the background load has finished
+	void FinishBackgroundLoad();
+
+	// Background load thread entry point
+	static unsigned __stdcall BackgroundLoadThread( void * pArg );
+
+	unsigned							m_FaceMask;					///< Which faces are drawn
+	int									m_CulledFaceCount;			///< Faces culled by the last Apply()
+	GLuint								m_VertexBuffer;				///< Vertices and texture coordinates, or 0
+	GLuint								m_IndexBuffer;				///< Indexes of the corners of each face, or 0
+	SharedCubeMap *						m_pCubeMap;					///< The faces, if cube-mapped, or 0
+	std::auto_ptr< CubeMapTexture >		m_qPreview;					///< The preview, while the faces are loading
+	TextureCache::Handle				m_aTextures[ NUM_FACES ];	///< The faces, if not cube-mapped
+	BackgroundLoad *					m_pBackgroundLoad;			///< The load in progress, or 0
 };
 
 
@@ -0,0 +1,217 @@
+/** @file *//********************************************************************************************************
+
+                                                 ArrayTexture.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/ArrayTexture.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "ArrayTexture.h"
+
+#include "ScopedUnpackAlignment.h"
+
+#include "Glx/Glx.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace
+{
+
+// EXT_texture_array and OpenGL 1.2 definitions
+
+#if !defined( GL_TEXTURE_2D_ARRAY_EXT )
+#define GL_TEXTURE_2D_ARRAY_EXT		0x8C1A
+#endif
+
+#if !defined( GL_TEXTURE_MAX_LEVEL )
+#define GL_TEXTURE_MAX_LEVEL		0x813D
+#endif
+
+typedef void	( APIENTRY * TexImage3DProc )( GLenum target, GLint level, GLint internalFormat,
+											   GLsizei width, GLsizei height, GLsizei depth, GLint border,
+											   GLenum format, GLenum type, GLvoid const * pixels );
+typedef void	( APIENTRY * TexSubImage3DProc )( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+												  GLsizei width, GLsizei height, GLsizei depth,
+												  GLenum format, GLenum type, GLvoid const * pixels );
+
+TexImage3DProc		s_glTexImage3D		= 0;
+TexSubImage3DProc	s_glTexSubImage3D	= 0;
+
+// Gets the entry points. Returns false if they are not available.
+
+bool InitializeEntryPoints()
+{
+	if ( s_glTexImage3D == 0 )
+	{
+		s_glTexImage3D		= (TexImage3DProc)		wglGetProcAddress( "glTexImage3D" );
+		s_glTexSubImage3D	= (TexSubImage3DProc)	wglGetProcAddress( "glTexSubImage3D" );
+	}
+
+	if ( s_glTexImage3D == 0 )
+	{
+		s_glTexImage3D		= (TexImage3DProc)		wglGetProcAddress( "glTexImage3DEXT" );
+		s_glTexSubImage3D	= (TexSubImage3DProc)	wglGetProcAddress( "glTexSubImage3DEXT" );
+	}
+
+	return s_glTexImage3D != 0 && s_glTexSubImage3D != 0;
+}
+
+// Returns the internal format used for data in the specified format
+
+GLint GetInternalFormat( GLenum format )
+{
+	switch ( format )
+	{
+	case GL_LUMINANCE:			return GL_LUMINANCE8;
+	case GL_LUMINANCE_ALPHA:	return GL_LUMINANCE8_ALPHA8;
+	case GL_RGB:				return GL_RGB8;
+	case GL_BGR_EXT:			return GL_RGB8;
+	default:					return GL_RGBA8;
+	}
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	width			Width of level 0 of each layer
+/// @param	height			Height of level 0 of each layer
+/// @param	nLayers			Number of layers
+/// @param	format			Format of the data passed to SetLayer()
+/// @param	type			Type of the data passed to SetLayer()
+/// @param	nLevels			Number of mip levels, including level 0
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if texture arrays are not supported.
+
+ArrayTexture::ArrayTexture( int width, int height, int nLayers,
+							GLenum format, GLenum type,
+							int nLevels				/* = 1*/,
+							GLenum wrap				/* = GL_REPEAT*/,
+							GLenum minFiltering		/* = GL_LINEAR*/,
+							GLenum magFiltering		/* = GL_LINEAR*/,
+							GLuint id				/* = 0*/ )
+	: m_Width( width ),
+	m_Height( height ),
+	m_nLayers( nLayers ),
+	m_nLevels( nLevels ),
+	m_Format( format ),
+	m_Type( type ),
+	m_Id( id )
+{
+	assert( width > 0 && height > 0 );
+	assert( nLayers > 0 );
+	assert( nLevels > 0 );
+
+	if ( !IsSupported() ) throw std::runtime_error( "Texture arrays are not supported" );
+
+	if ( m_Id == 0 )
+	{
+		glGenTextures( 1, &m_Id );
+	}
+
+	glBindTexture( GL_TEXTURE_2D_ARRAY_EXT, m_Id );
+
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_S, wrap );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_T, wrap );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MIN_FILTER, minFiltering );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAG_FILTER, magFiltering );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAX_LEVEL, nLevels - 1 );
+
+	// Allocate the storage for every layer of every level. The data is uploaded later.
+
+	GLint const	internalFormat	= GetInternalFormat( format );
+	int			w				= width;
+	int			h				= height;
+
+	for ( int i = 0; i < nLevels; i++ )
+	{
+		s_glTexImage3D( GL_TEXTURE_2D_ARRAY_EXT, i, internalFormat, w, h, nLayers, 0, format, type, 0 );
+
+		w = ( w > 1 ) ? w / 2 : 1;
+		h = ( h > 1 ) ? h / 2 : 1;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+ArrayTexture::~ArrayTexture()
+{
+	glDeleteTextures( 1, &m_Id );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool ArrayTexture::IsSupported()
+{
+	return Glx::Extension::IsSupported( "GL_EXT_texture_array" ) && InitializeEntryPoints();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	level	Mip level
+/// @param	layer	Index of the layer
+/// @param	pData	Tightly-packed texels of the level, in the format and type given to the constructor
+
+void ArrayTexture::SetLayer( int level, int layer, void const * pData )
+{
+	assert( level >= 0 && level < m_nLevels );
+	assert( layer >= 0 && layer < m_nLayers );
+
+	int const	w	= std::max( m_Width >> level, 1 );
+	int const	h	= std::max( m_Height >> level, 1 );
+
+	ScopedUnpackAlignment	alignment;
+
+	glBindTexture( GL_TEXTURE_2D_ARRAY_EXT, m_Id );
+	s_glTexSubImage3D( GL_TEXTURE_2D_ARRAY_EXT, level, 0, 0, layer, w, h, 1, m_Format, m_Type, pData );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void ArrayTexture::Apply() const
+{
+	glBindTexture( GL_TEXTURE_2D_ARRAY_EXT, m_Id );
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,99 @@
+#if !defined( GLOBJECTS_ARRAYTEXTURE_H_INCLUDED )
+#define GLOBJECTS_ARRAYTEXTURE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  ArrayTexture.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/ArrayTexture.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <gl/gl.h>
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A 2D texture array (EXT_texture_array).
+///
+/// All of the layers have the same size and format, and they are bound together as a single texture. A shader
+/// selects a layer with the third texture coordinate, so drawing with many layers requires no extra binds. Texture
+/// arrays can only be sampled by shaders.
+///
+/// The storage for every layer and level is allocated when the texture is created, and the layers are uploaded one at
+/// a time with SetLayer().
+
+class ArrayTexture
+{
+public:
+
+	/// Constructor
+	ArrayTexture( int width, int height, int nLayers,
+				  GLenum format, GLenum type,
+				  int nLevels			= 1,
+				  GLenum wrap			= GL_REPEAT,
+				  GLenum minFiltering	= GL_LINEAR,
+				  GLenum magFiltering	= GL_LINEAR,
+				  GLuint id				= 0 );
+
+	/// Destructor
+	~ArrayTexture();
+
+	/// Returns @c true if texture arrays are supported by the current context
+	static bool IsSupported();
+
+	/// Uploads one level of one layer
+	void SetLayer( int level, int layer, void const * pData );
+
+	/// Binds the texture
+	void Apply() const;
+
+	/// Returns the width of level 0
+	int GetWidth() const						{ return m_Width; }
+
+	/// Returns the height of level 0
+	int GetHeight() const						{ return m_Height; }
+
+	/// Returns the number of layers
+	int GetLayerCount() const					{ return m_nLayers; }
+
+	/// Returns the number of mip levels
+	int GetLevelCount() const					{ return m_nLevels; }
+
+	/// Returns the texture id
+	GLuint GetId() const						{ return m_Id; }
+
+private:
+
+	// Prevent copying
+	ArrayTexture( ArrayTexture const & );
+	ArrayTexture & operator =( ArrayTexture const & );
+
+	int		m_Width;		///< Width of level 0
+	int		m_Height;		///< Height of level 0
+	int		m_nLayers;		///< Number of layers
+	int		m_nLevels;		///< Number of mip levels
+	GLenum	m_Format;		///< Format of the data
+	GLenum	m_Type;			///< Type of the data
+	GLuint	m_Id;			///< Texture id
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_ARRAYTEXTURE_H_INCLUDED )
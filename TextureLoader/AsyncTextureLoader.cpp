@@ -0,0 +1,559 @@
+/** @file *//********************************************************************************************************
+
+                                               AsyncTextureLoader.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/AsyncTextureLoader.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "AsyncTextureLoader.h"
+
+#include "Image.h"
+#include "MipMapGenerator.h"
+#include "TextureLoader.h"
+
+#include "Glx/Texture.h"
+#include "Glx/MipMappedTexture.h"
+#include "Misc/auto_array_ptr.h"
+
+#include <cassert>
+#include <memory>
+#include <new>
+#include <process.h>
+#include <stdexcept>
+#include <string>
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A request to load a texture
+
+struct AsyncTexture::Job
+{
+	std::string					fileName;		///< Name of the file to load
+	bool						bMipMapped;		///< If @c true, the texture is mip-mapped
+	GLenum						wrap;			///< Wrap mode
+	GLenum						minFiltering;	///< Minification filter
+	GLenum						magFiltering;	///< Magnification filter
+	AsyncTexture *				pTarget;		///< The texture being loaded, or 0 if it has been destroyed
+	std::auto_ptr< Image >		qImage;			///< The decoded image, or 0 if it has not been or could not be decoded
+	auto_array_ptr< uint8 >		qaMipChain;		///< Mip levels 1 through n (if mip-mapped)
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+AsyncTexture::AsyncTexture( AsyncTextureLoader * pLoader, Glx::Texture * pPlaceholder )
+	: m_pLoader( pLoader ),
+	m_pPlaceholder( pPlaceholder ),
+	m_pJob( 0 ),
+	m_pTexture( 0 ),
+	m_pMipMappedTexture( 0 ),
+	m_IsDone( false )
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If the texture has not been loaded yet, the load is cancelled.
+
+AsyncTexture::~AsyncTexture()
+{
+	if ( m_pJob != 0 )
+	{
+		m_pLoader->Cancel( this );
+	}
+
+	delete m_pMipMappedTexture;
+	delete m_pTexture;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @note	If the texture has not been uploaded yet (or failed to load), the loader's placeholder texture is bound
+///			instead. If there is no placeholder, nothing is bound. The texture keeps its own copy of the placeholder
+///			pointer, so this is safe after the loader has been destroyed.
+
+void AsyncTexture::Apply() const
+{
+	if ( m_pTexture != 0 )
+	{
+		m_pTexture->Apply();
+	}
+	else if ( m_pMipMappedTexture != 0 )
+	{
+		m_pMipMappedTexture->Apply();
+	}
+	else if ( m_pPlaceholder != 0 )
+	{
+		m_pPlaceholder->Apply();
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pPlaceholder		Texture bound by AsyncTexture::Apply() until the real texture is ready. May be 0. The
+///								loader does not take ownership, and the placeholder must remain valid until every
+///								texture returned by the loader has been destroyed.
+/// @param	nThreads			Number of worker threads. If 0, one thread per processor is created.
+/// @param	maxPendingUploads	Maximum number of decoded images waiting to be uploaded. Workers wait when the upload
+///								queue is full, which limits the amount of memory used by decoded images.
+///
+/// @warning	This function may throw a <tt>std::runtime_error</tt> or a <tt>std::bad_alloc</tt>.
+
+AsyncTextureLoader::AsyncTextureLoader( Glx::Texture *	pPlaceholder		/* = 0*/,
+										int				nThreads			/* = 0*/,
+										int				maxPendingUploads	/* = 8*/ )
+	: m_pPlaceholder( pPlaceholder ),
+	m_hShutdown( NULL ),
+	m_hRequestsAvailable( NULL ),
+	m_hUploadSlots( NULL ),
+	m_PendingCount( 0 )
+{
+	assert( maxPendingUploads > 0 );
+
+	if ( nThreads <= 0 )
+	{
+		SYSTEM_INFO	info;
+		GetSystemInfo( &info );
+		nThreads = info.dwNumberOfProcessors;
+	}
+
+	InitializeCriticalSection( &m_Lock );
+
+	m_hShutdown				= CreateEvent( NULL, TRUE, FALSE, NULL );
+	m_hRequestsAvailable	= CreateSemaphore( NULL, 0, LONG_MAX, NULL );
+	m_hUploadSlots			= CreateSemaphore( NULL, maxPendingUploads, maxPendingUploads, NULL );
+
+	if ( m_hShutdown == NULL || m_hRequestsAvailable == NULL || m_hUploadSlots == NULL )
+	{
+		Shutdown();
+		DeleteCriticalSection( &m_Lock );
+		throw std::runtime_error( "Unable to create synchronization objects" );
+	}
+
+	// Start the workers
+
+	m_WorkerThreads.reserve( nThreads );
+
+	for ( int i = 0; i < nThreads; i++ )
+	{
+		HANDLE const	hThread	= (HANDLE)_beginthreadex( NULL, 0, WorkerThread, this, 0, NULL );
+
+		if ( hThread == 0 )
+		{
+			Shutdown();
+			DeleteCriticalSection( &m_Lock );
+			throw std::runtime_error( "Unable to create worker thread" );
+		}
+
+		m_WorkerThreads.push_back( hThread );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Any textures still being loaded are left in the failed state.
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+	Shutdown();
+	DeleteCriticalSection( &m_Lock );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void AsyncTextureLoader::Shutdown()
+{
+	// Stop the workers
+
+	if ( m_hShutdown != NULL )
+	{
+		SetEvent( m_hShutdown );
+	}
+
+	for ( std::vector< HANDLE >::iterator pThread = m_WorkerThreads.begin(); pThread != m_WorkerThreads.end(); ++pThread )
+	{
+		WaitForSingleObject( *pThread, INFINITE );
+		CloseHandle( *pThread );
+	}
+	m_WorkerThreads.clear();
+
+	// Abandon any outstanding requests
+
+	std::deque< Job * > * const	apQueues[ 2 ]	= { &m_Requests, &m_Uploads };
+
+	for ( int i = 0; i < 2; i++ )
+	{
+		std::deque< Job * > &	queue	= *apQueues[ i ];
+
+		for ( std::deque< Job * >::iterator ppJob = queue.begin(); ppJob != queue.end(); ++ppJob )
+		{
+			AsyncTexture * const	pTarget	= ( *ppJob )->pTarget;
+
+			if ( pTarget != 0 )
+			{
+				pTarget->m_pJob		= 0;
+				pTarget->m_pLoader	= 0;
+				pTarget->m_IsDone	= true;
+			}
+
+			delete *ppJob;
+		}
+		queue.clear();
+	}
+
+	if ( m_hUploadSlots != NULL )			CloseHandle( m_hUploadSlots );
+	if ( m_hRequestsAvailable != NULL )		CloseHandle( m_hRequestsAvailable );
+	if ( m_hShutdown != NULL )				CloseHandle( m_hShutdown );
+	m_hUploadSlots			= NULL;
+	m_hRequestsAvailable	= NULL;
+	m_hShutdown				= NULL;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The file format must be 24-bit or 32-bit truecolor, or 8-bit or 16-bit grayscale, and may be run-length encoded.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+///
+/// @return		The texture being loaded. The caller owns it and must delete it on the GL thread.
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+AsyncTexture * AsyncTextureLoader::Load( char const *	sFileName,
+										 GLenum			wrap			/* = GL_REPEAT*/,
+										 GLenum			minFiltering	/* = GL_LINEAR*/,
+										 GLenum			magFiltering	/* = GL_LINEAR*/ )
+{
+	return Request( sFileName, false, wrap, minFiltering, magFiltering );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The file format must be 24-bit or 32-bit truecolor, or 8-bit or 16-bit grayscale, and may be run-length encoded.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+///
+/// @return		The texture being loaded. The caller owns it and must delete it on the GL thread.
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+AsyncTexture * AsyncTextureLoader::LoadMipMapped( char const *	sFileName,
+												  GLenum		wrap			/* = GL_REPEAT*/,
+												  GLenum		minFiltering	/* = GL_LINEAR_MIPMAP_LINEAR*/,
+												  GLenum		magFiltering	/* = GL_LINEAR*/ )
+{
+	return Request( sFileName, true, wrap, minFiltering, magFiltering );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Each call uploads the decoded images that are waiting in the queue with TextureLoader::Upload() or
+/// TextureLoader::UploadMipMapped(). The mip levels have already been built by the worker threads, so they are only
+/// uploaded here. Textures that fail to load are marked as done and failed.
+///
+/// @param	maxUploads	Maximum number of textures to upload in this call. If negative, there is no limit.
+///
+/// @return		The number of textures that were completed
+///
+/// @note	This function must be called by the thread that owns the GL context.
+
+int AsyncTextureLoader::Pump( int maxUploads/* = -1*/ )
+{
+	int	count	= 0;
+
+	while ( maxUploads < 0 || count < maxUploads )
+	{
+		Job *	pJob	= 0;
+
+		EnterCriticalSection( &m_Lock );
+		if ( !m_Uploads.empty() )
+		{
+			pJob = m_Uploads.front();
+			m_Uploads.pop_front();
+		}
+		LeaveCriticalSection( &m_Lock );
+
+		if ( pJob == 0 )
+		{
+			break;
+		}
+
+		// Textures can only be destroyed on this thread, so the target can't go away during the upload
+
+		AsyncTexture * const	pTarget	= pJob->pTarget;
+
+		if ( pTarget != 0 )
+		{
+			Image const * const		pImage	= pJob->qImage.get();
+
+			if ( pImage != 0 )
+			{
+				if ( pJob->bMipMapped )
+				{
+					pTarget->m_pMipMappedTexture = TextureLoader::UploadMipMapped( *pImage,
+																				   pJob->qaMipChain.get(),
+																				   pJob->wrap,
+																				   pJob->minFiltering,
+																				   pJob->magFiltering ).release();
+				}
+				else
+				{
+					pTarget->m_pTexture = TextureLoader::Upload( *pImage,
+																 pJob->wrap,
+																 pJob->minFiltering,
+																 pJob->magFiltering ).release();
+				}
+			}
+
+			EnterCriticalSection( &m_Lock );
+			pTarget->m_pJob		= 0;
+			pTarget->m_pLoader	= 0;
+			pTarget->m_IsDone	= true;
+			LeaveCriticalSection( &m_Lock );
+
+			++count;
+		}
+
+		delete pJob;
+
+		EnterCriticalSection( &m_Lock );
+		--m_PendingCount;
+		LeaveCriticalSection( &m_Lock );
+
+		// Make room for another decoded image
+
+		ReleaseSemaphore( m_hUploadSlots, 1, NULL );
+	}
+
+	return count;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+int AsyncTextureLoader::GetPendingCount() const
+{
+	int	count;
+
+	EnterCriticalSection( &m_Lock );
+	count = m_PendingCount;
+	LeaveCriticalSection( &m_Lock );
+
+	return count;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+AsyncTexture * AsyncTextureLoader::Request( char const *	sFileName,
+											bool			bMipMapped,
+											GLenum			wrap,
+											GLenum			minFiltering,
+											GLenum			magFiltering )
+{
+	std::auto_ptr< AsyncTexture >	qTexture( new AsyncTexture( this, m_pPlaceholder ) );
+	if ( qTexture.get() == 0 ) throw std::bad_alloc();
+
+	Job * const	pJob	= new Job;
+	if ( pJob == 0 ) throw std::bad_alloc();
+
+	pJob->fileName		= sFileName;
+	pJob->bMipMapped	= bMipMapped;
+	pJob->wrap			= wrap;
+	pJob->minFiltering	= minFiltering;
+	pJob->magFiltering	= magFiltering;
+	pJob->pTarget		= qTexture.get();
+
+	qTexture->m_pJob = pJob;
+
+	EnterCriticalSection( &m_Lock );
+	m_Requests.push_back( pJob );
+	++m_PendingCount;
+	LeaveCriticalSection( &m_Lock );
+
+	ReleaseSemaphore( m_hRequestsAvailable, 1, NULL );
+
+	return qTexture.release();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void AsyncTextureLoader::Cancel( AsyncTexture * pTexture )
+{
+	EnterCriticalSection( &m_Lock );
+	if ( pTexture->m_pJob != 0 )
+	{
+		pTexture->m_pJob->pTarget = 0;
+		pTexture->m_pJob = 0;
+	}
+	LeaveCriticalSection( &m_Lock );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+unsigned __stdcall AsyncTextureLoader::WorkerThread( void * pArg )
+{
+	static_cast< AsyncTextureLoader * >( pArg )->Work();
+
+	return 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void AsyncTextureLoader::Work()
+{
+	// Each worker builds mip levels with a generator of its own. The workers already run in parallel, so the
+	// generator doesn't need threads of its own, and it is kept for every image rather than created for each one.
+
+	MipMapGenerator	generator( TextureLoader::GetMipMapFilter(), TextureLoader::IsGammaCorrectMipMaps(), 1 );
+
+	for ( ;; )
+	{
+		// Wait for a request
+
+		HANDLE const	ahRequest[ 2 ]	= { m_hShutdown, m_hRequestsAvailable };
+
+		if ( WaitForMultipleObjects( 2, ahRequest, FALSE, INFINITE ) != WAIT_OBJECT_0 + 1 )
+		{
+			break;
+		}
+
+		// Wait for room in the upload queue. This bounds the number of decoded images in memory.
+
+		HANDLE const	ahSlot[ 2 ]		= { m_hShutdown, m_hUploadSlots };
+
+		if ( WaitForMultipleObjects( 2, ahSlot, FALSE, INFINITE ) != WAIT_OBJECT_0 + 1 )
+		{
+			break;
+		}
+
+		Job *	pJob;
+		bool	bCancelled;
+
+		EnterCriticalSection( &m_Lock );
+		pJob = m_Requests.front();
+		m_Requests.pop_front();
+		bCancelled = ( pJob->pTarget == 0 );
+		LeaveCriticalSection( &m_Lock );
+
+		// Decode the image (unless nobody wants it anymore)
+
+		if ( !bCancelled )
+		{
+			pJob->qImage = TextureLoader::Decode( pJob->fileName.c_str() );
+
+			// Build the mip levels here rather than on the GL thread
+
+			if ( pJob->bMipMapped && pJob->qImage.get() != 0 )
+			{
+				try
+				{
+					Image const &	image		= *pJob->qImage;
+					size_t const	chainSize	= MipMapGenerator::GetChainSize( image.GetWidth(),
+																				 image.GetHeight(),
+																				 image.GetTexelSize() );
+
+					pJob->qaMipChain = auto_array_ptr< uint8 >( new uint8[ chainSize + 1 ] );
+					if ( pJob->qaMipChain.get() == 0 ) throw std::bad_alloc();
+
+					generator.SetFilter( TextureLoader::GetMipMapFilter() );
+					generator.SetGammaCorrect( TextureLoader::IsGammaCorrectMipMaps() );
+					generator.BuildChain( image.GetData(), image.GetWidth(), image.GetHeight(), image.GetTexelSize(),
+										  pJob->qaMipChain.get() );
+				}
+				catch ( ... )
+				{
+					pJob->qImage.reset();
+				}
+			}
+		}
+
+		// Hand it to the GL thread
+
+		EnterCriticalSection( &m_Lock );
+		m_Uploads.push_back( pJob );
+		LeaveCriticalSection( &m_Lock );
+	}
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,174 @@
+#if !defined( GLOBJECTS_ASYNCTEXTURELOADER_H_INCLUDED )
+#define GLOBJECTS_ASYNCTEXTURELOADER_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                AsyncTextureLoader.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/AsyncTextureLoader.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <deque>
+#include <vector>
+#include <gl/gl.h>
+
+namespace Glx
+{
+	class Texture;
+	class MipMappedTexture;
+}
+
+namespace GlObjects
+{
+
+class AsyncTextureLoader;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A texture that is being loaded by an AsyncTextureLoader.
+///
+/// Until the texture has been uploaded, Apply() applies the loader's placeholder texture instead.
+
+class AsyncTexture
+{
+	friend class AsyncTextureLoader;
+
+public:
+
+	/// Destructor
+	~AsyncTexture();
+
+	/// Returns @c true if the texture has been loaded (or has failed to load)
+	bool IsDone() const								{ return m_IsDone; }
+
+	/// Returns @c true if the texture failed to load
+	bool IsFailed() const							{ return m_IsDone && m_pTexture == 0 && m_pMipMappedTexture == 0; }
+
+	/// Returns the loaded texture, or 0 if it has not been loaded or is mip-mapped
+	Glx::Texture * GetTexture() const				{ return m_pTexture; }
+
+	/// Returns the loaded mip-mapped texture, or 0 if it has not been loaded or is not mip-mapped
+	Glx::MipMappedTexture * GetMipMappedTexture() const	{ return m_pMipMappedTexture; }
+
+	/// Binds the loaded texture, or the placeholder if it is not ready
+	void Apply() const;
+
+private:
+
+	struct Job;
+
+	// Constructor
+	AsyncTexture( AsyncTextureLoader * pLoader, Glx::Texture * pPlaceholder );
+
+	// Prevent copying
+	AsyncTexture( AsyncTexture const & );
+	AsyncTexture & operator =( AsyncTexture const & );
+
+	AsyncTextureLoader *	m_pLoader;				///< The loader, or 0 once the load is complete
+	Glx::Texture *			m_pPlaceholder;			///< Bound in place of the texture until it is ready, or 0
+	Job *					m_pJob;					///< The pending job, or 0 if done
+	Glx::Texture *			m_pTexture;				///< The loaded texture (if not mip-mapped)
+	Glx::MipMappedTexture *	m_pMipMappedTexture;	///< The loaded texture (if mip-mapped)
+	bool					m_IsDone;				///< @c true if the load has completed
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Loads TGA files into textures without blocking the GL thread.
+///
+/// The files are read and decoded by a pool of worker threads with TextureLoader::Decode(), so they are loaded with
+/// the TextureLoader's current options. The workers also build the mip levels of mip-mapped textures, using the
+/// TextureLoader's mip map filter. Decoded images are placed in a bounded queue and are uploaded by Pump(), which
+/// must be called periodically by the thread that owns the GL context.
+
+class AsyncTextureLoader
+{
+	friend class AsyncTexture;
+
+public:
+
+	/// Constructor
+	AsyncTextureLoader( Glx::Texture * pPlaceholder	= 0,
+						int nThreads				= 0,
+						int maxPendingUploads		= 8 );
+
+	/// Destructor
+	~AsyncTextureLoader();
+
+	/// Starts loading a texture
+	AsyncTexture * Load( char const * sFileName,
+						 GLenum wrap			= GL_REPEAT,
+						 GLenum minFiltering	= GL_LINEAR,
+						 GLenum magFiltering	= GL_LINEAR );
+
+	/// Starts loading a mip-mapped texture
+	AsyncTexture * LoadMipMapped( char const * sFileName,
+								  GLenum wrap			= GL_REPEAT,
+								  GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
+								  GLenum magFiltering	= GL_LINEAR );
+
+	/// Uploads decoded textures. Must be called by the GL thread.
+	int Pump( int maxUploads = -1 );
+
+	/// Returns the number of textures that have been requested but not yet uploaded
+	int GetPendingCount() const;
+
+	/// Returns the placeholder texture
+	Glx::Texture * GetPlaceholder() const	{ return m_pPlaceholder; }
+
+private:
+
+	typedef AsyncTexture::Job Job;
+
+	// Prevent copying
+	AsyncTextureLoader( AsyncTextureLoader const & );
+	AsyncTextureLoader & operator =( AsyncTextureLoader const & );
+
+	// Queues a request
+	AsyncTexture * Request( char const * sFileName, bool bMipMapped, GLenum wrap, GLenum minFiltering, GLenum magFiltering );
+
+	// Detaches a texture from its job (called when the texture is destroyed before it is loaded)
+	void Cancel( AsyncTexture * pTexture );
+
+	// Stops the workers and abandons any outstanding requests
+	void Shutdown();
+
+	// Worker thread entry point
+	static unsigned __stdcall WorkerThread( void * pArg );
+
+	// Worker thread loop
+	void Work();
+
+	Glx::Texture *			m_pPlaceholder;			///< Bound in place of a texture that is not ready
+	std::vector< HANDLE >	m_WorkerThreads;		///< The worker threads
+	HANDLE					m_hShutdown;			///< Signaled when the workers must exit
+	HANDLE					m_hRequestsAvailable;	///< Counts the requests waiting to be decoded
+	HANDLE					m_hUploadSlots;			///< Counts the free slots in the upload queue
+	mutable CRITICAL_SECTION m_Lock;				///< Protects the queues and the job/texture links
+	std::deque< Job * >		m_Requests;				///< Requests waiting to be decoded
+	std::deque< Job * >		m_Uploads;				///< Decoded images waiting to be uploaded
+	int						m_PendingCount;			///< Number of requests not yet uploaded
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_ASYNCTEXTURELOADER_H_INCLUDED )
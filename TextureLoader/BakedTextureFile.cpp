@@ -0,0 +1,251 @@
+/** @file *//********************************************************************************************************
+
+                                                BakedTextureFile.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/BakedTextureFile.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "BakedTextureFile.h"
+
+#include "Misc/Types.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+// S3TC definitions
+
+#if !defined( GL_COMPRESSED_RGB_S3TC_DXT1_EXT )
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT		0x83F0
+#endif
+
+#if !defined( GL_COMPRESSED_RGBA_S3TC_DXT5_EXT )
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT	0x83F3
+#endif
+
+// Returns the number of bytes per texel of pixels with the given GL format and type, 0 if the format is a supported
+// compressed internal format, or -1 if the format and type are not supported
+
+int GetFormatTexelSize( uint32 format, uint32 type )
+{
+	if ( type != GL_UNSIGNED_BYTE )
+	{
+		return -1;
+	}
+
+	switch ( format )
+	{
+	case GL_LUMINANCE:
+		return 1;
+
+	case GL_LUMINANCE_ALPHA:
+		return 2;
+
+	case GL_BGR_EXT:
+	case GL_RGB:
+		return 3;
+
+	case GL_BGRA_EXT:
+	case GL_RGBA:
+		return 4;
+
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+// Rounds an offset up to the alignment of the pixel data
+
+inline size_t Align( size_t offset )
+{
+	return ( offset + GlObjects::BakedTextureFile::ALIGNMENT - 1 ) & ~size_t( GlObjects::BakedTextureFile::ALIGNMENT - 1 );
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+uint8 const	BakedTextureFile::SIGNATURE[ 4 ]	= { 'G', 'L', 'B', 'T' };
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The header is checked before anything is read from the levels. The format and type must be one of the formats
+/// loaded from TGA files with a type of @c GL_UNSIGNED_BYTE (or a DXT1 or DXT5 internal format), and the texel size
+/// must match them, so GL never reads past the end of a level.
+///
+/// @param	sFileName	Name of the file to map
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the file cannot be opened and mapped, or if it is
+///				not a valid baked texture file.
+
+BakedTextureFile::BakedTextureFile( char const * sFileName )
+	: m_File( sFileName ),
+	m_pHeader( 0 ),
+	m_pLevels( 0 )
+{
+	size_t const	fileSize	= m_File.GetSize();
+
+	if ( fileSize < sizeof( Header ) ) throw std::runtime_error( "Invalid baked texture file" );
+
+	m_pHeader	= reinterpret_cast< Header const * >( m_File.GetData() );
+	m_pLevels	= reinterpret_cast< LevelInfo const * >( m_File.GetData() + sizeof( Header ) );
+
+	if ( memcmp( m_pHeader->signature, SIGNATURE, sizeof( SIGNATURE ) ) != 0 ||
+		 m_pHeader->version != VERSION ||
+		 m_pHeader->width == 0 ||
+		 m_pHeader->height == 0 ||
+		 m_pHeader->nLevels == 0 ||
+		 GetFormatTexelSize( m_pHeader->format, m_pHeader->type ) != int( m_pHeader->texelSize ) ||
+		 m_pHeader->nLevels > ( fileSize - sizeof( Header ) ) / sizeof( LevelInfo ) )
+	{
+		throw std::runtime_error( "Invalid baked texture file" );
+	}
+
+	// Make sure every level is where it should be and is the right size. Each level must be half the size of the
+	// previous level (but not less than 1) in each dimension, and there can't be more levels than a full chain.
+
+	uint32	width	= m_pHeader->width;
+	uint32	height	= m_pHeader->height;
+
+	for ( uint32 i = 0; i < m_pHeader->nLevels; i++ )
+	{
+		LevelInfo const &	level	= m_pLevels[ i ];
+
+		bool const			bSizeOk	= IsCompressed() ?
+										  level.size > 0 :
+										  size_t( level.width ) * level.height * m_pHeader->texelSize == level.size;
+
+		if ( level.width != width ||
+			 level.height != height ||
+			 level.offset % ALIGNMENT != 0 ||
+			 level.offset > fileSize ||
+			 level.size > fileSize - level.offset ||
+			 !bSizeOk )
+		{
+			throw std::runtime_error( "Invalid baked texture file" );
+		}
+
+		if ( width == 1 && height == 1 && i + 1 < m_pHeader->nLevels )
+		{
+			throw std::runtime_error( "Invalid baked texture file" );
+		}
+
+		width	= ( width > 1 ) ? width / 2 : 1;
+		height	= ( height > 1 ) ? height / 2 : 1;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The size of each level is half the size of the previous level (but not less than 1) in each dimension.
+///
+/// @param	sFileName	Name of the file to write
+/// @param	width		Width of level 0
+/// @param	height		Height of level 0
+/// @param	format		GL format of the pixels, or GL internal format if the levels are compressed
+/// @param	type		GL type of the pixels
+/// @param	texelSize	Bytes per texel, or 0 if the levels are compressed
+/// @param	nLevels		Number of levels
+/// @param	apLevels	Pixel data of each level, with tightly-packed rows starting with the bottom row
+/// @param	aSizes		Size of each level. Required only if the levels are compressed.
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the file cannot be written.
+
+void BakedTextureFile::Write( char const *			sFileName,
+							  int					width,
+							  int					height,
+							  GLenum				format,
+							  GLenum				type,
+							  int					texelSize,
+							  int					nLevels,
+							  uint8 const * const *	apLevels,
+							  size_t const *		aSizes		/* = 0*/ )
+{
+	assert( nLevels > 0 );
+	assert( texelSize > 0 || aSizes != 0 );
+
+	Header						header;
+	std::vector< LevelInfo >	levels( nLevels );
+
+	memcpy( header.signature, SIGNATURE, sizeof( SIGNATURE ) );
+	header.version		= VERSION;
+	header.width		= width;
+	header.height		= height;
+	header.format		= format;
+	header.type			= type;
+	header.texelSize	= texelSize;
+	header.nLevels		= nLevels;
+
+	// Lay out the levels
+
+	size_t	offset	= sizeof( Header ) + nLevels * sizeof( LevelInfo );
+
+	for ( int i = 0; i < nLevels; i++ )
+	{
+		offset = Align( offset );
+
+		levels[ i ].offset	= uint32( offset );
+		levels[ i ].width	= width;
+		levels[ i ].height	= height;
+		levels[ i ].size	= uint32( ( texelSize > 0 ) ? size_t( width ) * height * texelSize : aSizes[ i ] );
+
+		offset += levels[ i ].size;
+
+		width	= ( width > 1 ) ? width / 2 : 1;
+		height	= ( height > 1 ) ? height / 2 : 1;
+	}
+
+	// Write the file
+
+	FILE * const	fp	= fopen( sFileName, "wb" );
+	if ( fp == 0 ) throw std::runtime_error( "Unable to create file" );
+
+	bool	ok	= true;
+
+	ok = ok && fwrite( &header, sizeof( header ), 1, fp ) == 1;
+	ok = ok && fwrite( &levels[ 0 ], sizeof( LevelInfo ), nLevels, fp ) == size_t( nLevels );
+
+	for ( int i = 0; ok && i < nLevels; i++ )
+	{
+		static uint8 const	aPadding[ ALIGNMENT ]	= { 0 };
+		size_t const		padding					= levels[ i ].offset - ftell( fp );
+
+		ok = ok && fwrite( aPadding, 1, padding, fp ) == padding;
+		ok = ok && fwrite( apLevels[ i ], 1, levels[ i ].size, fp ) == levels[ i ].size;
+	}
+
+	ok = ( fclose( fp ) == 0 ) && ok;
+
+	if ( !ok ) throw std::runtime_error( "Unable to write file" );
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,135 @@
+#if !defined( GLOBJECTS_BAKEDTEXTUREFILE_H_INCLUDED )
+#define GLOBJECTS_BAKEDTEXTUREFILE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                 BakedTextureFile.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/BakedTextureFile.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <gl/gl.h>
+#include "MappedFile.h"
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A pre-baked texture file.
+///
+/// A baked texture contains one or more mip levels whose pixels are already in the order and format that GL expects,
+/// so they can be uploaded straight from the mapped file. The file consists of:
+///
+///		- A Header
+///		- An array of Header::nLevels LevelInfo structures
+///		- The pixel data of each level, starting at a multiple of 16 bytes from the start of the file. Rows are
+///		  tightly packed, starting with the bottom row.
+///
+/// If Header::texelSize is 0, the levels are compressed, and Header::format is the compressed internal format (for
+/// example, one returned by DxtCompressor::GetInternalFormat()).
+///
+/// All values are stored little-endian.
+
+class BakedTextureFile
+{
+public:
+
+	/// The file header
+	struct Header
+	{
+		uint8		signature[ 4 ];		///< Identifies the file. Must be SIGNATURE.
+		uint32		version;			///< Format version. Must be VERSION.
+		uint32		width;				///< Width of level 0
+		uint32		height;				///< Height of level 0
+		uint32		format;				///< GL format of the pixels (or GL internal format if compressed)
+		uint32		type;				///< GL type of the pixels
+		uint32		texelSize;			///< Bytes per texel, or 0 if the levels are compressed
+		uint32		nLevels;			///< Number of mip levels in the file
+	};
+
+	/// Describes the location and size of a level
+	struct LevelInfo
+	{
+		uint32		offset;				///< Offset of the pixel data from the start of the file (a multiple of 16)
+		uint32		size;				///< Size of the pixel data in bytes
+		uint32		width;				///< Width in texels
+		uint32		height;				///< Height in texels
+	};
+
+	static uint8 const	SIGNATURE[ 4 ];		///< The file signature ("GLBT")
+	static uint32 const	VERSION		= 1;	///< The current version
+	static uint32 const	ALIGNMENT	= 16;	///< Alignment of the pixel data of each level
+
+	/// Constructor
+	BakedTextureFile( char const * sFileName );
+
+	/// Returns the width of level 0
+	int GetWidth() const								{ return m_pHeader->width; }
+
+	/// Returns the height of level 0
+	int GetHeight() const								{ return m_pHeader->height; }
+
+	/// Returns the GL format of the pixels
+	GLenum GetFormat() const							{ return m_pHeader->format; }
+
+	/// Returns the GL type of the pixels
+	GLenum GetType() const								{ return m_pHeader->type; }
+
+	/// Returns the number of bytes per texel, or 0 if the levels are compressed
+	int GetTexelSize() const							{ return m_pHeader->texelSize; }
+
+	/// Returns @c true if the levels are compressed
+	bool IsCompressed() const							{ return m_pHeader->texelSize == 0; }
+
+	/// Returns the number of levels in the file
+	int GetLevelCount() const							{ return m_pHeader->nLevels; }
+
+	/// Returns information about a level
+	LevelInfo const & GetLevelInfo( int level ) const	{ return m_pLevels[ level ]; }
+
+	/// Returns the pixel data of a level
+	uint8 const * GetLevelData( int level ) const		{ return m_File.GetData() + m_pLevels[ level ].offset; }
+
+	/// Writes a baked texture file
+	static void Write( char const *			sFileName,
+					   int					width,
+					   int					height,
+					   GLenum				format,
+					   GLenum				type,
+					   int					texelSize,
+					   int					nLevels,
+					   uint8 const * const *	apLevels,
+					   size_t const *		aSizes		= 0 );
+
+private:
+
+	// Prevent copying
+	BakedTextureFile( BakedTextureFile const & );
+	BakedTextureFile & operator =( BakedTextureFile const & );
+
+	MappedFile			m_File;			///< The mapped file
+	Header const *		m_pHeader;		///< The header in the mapped file
+	LevelInfo const *	m_pLevels;		///< The level information in the mapped file
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_BAKEDTEXTUREFILE_H_INCLUDED )
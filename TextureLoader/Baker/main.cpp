@@ -0,0 +1,305 @@
+/** @file *//********************************************************************************************************
+
+                                                       main.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/Baker/main.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include "GlObjects/TextureLoader/BakedTextureFile.h"
+#include "GlObjects/TextureLoader/DxtCompressor.h"
+#include "GlObjects/TextureLoader/MipMapGenerator.h"
+#include "GlObjects/TextureLoader/TextureAtlas.h"
+#include "GlObjects/TextureLoader/TextureLoader.h"
+#include "GlObjects/TextureLoader/TgaImage.h"
+#include "Misc/auto_array_ptr.h"
+#include "Misc/Types.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+#include <gl/gl.h>
+
+using namespace GlObjects;
+
+static void Usage();
+static void Bake( char const * sOutput, char const * const * pasInputs, int nInputs,
+				  unsigned flags, bool bGenerateMipMaps, MipMapGenerator::Filter filter, bool bGammaCorrect,
+				  bool bCompress, DxtCompressor::Format format, DxtCompressor::Quality quality );
+static void BakeAtlas( char const * sOutput, char const * const * pasInputs, int nInputs, int pageSize, unsigned flags );
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+int main( int argc, char ** argv )
+{
+	unsigned				flags				= 0;
+	bool					bGenerateMipMaps	= false;
+	bool					bGammaCorrect		= false;
+	MipMapGenerator::Filter	filter				= MipMapGenerator::FILTER_BOX;
+	bool					bCompress			= false;
+	DxtCompressor::Format	format				= DxtCompressor::FORMAT_BC1;
+	DxtCompressor::Quality	quality				= DxtCompressor::QUALITY_FAST;
+	int						atlasSize			= 0;
+	int						i;
+
+	// Parse the options
+
+	for ( i = 1; i < argc && argv[ i ][ 0 ] == '-'; i++ )
+	{
+		if		( strcmp( argv[ i ], "-m" ) == 0 )	bGenerateMipMaps = true;
+		else if ( strcmp( argv[ i ], "-k" ) == 0 )	filter = MipMapGenerator::FILTER_KAISER;
+		else if ( strcmp( argv[ i ], "-g" ) == 0 )	bGammaCorrect = true;
+		else if ( strcmp( argv[ i ], "-e" ) == 0 )	flags |= TGA_LOAD_EXPAND_TO_BGRA;
+		else if ( strcmp( argv[ i ], "-r" ) == 0 )	flags |= TGA_LOAD_RGBA_ORDER;
+		else if ( strcmp( argv[ i ], "-p" ) == 0 )	flags |= TGA_LOAD_PREMULTIPLY_ALPHA;
+		else if ( strcmp( argv[ i ], "-c1" ) == 0 )	{ bCompress = true; format = DxtCompressor::FORMAT_BC1; }
+		else if ( strcmp( argv[ i ], "-c3" ) == 0 )	{ bCompress = true; format = DxtCompressor::FORMAT_BC3; }
+		else if ( strcmp( argv[ i ], "-q" ) == 0 )	quality = DxtCompressor::QUALITY_HIGH;
+		else if ( strcmp( argv[ i ], "-a" ) == 0 && i + 1 < argc && atoi( argv[ i + 1 ] ) > 0 )
+		{
+			atlasSize = atoi( argv[ ++i ] );
+		}
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	// There must be an output file and at least one input file. Mip levels can't be both generated and listed, and
+	// an atlas is neither mip-mapped nor compressed.
+
+	int const	nInputs	= argc - i - 1;
+
+	if ( nInputs < 1 || ( bGenerateMipMaps && nInputs > 1 ) || ( atlasSize > 0 && ( bGenerateMipMaps || bCompress ) ) )
+	{
+		Usage();
+		return 1;
+	}
+
+	try
+	{
+		if ( atlasSize > 0 )
+			BakeAtlas( argv[ i ], &argv[ i + 1 ], nInputs, atlasSize, flags );
+		else
+			Bake( argv[ i ], &argv[ i + 1 ], nInputs, flags, bGenerateMipMaps, filter, bGammaCorrect, bCompress, format, quality );
+	}
+	catch ( std::exception const & e )
+	{
+		fprintf( stderr, "Baker: %s\n", e.what() );
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+static void Usage()
+{
+	fprintf( stderr,
+			 "usage: Baker [-m] [-k] [-g] [-e] [-r] [-p] [-c1 | -c3] [-q] output input.tga [level1.tga ...]\n"
+			 "       Baker -a size [-p] output image1.tga [image2.tga ...]\n"
+			 "\n"
+			 "  -m   generate a full mip chain from input.tga\n"
+			 "  -k   generate mip levels with a Kaiser filter instead of a box filter\n"
+			 "  -g   generate mip levels in linear space\n"
+			 "  -e   expand 24-bit images to 32 bits\n"
+			 "  -r   store texels in RGBA order instead of BGRA\n"
+			 "  -p   premultiply alpha\n"
+			 "  -c1  compress to BC1 (DXT1)\n"
+			 "  -c3  compress to BC3 (DXT5)\n"
+			 "  -q   compress with the high-quality mode\n"
+			 "  -a   pack the images into a texture atlas with pages of size x size texels\n"
+			 "\n"
+			 "If more than one input file is given, they are levels 0, 1, 2, ... of the texture. With -a, they are\n"
+			 "the images in the atlas, and each page is written to output.<page>.glbt.\n" );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Loads the input files, converts them, and writes the levels to a baked texture file
+
+static void Bake( char const * sOutput, char const * const * pasInputs, int nInputs,
+				  unsigned flags, bool bGenerateMipMaps, MipMapGenerator::Filter filter, bool bGammaCorrect,
+				  bool bCompress, DxtCompressor::Format format, DxtCompressor::Quality quality )
+{
+	auto_array_ptr< TgaImage >		qaImages( new TgaImage[ nInputs ] );
+	std::vector< uint8 const * >	apLevels;
+
+	// Load each level and make sure it is the same format as level 0 and half the size of the previous level
+
+	for ( int i = 0; i < nInputs; i++ )
+	{
+		TgaImage &	image	= qaImages.get()[ i ];
+
+		LoadTgaImage( pasInputs[ i ], flags, &image );
+
+		if ( i > 0 )
+		{
+			TgaImage const &	previous	= qaImages.get()[ i - 1 ];
+
+			if ( image.format != previous.format || image.texelSize != previous.texelSize )
+			{
+				throw std::runtime_error( "All levels must have the same format" );
+			}
+
+			if ( image.width != ( ( previous.width > 1 ) ? previous.width / 2 : 1 ) ||
+				 image.height != ( ( previous.height > 1 ) ? previous.height / 2 : 1 ) )
+			{
+				throw std::runtime_error( "Each level must be half the size of the previous level" );
+			}
+		}
+
+		apLevels.push_back( image.pData );
+	}
+
+	TgaImage const &		base	= *qaImages.get();
+	int						nLevels	= nInputs;
+	auto_array_ptr< uint8 >	qaChain;
+
+	// Generate the rest of the levels if requested
+
+	if ( bGenerateMipMaps )
+	{
+		nLevels = MipMapGenerator::GetLevelCount( base.width, base.height );
+
+		if ( nLevels > 1 )
+		{
+			size_t const	chainSize	= MipMapGenerator::GetChainSize( base.width, base.height, base.texelSize );
+
+			qaChain = auto_array_ptr< uint8 >( new uint8[ chainSize ] );
+
+			MipMapGenerator	generator( filter, bGammaCorrect );
+
+			generator.BuildChain( base.pData, base.width, base.height, base.texelSize, qaChain.get() );
+
+			// The levels are stored consecutively in the chain
+
+			uint8 const *	pLevel	= qaChain.get();
+			int				w		= base.width;
+			int				h		= base.height;
+
+			for ( int i = 1; i < nLevels; i++ )
+			{
+				w = ( w > 1 ) ? w / 2 : 1;
+				h = ( h > 1 ) ? h / 2 : 1;
+
+				apLevels.push_back( pLevel );
+				pLevel += size_t( w ) * h * base.texelSize;
+			}
+		}
+	}
+
+	if ( !bCompress )
+	{
+		BakedTextureFile::Write( sOutput,
+								 base.width, base.height,
+								 base.format, GL_UNSIGNED_BYTE, base.texelSize,
+								 nLevels, &apLevels[ 0 ] );
+
+		printf( "%s: %d x %d, %d bytes per texel, %d level(s)\n", sOutput, base.width, base.height, base.texelSize, nLevels );
+		return;
+	}
+
+	// Compress the levels one after another into a single buffer
+
+	std::vector< size_t >	sizes( nLevels );
+	size_t					totalSize	= 0;
+
+	{
+		int	w	= base.width;
+		int	h	= base.height;
+
+		for ( int i = 0; i < nLevels; i++ )
+		{
+			sizes[ i ]	= DxtCompressor::GetCompressedSize( w, h, format );
+			totalSize	+= sizes[ i ];
+
+			w = ( w > 1 ) ? w / 2 : 1;
+			h = ( h > 1 ) ? h / 2 : 1;
+		}
+	}
+
+	auto_array_ptr< uint8 >			qaCompressed( new uint8[ totalSize ] );
+	std::vector< uint8 const * >	apCompressed( nLevels );
+	DxtCompressor					compressor( quality );
+	uint8 *							pCompressed	= qaCompressed.get();
+	int								w			= base.width;
+	int								h			= base.height;
+
+	for ( int i = 0; i < nLevels; i++ )
+	{
+		compressor.Compress( apLevels[ i ], w, h, base.format, format, pCompressed );
+
+		apCompressed[ i ] = pCompressed;
+		pCompressed += sizes[ i ];
+
+		w = ( w > 1 ) ? w / 2 : 1;
+		h = ( h > 1 ) ? h / 2 : 1;
+	}
+
+	BakedTextureFile::Write( sOutput,
+							 base.width, base.height,
+							 DxtCompressor::GetInternalFormat( format ), GL_UNSIGNED_BYTE, 0,
+							 nLevels, &apCompressed[ 0 ], &sizes[ 0 ] );
+
+	// Report the error of level 0 so that the quality of the compression can be checked
+
+	double const	error	= DxtCompressor::GetRmsError( base.pData, base.width, base.height, base.format,
+														  format, apCompressed[ 0 ] );
+
+	printf( "%s: %d x %d, %s, %d level(s), RMS error %.2f\n",
+			sOutput, base.width, base.height, ( format == DxtCompressor::FORMAT_BC1 ) ? "BC1" : "BC3", nLevels, error );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Packs the input files into an atlas and saves it
+
+static void BakeAtlas( char const * sOutput, char const * const * pasInputs, int nInputs, int pageSize, unsigned flags )
+{
+	TextureLoader::SetPremultipliedAlpha( ( flags & TGA_LOAD_PREMULTIPLY_ALPHA ) != 0 );
+
+	TextureAtlas	atlas( pageSize );
+
+	for ( int i = 0; i < nInputs; i++ )
+	{
+		atlas.Add( pasInputs[ i ] );
+	}
+
+	atlas.Pack();
+	atlas.Save( sOutput );
+
+	printf( "%s: %d image(s) in %d page(s) of %d x %d\n",
+			sOutput, atlas.GetRegionCount(), atlas.GetPageCount(), pageSize, pageSize );
+}
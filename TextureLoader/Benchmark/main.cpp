@@ -0,0 +1,539 @@
+/** @file *//********************************************************************************************************
+
+                                                       main.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/Benchmark/main.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include "GlObjects/TextureLoader/MappedTgaFile.h"
+#include "GlObjects/TextureLoader/MipMapGenerator.h"
+#include "GlObjects/TextureLoader/PixelConverter.h"
+#include "GlObjects/TextureLoader/ScopedUnpackAlignment.h"
+#include "GlObjects/TextureLoader/TgaImage.h"
+#include "Glx/Texture.h"
+#include "Misc/Types.h"
+#include "Wglx/Wglx.h"
+#include "Wx/Wx.h"
+
+#include <gl/gl.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using GlObjects::PixelConverter;
+
+// A generated TGA file used by the loader benchmark
+
+struct CorpusFile
+{
+	std::string		name;			// Description of the file
+	std::string		path;			// Where the file is
+	int				width;			// Width in pixels
+	int				height;			// Height in pixels
+	int				texelSize;		// Bytes per pixel
+};
+
+static void BenchmarkKernels( int width, int height, int nIterations );
+static void BenchmarkLoader( int nIterations );
+static void GenerateCorpus( std::string const & directory, std::vector< CorpusFile > * pCorpus );
+static void WriteTga( char const * sFileName, int width, int height, int imageType, int depth, uint8 const * pPixels );
+static void Report( char const * sFile, char const * sStage, std::vector< double > * pTimes, size_t bytes );
+static double ElapsedSeconds( LARGE_INTEGER const & start, LARGE_INTEGER const & end );
+
+static char const * const	s_aInstructionSetNames[]	= { "scalar", "SSE2", "AVX2" };
+static char					s_aWindowClassName[]		= "TextureLoaderBenchmark";
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+int main( int argc, char ** argv )
+{
+	bool	bKernels	= true;
+	bool	bLoader		= true;
+	int		nIterations	= 20;
+	int		i			= 1;
+
+	if ( i < argc && strcmp( argv[ i ], "-kernels" ) == 0 )
+	{
+		bLoader = false;
+		++i;
+	}
+	else if ( i < argc && strcmp( argv[ i ], "-loader" ) == 0 )
+	{
+		bKernels = false;
+		++i;
+	}
+
+	if ( i < argc ) nIterations = atoi( argv[ i++ ] );
+
+	if ( i < argc || nIterations <= 0 )
+	{
+		fprintf( stderr, "usage: Benchmark [-kernels | -loader] [iterations]\n" );
+		return 1;
+	}
+
+	if ( bKernels )
+	{
+		BenchmarkKernels( 2048, 2048, nIterations );
+	}
+
+	if ( bLoader )
+	{
+		if ( bKernels ) printf( "\n" );
+
+		try
+		{
+			BenchmarkLoader( nIterations );
+		}
+		catch ( std::exception const & e )
+		{
+			fprintf( stderr, "Benchmark: %s\n", e.what() );
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Measures the throughput of each pixel conversion with each instruction set supported by this CPU. Throughput is
+// measured in MB of source data per second.
+
+static void BenchmarkKernels( int width, int height, int nIterations )
+{
+	size_t const			nPixels	= size_t( width ) * height;
+	std::vector< uint8 >	src( nPixels * 4 );
+	std::vector< uint8 >	dst( nPixels * 4 );
+
+	for ( size_t i = 0; i < src.size(); i++ )
+	{
+		src[ i ] = uint8( rand() );
+	}
+
+	PixelConverter::InstructionSet const	supported	= PixelConverter::GetSupportedInstructionSet();
+
+	printf( "Pixel conversions, %d x %d, %d iterations\n", width, height, nIterations );
+	printf( "%-24s %-8s %12s\n", "kernel", "isa", "MB/s" );
+
+	for ( int isa = PixelConverter::INSTRUCTIONS_SCALAR; isa <= supported; isa++ )
+	{
+		PixelConverter::SetInstructionSet( PixelConverter::InstructionSet( isa ) );
+
+		for ( int kernel = 0; kernel < 4; kernel++ )
+		{
+			static char const * const	aKernelNames[ 4 ]	=
+			{
+				"ExpandBgrToBgra",
+				"SwizzleBgraToRgba",
+				"FlipVertical",
+				"PremultiplyAlpha"
+			};
+
+			size_t const	aSourceBytes[ 4 ]	= { nPixels * 3, nPixels * 4, nPixels * 4, nPixels * 4 };
+
+			LARGE_INTEGER	start, end;
+
+			QueryPerformanceCounter( &start );
+
+			for ( int i = 0; i < nIterations; i++ )
+			{
+				switch ( kernel )
+				{
+				case 0:	PixelConverter::ExpandBgrToBgra( &src[ 0 ], &dst[ 0 ], nPixels );				break;
+				case 1:	PixelConverter::SwizzleBgraToRgba( &src[ 0 ], &dst[ 0 ], nPixels );			break;
+				case 2:	PixelConverter::FlipVertical( &dst[ 0 ], size_t( width ) * 4, height );		break;
+				case 3:	PixelConverter::PremultiplyAlpha( &src[ 0 ], &dst[ 0 ], nPixels );				break;
+				}
+			}
+
+			QueryPerformanceCounter( &end );
+
+			double const	seconds	= ElapsedSeconds( start, end );
+			double const	mb		= double( aSourceBytes[ kernel ] ) * nIterations / ( 1024. * 1024. );
+
+			printf( "%-24s %-8s %12.1f\n", aKernelNames[ kernel ], s_aInstructionSetNames[ isa ], mb / seconds );
+		}
+	}
+
+	PixelConverter::SetInstructionSet( supported );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Measures each stage of loading a texture, for each file in a generated corpus. The stages are timed separately:
+//
+//	header		Mapping the file and parsing the header (MappedTgaFile)
+//	read		Reading (and decoding, if RLE) the pixels into memory (LoadTgaImage without conversions)
+//	convert		Converting the pixels (BGR -> BGRA expansion or BGRA -> RGBA swizzle)
+//	mip build	Building the rest of the mip chain (MipMapGenerator)
+//	upload		Creating a texture from the pixels, including glFinish()
+//
+// The GL context belongs to a window that is never shown, so no display output is needed. If a context can't be
+// created, the upload stage is skipped.
+
+static void BenchmarkLoader( int nIterations )
+{
+	char	aTempPath[ MAX_PATH ];
+
+	if ( GetTempPath( sizeof( aTempPath ), aTempPath ) == 0 ) throw std::runtime_error( "Unable to find temp directory" );
+
+	std::string const			directory	= std::string( aTempPath ) + "TextureLoaderBenchmark\\";
+	std::vector< CorpusFile >	corpus;
+
+	CreateDirectory( directory.c_str(), NULL );
+	GenerateCorpus( directory, &corpus );
+
+	// Create a hidden window for the GL context
+
+	HINSTANCE const	hInstance	= GetModuleHandle( NULL );
+	HWND			hWnd		= NULL;
+
+	if ( Wx::RegisterWindowClass( CS_OWNDC, ( WNDPROC )DefWindowProc, hInstance, s_aWindowClassName ) != NULL )
+	{
+		hWnd = CreateWindowEx( 0, s_aWindowClassName, s_aWindowClassName, WS_OVERLAPPEDWINDOW,
+							   0, 0, 64, 64, NULL, NULL, hInstance, NULL );
+	}
+
+	HDC const	hDC	= ( hWnd != NULL ) ? GetDC( hWnd ) : NULL;
+
+	if ( hDC != NULL )
+	{
+		WGlx::SetPixelFormat( hDC, 0, true );
+	}
+
+	{
+		std::auto_ptr< WGlx::CurrentRenderingContext >	qContext;
+
+		if ( hDC != NULL )
+		{
+			qContext.reset( new WGlx::CurrentRenderingContext( hDC ) );
+			printf( "Loader, %d iterations, GL: %s %s\n", nIterations, glGetString( GL_VENDOR ), glGetString( GL_RENDERER ) );
+		}
+		else
+		{
+			printf( "Loader, %d iterations, no GL context (upload is skipped)\n", nIterations );
+		}
+
+		printf( "%-20s %-10s %10s %10s %10s %10s\n", "file", "stage", "MB/s", "p50 ms", "p90 ms", "p99 ms" );
+
+		GlObjects::MipMapGenerator	generator;
+		std::vector< double >		header;
+		std::vector< double >		read;
+		std::vector< double >		convert;
+		std::vector< double >		mipBuild;
+		std::vector< double >		upload;
+
+		for ( std::vector< CorpusFile >::const_iterator pFile = corpus.begin(); pFile != corpus.end(); ++pFile )
+		{
+			size_t const			imageSize	= size_t( pFile->width ) * pFile->height * pFile->texelSize;
+			size_t const			chainSize	= GlObjects::MipMapGenerator::GetChainSize( pFile->width, pFile->height, pFile->texelSize );
+			std::vector< uint8 >	converted( size_t( pFile->width ) * pFile->height * 4 );
+			std::vector< uint8 >	chain( chainSize + 1 );
+
+			header.clear();
+			read.clear();
+			convert.clear();
+			mipBuild.clear();
+			upload.clear();
+
+			for ( int i = 0; i < nIterations; i++ )
+			{
+				LARGE_INTEGER	t0, t1, t2, t3, t4, t5;
+
+				QueryPerformanceCounter( &t0 );
+
+				{
+					GlObjects::MappedTgaFile	file( pFile->path.c_str() );
+				}
+
+				QueryPerformanceCounter( &t1 );
+
+				GlObjects::TgaImage	image;
+
+				GlObjects::LoadTgaImage( pFile->path.c_str(), 0, &image );
+
+				QueryPerformanceCounter( &t2 );
+
+				size_t const	nPixels	= size_t( image.width ) * image.height;
+
+				if ( image.texelSize == 3 )
+				{
+					PixelConverter::ExpandBgrToBgra( image.pData, &converted[ 0 ], nPixels );
+				}
+				else if ( image.texelSize == 4 )
+				{
+					PixelConverter::SwizzleBgraToRgba( image.pData, &converted[ 0 ], nPixels );
+				}
+
+				QueryPerformanceCounter( &t3 );
+
+				generator.BuildChain( image.pData, image.width, image.height, image.texelSize, &chain[ 0 ] );
+
+				QueryPerformanceCounter( &t4 );
+
+				if ( qContext.get() != 0 )
+				{
+					GlObjects::ScopedUnpackAlignment	alignment;
+
+					Glx::Texture	texture( image.width, image.height, image.pData, image.format, GL_UNSIGNED_BYTE,
+											 GL_REPEAT, GL_LINEAR, GL_LINEAR, 0 );
+
+					glFinish();
+				}
+
+				QueryPerformanceCounter( &t5 );
+
+				header.push_back( ElapsedSeconds( t0, t1 ) );
+				read.push_back( ElapsedSeconds( t1, t2 ) );
+				convert.push_back( ElapsedSeconds( t2, t3 ) );
+				mipBuild.push_back( ElapsedSeconds( t3, t4 ) );
+				upload.push_back( ElapsedSeconds( t4, t5 ) );
+			}
+
+			char const * const	sName	= pFile->name.c_str();
+
+			Report( sName, "header", &header, 0 );
+			Report( sName, "read", &read, imageSize );
+			if ( pFile->texelSize >= 3 ) Report( sName, "convert", &convert, imageSize );
+			Report( sName, "mip build", &mipBuild, imageSize );
+			if ( qContext.get() != 0 ) Report( sName, "upload", &upload, imageSize );
+		}
+	}
+
+	if ( hDC != NULL ) ReleaseDC( hWnd, hDC );
+	if ( hWnd != NULL ) DestroyWindow( hWnd );
+
+	for ( std::vector< CorpusFile >::const_iterator pFile = corpus.begin(); pFile != corpus.end(); ++pFile )
+	{
+		DeleteFile( pFile->path.c_str() );
+	}
+	RemoveDirectory( directory.c_str() );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Writes a TGA file for each combination of size and format. The images are runs of random lengths and colors, so
+// the RLE files compress about as well as typical artwork.
+
+static void GenerateCorpus( std::string const & directory, std::vector< CorpusFile > * pCorpus )
+{
+	static int const	aSizes[]	= { 256, 1024, 2048 };
+
+	static struct
+	{
+		char const *	sName;
+		int				imageType;
+		int				depth;
+	} const				aFormats[]	=
+	{
+		{ "bgr24",		2,	24 },
+		{ "bgra32",		2,	32 },
+		{ "gray8",		3,	8 },
+		{ "rle-bgr24",	10,	24 },
+		{ "rle-bgra32",	10,	32 }
+	};
+
+	srand( 1 );
+
+	for ( int s = 0; s < int( sizeof( aSizes ) / sizeof( aSizes[ 0 ] ) ); s++ )
+	{
+		for ( int f = 0; f < int( sizeof( aFormats ) / sizeof( aFormats[ 0 ] ) ); f++ )
+		{
+			int const				size		= aSizes[ s ];
+			int const				texelSize	= aFormats[ f ].depth / 8;
+			std::vector< uint8 >	pixels( size_t( size ) * size * texelSize );
+
+			for ( size_t i = 0; i < pixels.size(); )
+			{
+				size_t const	run	= std::min( size_t( 1 + rand() % 16 ) * texelSize, pixels.size() - i );
+				uint8			aTexel[ 4 ];
+
+				for ( int c = 0; c < texelSize; c++ )
+				{
+					aTexel[ c ] = uint8( rand() );
+				}
+
+				for ( size_t j = 0; j < run; j++ )
+				{
+					pixels[ i + j ] = aTexel[ j % texelSize ];
+				}
+
+				i += run;
+			}
+
+			char	aName[ 64 ];
+
+			sprintf( aName, "%s-%d", aFormats[ f ].sName, size );
+
+			CorpusFile	file;
+
+			file.name		= aName;
+			file.path		= directory + aName + ".tga";
+			file.width		= size;
+			file.height		= size;
+			file.texelSize	= texelSize;
+
+			WriteTga( file.path.c_str(), size, size, aFormats[ f ].imageType, aFormats[ f ].depth, &pixels[ 0 ] );
+
+			pCorpus->push_back( file );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Writes a bottom-left TGA file, run-length encoding the pixels if the image type is RLE
+
+static void WriteTga( char const * sFileName, int width, int height, int imageType, int depth, uint8 const * pPixels )
+{
+	int const		texelSize	= depth / 8;
+	size_t const	nPixels		= size_t( width ) * height;
+	uint8			aHeader[ 18 ];
+
+	memset( aHeader, 0, sizeof( aHeader ) );
+	aHeader[ 2 ]	= uint8( imageType );
+	aHeader[ 12 ]	= uint8( width );
+	aHeader[ 13 ]	= uint8( width >> 8 );
+	aHeader[ 14 ]	= uint8( height );
+	aHeader[ 15 ]	= uint8( height >> 8 );
+	aHeader[ 16 ]	= uint8( depth );
+	aHeader[ 17 ]	= uint8( ( depth == 32 ) ? 8 : 0 );
+
+	std::vector< uint8 >	data( aHeader, aHeader + sizeof( aHeader ) );
+
+	if ( imageType < 9 )
+	{
+		data.insert( data.end(), pPixels, pPixels + nPixels * texelSize );
+	}
+	else
+	{
+		// Each packet is either a run of up to 128 identical pixels or up to 128 literal pixels. Runs don't cross rows.
+
+		for ( int y = 0; y < height; y++ )
+		{
+			uint8 const * const	pRow	= pPixels + size_t( y ) * width * texelSize;
+			int					x		= 0;
+
+			while ( x < width )
+			{
+				int	run	= 1;
+
+				while ( x + run < width && run < 128 &&
+						memcmp( pRow + ( x + run ) * texelSize, pRow + x * texelSize, texelSize ) == 0 )
+				{
+					++run;
+				}
+
+				if ( run > 1 )
+				{
+					data.push_back( uint8( 0x80 | ( run - 1 ) ) );
+					data.insert( data.end(), pRow + x * texelSize, pRow + ( x + 1 ) * texelSize );
+					x += run;
+				}
+				else
+				{
+					int	count	= 1;
+
+					while ( x + count < width && count < 128 &&
+							( x + count + 1 >= width ||
+							  memcmp( pRow + ( x + count ) * texelSize, pRow + ( x + count + 1 ) * texelSize, texelSize ) != 0 ) )
+					{
+						++count;
+					}
+
+					data.push_back( uint8( count - 1 ) );
+					data.insert( data.end(), pRow + x * texelSize, pRow + ( x + count ) * texelSize );
+					x += count;
+				}
+			}
+		}
+	}
+
+	FILE * const	fp	= fopen( sFileName, "wb" );
+	if ( fp == 0 ) throw std::runtime_error( "Unable to create corpus file" );
+
+	bool const	ok	= fwrite( &data[ 0 ], 1, data.size(), fp ) == data.size();
+
+	if ( fclose( fp ) != 0 || !ok ) throw std::runtime_error( "Unable to write corpus file" );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Prints the throughput (based on the median time) and the 50th, 90th, and 99th percentile times of a stage. If the
+// number of bytes is 0, the throughput is not printed.
+
+static void Report( char const * sFile, char const * sStage, std::vector< double > * pTimes, size_t bytes )
+{
+	std::sort( pTimes->begin(), pTimes->end() );
+
+	size_t const	last	= pTimes->size() - 1;
+	double const	p50		= ( *pTimes )[ last * 50 / 100 ];
+	double const	p90		= ( *pTimes )[ last * 90 / 100 ];
+	double const	p99		= ( *pTimes )[ last * 99 / 100 ];
+
+	if ( bytes > 0 && p50 > 0.0 )
+	{
+		printf( "%-20s %-10s %10.1f %10.3f %10.3f %10.3f\n",
+				sFile, sStage, double( bytes ) / ( 1024. * 1024. ) / p50, p50 * 1000.0, p90 * 1000.0, p99 * 1000.0 );
+	}
+	else
+	{
+		printf( "%-20s %-10s %10s %10.3f %10.3f %10.3f\n", sFile, sStage, "-", p50 * 1000.0, p90 * 1000.0, p99 * 1000.0 );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+static double ElapsedSeconds( LARGE_INTEGER const & start, LARGE_INTEGER const & end )
+{
+	LARGE_INTEGER	frequency;
+
+	QueryPerformanceFrequency( &frequency );
+
+	return double( end.QuadPart - start.QuadPart ) / double( frequency.QuadPart );
+}
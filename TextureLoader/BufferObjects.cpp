@@ -0,0 +1,63 @@
+/** @file *//********************************************************************************************************
+
+                                                  BufferObjects.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/BufferObjects.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "BufferObjects.h"
+
+namespace GlObjects
+{
+
+BufferObjects::GenBuffersProc		BufferObjects::s_glGenBuffersARB	= 0;
+BufferObjects::DeleteBuffersProc	BufferObjects::s_glDeleteBuffersARB	= 0;
+BufferObjects::BindBufferProc		BufferObjects::s_glBindBufferARB	= 0;
+BufferObjects::BufferDataProc		BufferObjects::s_glBufferDataARB	= 0;
+BufferObjects::BufferSubDataProc	BufferObjects::s_glBufferSubDataARB	= 0;
+BufferObjects::MapBufferProc		BufferObjects::s_glMapBufferARB		= 0;
+BufferObjects::UnmapBufferProc		BufferObjects::s_glUnmapBufferARB	= 0;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The entry points are retrieved from the current context the first time this is called.
+///
+/// @return		@c false if any of the entry points is not available
+
+bool BufferObjects::Initialize()
+{
+	if ( s_glGenBuffersARB == 0 )
+	{
+		s_glGenBuffersARB		= (GenBuffersProc)		wglGetProcAddress( "glGenBuffersARB" );
+		s_glDeleteBuffersARB	= (DeleteBuffersProc)	wglGetProcAddress( "glDeleteBuffersARB" );
+		s_glBindBufferARB		= (BindBufferProc)		wglGetProcAddress( "glBindBufferARB" );
+		s_glBufferDataARB		= (BufferDataProc)		wglGetProcAddress( "glBufferDataARB" );
+		s_glBufferSubDataARB	= (BufferSubDataProc)	wglGetProcAddress( "glBufferSubDataARB" );
+		s_glMapBufferARB		= (MapBufferProc)		wglGetProcAddress( "glMapBufferARB" );
+		s_glUnmapBufferARB		= (UnmapBufferProc)		wglGetProcAddress( "glUnmapBufferARB" );
+	}
+
+	return s_glGenBuffersARB != 0 &&
+		   s_glDeleteBuffersARB != 0 &&
+		   s_glBindBufferARB != 0 &&
+		   s_glBufferDataARB != 0 &&
+		   s_glBufferSubDataARB != 0 &&
+		   s_glMapBufferARB != 0 &&
+		   s_glUnmapBufferARB != 0;
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,92 @@
+#if !defined( GLOBJECTS_BUFFEROBJECTS_H_INCLUDED )
+#define GLOBJECTS_BUFFEROBJECTS_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                   BufferObjects.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/BufferObjects.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <gl/gl.h>
+
+// ARB_vertex_buffer_object definitions. These are not defined by the OpenGL 1.1 headers.
+
+#if !defined( GL_ARRAY_BUFFER_ARB )
+#define GL_ARRAY_BUFFER_ARB				0x8892
+#endif
+
+#if !defined( GL_ELEMENT_ARRAY_BUFFER_ARB )
+#define GL_ELEMENT_ARRAY_BUFFER_ARB		0x8893
+#endif
+
+#if !defined( GL_STREAM_DRAW_ARB )
+#define GL_STREAM_DRAW_ARB				0x88E0
+#endif
+
+#if !defined( GL_STATIC_DRAW_ARB )
+#define GL_STATIC_DRAW_ARB				0x88E4
+#endif
+
+#if !defined( GL_WRITE_ONLY_ARB )
+#define GL_WRITE_ONLY_ARB				0x88B9
+#endif
+
+typedef ptrdiff_t	GLsizeiptrARB;
+typedef ptrdiff_t	GLintptrARB;
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The ARB_vertex_buffer_object entry points.
+///
+/// This is an internal class shared by the classes that use buffer objects (PixelBufferRing, SkyBox). The entry points
+/// are retrieved by Initialize(), which must return @c true before any of them are called.
+
+class BufferObjects
+{
+public:
+
+	typedef void		( APIENTRY * GenBuffersProc )( GLsizei n, GLuint * buffers );
+	typedef void		( APIENTRY * DeleteBuffersProc )( GLsizei n, GLuint const * buffers );
+	typedef void		( APIENTRY * BindBufferProc )( GLenum target, GLuint buffer );
+	typedef void		( APIENTRY * BufferDataProc )( GLenum target, GLsizeiptrARB size, void const * data,
+													   GLenum usage );
+	typedef void		( APIENTRY * BufferSubDataProc )( GLenum target, GLintptrARB offset, GLsizeiptrARB size,
+														  void const * data );
+	typedef void *		( APIENTRY * MapBufferProc )( GLenum target, GLenum access );
+	typedef GLboolean	( APIENTRY * UnmapBufferProc )( GLenum target );
+
+	/// Gets the entry points. Returns @c false if they are not available.
+	static bool Initialize();
+
+	static GenBuffersProc		s_glGenBuffersARB;		///< glGenBuffersARB
+	static DeleteBuffersProc	s_glDeleteBuffersARB;	///< glDeleteBuffersARB
+	static BindBufferProc		s_glBindBufferARB;		///< glBindBufferARB
+	static BufferDataProc		s_glBufferDataARB;		///< glBufferDataARB
+	static BufferSubDataProc	s_glBufferSubDataARB;	///< glBufferSubDataARB
+	static MapBufferProc		s_glMapBufferARB;		///< glMapBufferARB
+	static UnmapBufferProc		s_glUnmapBufferARB;		///< glUnmapBufferARB
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_BUFFEROBJECTS_H_INCLUDED )
@@ -0,0 +1,172 @@
+/** @file *//********************************************************************************************************
+
+                                                CubeMapTexture.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/CubeMapTexture.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "CubeMapTexture.h"
+
+#include "ScopedUnpackAlignment.h"
+
+#include "Glx/Glx.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace
+{
+
+// ARB_texture_cube_map and OpenGL 1.2 definitions
+
+#if !defined( GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB )
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB	0x8515
+#endif
+
+#if !defined( GL_TEXTURE_MAX_LEVEL )
+#define GL_TEXTURE_MAX_LEVEL				0x813D
+#endif
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	size			Width and height of level 0 of each face
+/// @param	format			Format of the data passed to SetFace()
+/// @param	type			Type of the data passed to SetFace()
+/// @param	nLevels			Number of mip levels, including level 0
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+///							@c GL_CLAMP_TO_EDGE prevents the border color from bleeding into the edges of the faces.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if cube maps are not supported.
+
+CubeMapTexture::CubeMapTexture( int size,
+								GLenum format, GLenum type,
+								int nLevels				/* = 1*/,
+								GLenum wrap				/* = GL_CLAMP_TO_EDGE*/,
+								GLenum minFiltering		/* = GL_LINEAR*/,
+								GLenum magFiltering		/* = GL_LINEAR*/,
+								GLuint id				/* = 0*/ )
+	: m_Size( size ),
+	m_nLevels( nLevels ),
+	m_Format( format ),
+	m_Type( type ),
+	m_Id( id )
+{
+	assert( size > 0 );
+	assert( nLevels > 0 );
+
+	if ( !IsSupported() ) throw std::runtime_error( "Cube maps are not supported" );
+
+	if ( m_Id == 0 )
+	{
+		glGenTextures( 1, &m_Id );
+	}
+
+	glBindTexture( GL_TEXTURE_CUBE_MAP_ARB, m_Id );
+
+	glTexParameteri( GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_S, wrap );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_T, wrap );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MIN_FILTER, minFiltering );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAG_FILTER, magFiltering );
+	glTexParameteri( GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAX_LEVEL, nLevels - 1 );
+
+	// Allocate the storage for every level of every face. The data is uploaded later.
+
+	GLint const	internalFormat	= ( format == GL_BGRA_EXT ) ? GL_RGBA : ( format == GL_BGR_EXT ) ? GL_RGB : format;
+
+	for ( int face = 0; face < NUM_FACES; face++ )
+	{
+		int	s	= size;
+
+		for ( int i = 0; i < nLevels; i++ )
+		{
+			glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + face, i, internalFormat, s, s, 0, format, type, 0 );
+
+			s = ( s > 1 ) ? s / 2 : 1;
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+CubeMapTexture::~CubeMapTexture()
+{
+	glDeleteTextures( 1, &m_Id );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool CubeMapTexture::IsSupported()
+{
+	return Glx::Extension::IsSupported( "GL_ARB_texture_cube_map" );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	face	The face
+/// @param	level	Mip level
+/// @param	pData	Tightly-packed texels of the level, in the format and type given to the constructor. The first row
+///					is at t = 0.
+
+void CubeMapTexture::SetFace( Face face, int level, void const * pData )
+{
+	assert( face >= 0 && face < NUM_FACES );
+	assert( level >= 0 && level < m_nLevels );
+
+	int const	s	= std::max( m_Size >> level, 1 );
+
+	ScopedUnpackAlignment	alignment;
+
+	glBindTexture( GL_TEXTURE_CUBE_MAP_ARB, m_Id );
+	glTexSubImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + face, level, 0, 0, s, s, m_Format, m_Type, pData );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void CubeMapTexture::Apply() const
+{
+	glBindTexture( GL_TEXTURE_CUBE_MAP_ARB, m_Id );
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,112 @@
+#if !defined( GLOBJECTS_CUBEMAPTEXTURE_H_INCLUDED )
+#define GLOBJECTS_CUBEMAPTEXTURE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                 CubeMapTexture.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/CubeMapTexture.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <gl/gl.h>
+
+// These are not defined by the OpenGL 1.1 headers
+
+#if !defined( GL_CLAMP_TO_EDGE )
+#define GL_CLAMP_TO_EDGE				0x812F
+#endif
+
+#if !defined( GL_TEXTURE_CUBE_MAP_ARB )
+#define GL_TEXTURE_CUBE_MAP_ARB			0x8513
+#endif
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A cube map texture (ARB_texture_cube_map).
+///
+/// The six faces are square and have the same size and format. The texture is sampled with a direction: the
+/// component with the largest magnitude selects the face, and the other two select the texel in the face (as specified
+/// by ARB_texture_cube_map). The storage for every face and level is allocated when the texture is created, and the
+/// faces are uploaded one at a time with SetFace().
+
+class CubeMapTexture
+{
+public:
+
+	/// The faces, in the order of their GL targets
+	enum Face
+	{
+		FACE_POSITIVE_X,
+		FACE_NEGATIVE_X,
+		FACE_POSITIVE_Y,
+		FACE_NEGATIVE_Y,
+		FACE_POSITIVE_Z,
+		FACE_NEGATIVE_Z,
+
+		NUM_FACES
+	};
+
+	/// Constructor
+	CubeMapTexture( int size,
+					GLenum format, GLenum type,
+					int nLevels				= 1,
+					GLenum wrap				= GL_CLAMP_TO_EDGE,
+					GLenum minFiltering		= GL_LINEAR,
+					GLenum magFiltering		= GL_LINEAR,
+					GLuint id				= 0 );
+
+	/// Destructor
+	~CubeMapTexture();
+
+	/// Returns @c true if cube maps are supported by the current context
+	static bool IsSupported();
+
+	/// Uploads one level of one face
+	void SetFace( Face face, int level, void const * pData );
+
+	/// Binds the texture
+	void Apply() const;
+
+	/// Returns the width and height of level 0 of each face
+	int GetSize() const							{ return m_Size; }
+
+	/// Returns the number of mip levels
+	int GetLevelCount() const					{ return m_nLevels; }
+
+	/// Returns the texture id
+	GLuint GetId() const						{ return m_Id; }
+
+private:
+
+	// Prevent copying
+	CubeMapTexture( CubeMapTexture const & );
+	CubeMapTexture & operator =( CubeMapTexture const & );
+
+	int		m_Size;			///< Width and height of level 0
+	int		m_nLevels;		///< Number of mip levels
+	GLenum	m_Format;		///< Format of the data
+	GLenum	m_Type;			///< Type of the data
+	GLuint	m_Id;			///< Texture id
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_CUBEMAPTEXTURE_H_INCLUDED )
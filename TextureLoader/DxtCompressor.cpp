@@ -0,0 +1,1225 @@
+/** @file *//********************************************************************************************************
+
+                                                 DxtCompressor.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/DxtCompressor.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "DxtCompressor.h"
+
+#include "Glx/Glx.h"
+#include "Misc/Types.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <process.h>
+#include <stdexcept>
+
+namespace
+{
+
+// EXT_texture_compression_s3tc and ARB_texture_compression definitions
+
+#if !defined( GL_COMPRESSED_RGB_S3TC_DXT1_EXT )
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT		0x83F0
+#endif
+
+#if !defined( GL_COMPRESSED_RGBA_S3TC_DXT5_EXT )
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT	0x83F3
+#endif
+
+typedef void	( APIENTRY * CompressedTexImage2DProc )( GLenum target, GLint level, GLenum internalFormat,
+														 GLsizei width, GLsizei height, GLint border,
+														 GLsizei imageSize, GLvoid const * data );
+
+CompressedTexImage2DProc	s_glCompressedTexImage2DARB	= 0;
+
+int const	MIN_PARALLEL_BLOCKS	= 32 * 32;	// Images with fewer blocks than this are not split into bands
+int const	BANDS_PER_THREAD	= 4;		// Number of bands each thread gets (on average)
+int const	LEAST_SQUARES_STEPS	= 3;		// Maximum number of endpoint refinements in the high-quality mode
+int const	POWER_ITERATIONS	= 8;		// Number of iterations used to find the principal axis
+
+// Maps the position of a texel between endpoint 1 (0) and endpoint 0 (3) to its BC1 index
+int const	s_aColorIndexMap[ 4 ]	= { 1, 3, 2, 0 };
+
+// Where the components of a texel are in the source image
+
+struct Layout
+{
+	int		texelSize;		// Bytes per texel
+	int		r;				// Offset of red
+	int		g;				// Offset of green
+	int		b;				// Offset of blue
+	int		a;				// Offset of alpha, or -1 if there is no alpha
+};
+
+// Gets the offsets of the components of a texel in the given format
+
+Layout GetLayout( GLenum format )
+{
+	Layout	layout;
+
+	switch ( format )
+	{
+	case GL_BGR_EXT:
+	{
+		Layout const	bgr		= { 3, 2, 1, 0, -1 };
+		layout = bgr;
+		break;
+	}
+	case GL_BGRA_EXT:
+	{
+		Layout const	bgra	= { 4, 2, 1, 0, 3 };
+		layout = bgra;
+		break;
+	}
+	case GL_RGB:
+	{
+		Layout const	rgb		= { 3, 0, 1, 2, -1 };
+		layout = rgb;
+		break;
+	}
+	case GL_RGBA:
+	{
+		Layout const	rgba	= { 4, 0, 1, 2, 3 };
+		layout = rgba;
+		break;
+	}
+	case GL_LUMINANCE:
+	{
+		Layout const	l		= { 1, 0, 0, 0, -1 };
+		layout = l;
+		break;
+	}
+	case GL_LUMINANCE_ALPHA:
+	{
+		Layout const	la		= { 2, 0, 0, 0, 1 };
+		layout = la;
+		break;
+	}
+	default:
+		throw std::runtime_error( "Unsupported source format" );
+	}
+
+	return layout;
+}
+
+// Copies a 4x4 block of texels into 16 RGBA texels. Texels past the right or top edge are clamped to the edge.
+
+void FetchBlock( uint8 const * pSrc, int width, int height, Layout const & layout, int bx, int by, uint8 * pBlock )
+{
+	for ( int y = 0; y < 4; y++ )
+	{
+		int const			sy		= std::min( by * 4 + y, height - 1 );
+		uint8 const * const	pRow	= pSrc + size_t( sy ) * width * layout.texelSize;
+
+		for ( int x = 0; x < 4; x++ )
+		{
+			int const			sx		= std::min( bx * 4 + x, width - 1 );
+			uint8 const * const	pTexel	= pRow + sx * layout.texelSize;
+
+			pBlock[ 0 ] = pTexel[ layout.r ];
+			pBlock[ 1 ] = pTexel[ layout.g ];
+			pBlock[ 2 ] = pTexel[ layout.b ];
+			pBlock[ 3 ] = ( layout.a >= 0 ) ? pTexel[ layout.a ] : 255;
+			pBlock += 4;
+		}
+	}
+}
+
+// Finds the smallest and largest value of each component of a block
+
+void GetBounds( uint8 const * pBlock, uint8 * pMin, uint8 * pMax )
+{
+	__m128i const	t0	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pBlock ) );
+	__m128i const	t1	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pBlock + 16 ) );
+	__m128i const	t2	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pBlock + 32 ) );
+	__m128i const	t3	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pBlock + 48 ) );
+
+	__m128i	lo	= _mm_min_epu8( _mm_min_epu8( t0, t1 ), _mm_min_epu8( t2, t3 ) );
+	__m128i	hi	= _mm_max_epu8( _mm_max_epu8( t0, t1 ), _mm_max_epu8( t2, t3 ) );
+
+	// Reduce the four texels in each register to one
+
+	lo = _mm_min_epu8( lo, _mm_shuffle_epi32( lo, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	lo = _mm_min_epu8( lo, _mm_shuffle_epi32( lo, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	hi = _mm_max_epu8( hi, _mm_shuffle_epi32( hi, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	hi = _mm_max_epu8( hi, _mm_shuffle_epi32( hi, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+
+	uint32 const	min	= uint32( _mm_cvtsi128_si32( lo ) );
+	uint32 const	max	= uint32( _mm_cvtsi128_si32( hi ) );
+
+	for ( int c = 0; c < 4; c++ )
+	{
+		pMin[ c ] = uint8( min >> ( c * 8 ) );
+		pMax[ c ] = uint8( max >> ( c * 8 ) );
+	}
+}
+
+// Converts a color to 5:6:5
+
+inline int To565( int r, int g, int b )
+{
+	return ( ( ( r * 31 + 127 ) / 255 ) << 11 ) | ( ( ( g * 63 + 127 ) / 255 ) << 5 ) | ( ( b * 31 + 127 ) / 255 );
+}
+
+// Converts a 5:6:5 color to 8:8:8
+
+inline void From565( int c, int * pRgb )
+{
+	int const	r	= ( c >> 11 ) & 31;
+	int const	g	= ( c >> 5 ) & 63;
+	int const	b	= c & 31;
+
+	pRgb[ 0 ] = ( r << 3 ) | ( r >> 2 );
+	pRgb[ 1 ] = ( g << 2 ) | ( g >> 4 );
+	pRgb[ 2 ] = ( b << 3 ) | ( b >> 2 );
+}
+
+// Computes the colors that the indices of a BC1 block refer to. In 3-color mode, index 3 is black.
+
+void BuildColorPalette( int c0, int c1, bool bFourColor, int aPalette[ 4 ][ 3 ] )
+{
+	From565( c0, aPalette[ 0 ] );
+	From565( c1, aPalette[ 1 ] );
+
+	for ( int c = 0; c < 3; c++ )
+	{
+		if ( bFourColor )
+		{
+			aPalette[ 2 ][ c ] = ( 2 * aPalette[ 0 ][ c ] + aPalette[ 1 ][ c ] ) / 3;
+			aPalette[ 3 ][ c ] = ( aPalette[ 0 ][ c ] + 2 * aPalette[ 1 ][ c ] ) / 3;
+		}
+		else
+		{
+			aPalette[ 2 ][ c ] = ( aPalette[ 0 ][ c ] + aPalette[ 1 ][ c ] ) / 2;
+			aPalette[ 3 ][ c ] = 0;
+		}
+	}
+}
+
+// Computes the values that the indices of a BC3 alpha block refer to
+
+void BuildAlphaPalette( int a0, int a1, int aPalette[ 8 ] )
+{
+	aPalette[ 0 ] = a0;
+	aPalette[ 1 ] = a1;
+
+	if ( a0 > a1 )
+	{
+		for ( int i = 2; i < 8; i++ )
+		{
+			aPalette[ i ] = ( ( 8 - i ) * a0 + ( i - 1 ) * a1 ) / 7;
+		}
+	}
+	else
+	{
+		for ( int i = 2; i < 6; i++ )
+		{
+			aPalette[ i ] = ( ( 6 - i ) * a0 + ( i - 1 ) * a1 ) / 5;
+		}
+		aPalette[ 6 ] = 0;
+		aPalette[ 7 ] = 255;
+	}
+}
+
+// Stores a BC1 color block
+
+void WriteColorBlock( int c0, int c1, uint32 indices, uint8 * pDst )
+{
+	pDst[ 0 ] = uint8( c0 );
+	pDst[ 1 ] = uint8( c0 >> 8 );
+	pDst[ 2 ] = uint8( c1 );
+	pDst[ 3 ] = uint8( c1 >> 8 );
+	pDst[ 4 ] = uint8( indices );
+	pDst[ 5 ] = uint8( indices >> 8 );
+	pDst[ 6 ] = uint8( indices >> 16 );
+	pDst[ 7 ] = uint8( indices >> 24 );
+}
+
+// Stores a BC3 alpha block. The 3-bit indices are packed 8 at a time into two 24-bit groups.
+
+void WriteAlphaBlock( int a0, int a1, int const * aIndices, uint8 * pDst )
+{
+	pDst[ 0 ] = uint8( a0 );
+	pDst[ 1 ] = uint8( a1 );
+
+	for ( int half = 0; half < 2; half++ )
+	{
+		uint32	bits	= 0;
+
+		for ( int i = 0; i < 8; i++ )
+		{
+			bits |= uint32( aIndices[ half * 8 + i ] ) << ( i * 3 );
+		}
+
+		pDst[ 2 + half * 3 ] = uint8( bits );
+		pDst[ 3 + half * 3 ] = uint8( bits >> 8 );
+		pDst[ 4 + half * 3 ] = uint8( bits >> 16 );
+	}
+}
+
+// Chooses the closest palette entry for each texel of a block. The endpoints are put in 4-color order if possible.
+// Returns the total squared error.
+
+int FitColorIndices( uint8 const * pBlock, int * pC0, int * pC1, uint32 * pIndices )
+{
+	if ( *pC0 < *pC1 )
+	{
+		std::swap( *pC0, *pC1 );
+	}
+
+	int	aPalette[ 4 ][ 3 ];
+
+	BuildColorPalette( *pC0, *pC1, true, aPalette );
+
+	// If the endpoints are the same, the block is a single color and index 0 is used for every texel
+
+	int const	nColors	= ( *pC0 == *pC1 ) ? 1 : 4;
+	uint32		indices	= 0;
+	int			error	= 0;
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		uint8 const * const	pTexel		= pBlock + i * 4;
+		int					best		= 0;
+		int					bestError	= INT_MAX;
+
+		for ( int j = 0; j < nColors; j++ )
+		{
+			int const	dr	= pTexel[ 0 ] - aPalette[ j ][ 0 ];
+			int const	dg	= pTexel[ 1 ] - aPalette[ j ][ 1 ];
+			int const	db	= pTexel[ 2 ] - aPalette[ j ][ 2 ];
+			int const	e	= dr * dr + dg * dg + db * db;
+
+			if ( e < bestError )
+			{
+				best		= j;
+				bestError	= e;
+			}
+		}
+
+		indices |= uint32( best ) << ( i * 2 );
+		error += bestError;
+	}
+
+	*pIndices = indices;
+
+	return error;
+}
+
+// Chooses the closest palette entry for each alpha value of a block. Returns the total squared error.
+
+int FitAlphaIndices( uint8 const * pBlock, int a0, int a1, int * aIndices )
+{
+	int	aPalette[ 8 ];
+	int	error	= 0;
+
+	BuildAlphaPalette( a0, a1, aPalette );
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		int const	alpha		= pBlock[ i * 4 + 3 ];
+		int			best		= 0;
+		int			bestError	= INT_MAX;
+
+		for ( int j = 0; j < 8; j++ )
+		{
+			int const	e	= ( alpha - aPalette[ j ] ) * ( alpha - aPalette[ j ] );
+
+			if ( e < bestError )
+			{
+				best		= j;
+				bestError	= e;
+			}
+		}
+
+		aIndices[ i ] = best;
+		error += bestError;
+	}
+
+	return error;
+}
+
+// Compresses the color of a block using its inset bounding box. Indices are chosen by projecting each texel onto
+// the line between the endpoints.
+
+void CompressColorFast( uint8 const * pBlock, uint8 * pDst )
+{
+	uint8	aMin[ 4 ];
+	uint8	aMax[ 4 ];
+
+	GetBounds( pBlock, aMin, aMax );
+
+	// Move the endpoints in by 1/16 of the range. Outliers are less important than the texels in between.
+
+	for ( int c = 0; c < 3; c++ )
+	{
+		int const	inset	= ( aMax[ c ] - aMin[ c ] ) >> 4;
+
+		aMin[ c ] = uint8( aMin[ c ] + inset );
+		aMax[ c ] = uint8( aMax[ c ] - inset );
+	}
+
+	int	c0	= To565( aMax[ 0 ], aMax[ 1 ], aMax[ 2 ] );
+	int	c1	= To565( aMin[ 0 ], aMin[ 1 ], aMin[ 2 ] );
+
+	if ( c0 == c1 )
+	{
+		WriteColorBlock( c0, c1, 0, pDst );
+		return;
+	}
+
+	if ( c0 < c1 )
+	{
+		std::swap( c0, c1 );
+	}
+
+	int	aPalette[ 4 ][ 3 ];
+
+	BuildColorPalette( c0, c1, true, aPalette );
+
+	int const	dr		= aPalette[ 0 ][ 0 ] - aPalette[ 1 ][ 0 ];
+	int const	dg		= aPalette[ 0 ][ 1 ] - aPalette[ 1 ][ 1 ];
+	int const	db		= aPalette[ 0 ][ 2 ] - aPalette[ 1 ][ 2 ];
+	int const	length2	= dr * dr + dg * dg + db * db;
+	uint32		indices	= 0;
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		uint8 const * const	pTexel	= pBlock + i * 4;
+		int const			t		= ( pTexel[ 0 ] - aPalette[ 1 ][ 0 ] ) * dr +
+									  ( pTexel[ 1 ] - aPalette[ 1 ][ 1 ] ) * dg +
+									  ( pTexel[ 2 ] - aPalette[ 1 ][ 2 ] ) * db;
+		int					step;
+
+		if ( t <= 0 )
+		{
+			step = 0;
+		}
+		else if ( t >= length2 )
+		{
+			step = 3;
+		}
+		else
+		{
+			step = ( 6 * t + length2 ) / ( 2 * length2 );
+		}
+
+		indices |= uint32( s_aColorIndexMap[ step ] ) << ( i * 2 );
+	}
+
+	WriteColorBlock( c0, c1, indices, pDst );
+}
+
+// Converts a floating point color to 5:6:5
+
+inline int To565( float const * pRgb )
+{
+	int	aRgb[ 3 ];
+
+	for ( int c = 0; c < 3; c++ )
+	{
+		aRgb[ c ] = std::min( std::max( int( pRgb[ c ] + 0.5f ), 0 ), 255 );
+	}
+
+	return To565( aRgb[ 0 ], aRgb[ 1 ], aRgb[ 2 ] );
+}
+
+// Compresses the color of a block by fitting the endpoints to the principal axis of the colors and then refining
+// them by least squares. The bounding box endpoints are also tried, and the best result is kept.
+
+void CompressColorHigh( uint8 const * pBlock, uint8 * pDst )
+{
+	// Find the mean and the covariance of the colors
+
+	float	aMean[ 3 ]	= { 0.0f, 0.0f, 0.0f };
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		for ( int c = 0; c < 3; c++ )
+		{
+			aMean[ c ] += pBlock[ i * 4 + c ];
+		}
+	}
+
+	for ( int c = 0; c < 3; c++ )
+	{
+		aMean[ c ] /= 16.0f;
+	}
+
+	float	aCovariance[ 6 ]	= { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };	// rr, rg, rb, gg, gb, bb
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		float const	r	= pBlock[ i * 4 + 0 ] - aMean[ 0 ];
+		float const	g	= pBlock[ i * 4 + 1 ] - aMean[ 1 ];
+		float const	b	= pBlock[ i * 4 + 2 ] - aMean[ 2 ];
+
+		aCovariance[ 0 ] += r * r;
+		aCovariance[ 1 ] += r * g;
+		aCovariance[ 2 ] += r * b;
+		aCovariance[ 3 ] += g * g;
+		aCovariance[ 4 ] += g * b;
+		aCovariance[ 5 ] += b * b;
+	}
+
+	// Find the principal axis by power iteration
+
+	float	aAxis[ 3 ]	= { 1.0f, 1.0f, 1.0f };
+
+	for ( int i = 0; i < POWER_ITERATIONS; i++ )
+	{
+		float const	x	= aCovariance[ 0 ] * aAxis[ 0 ] + aCovariance[ 1 ] * aAxis[ 1 ] + aCovariance[ 2 ] * aAxis[ 2 ];
+		float const	y	= aCovariance[ 1 ] * aAxis[ 0 ] + aCovariance[ 3 ] * aAxis[ 1 ] + aCovariance[ 4 ] * aAxis[ 2 ];
+		float const	z	= aCovariance[ 2 ] * aAxis[ 0 ] + aCovariance[ 4 ] * aAxis[ 1 ] + aCovariance[ 5 ] * aAxis[ 2 ];
+		float const	m	= std::max( std::max( fabsf( x ), fabsf( y ) ), fabsf( z ) );
+
+		if ( m == 0.0f )
+		{
+			break;
+		}
+
+		aAxis[ 0 ] = x / m;
+		aAxis[ 1 ] = y / m;
+		aAxis[ 2 ] = z / m;
+	}
+
+	// The endpoints are the extremes of the colors projected onto the axis
+
+	float const	length2	= aAxis[ 0 ] * aAxis[ 0 ] + aAxis[ 1 ] * aAxis[ 1 ] + aAxis[ 2 ] * aAxis[ 2 ];
+	float		minT	= 0.0f;
+	float		maxT	= 0.0f;
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		float const	t	= ( ( pBlock[ i * 4 + 0 ] - aMean[ 0 ] ) * aAxis[ 0 ] +
+							( pBlock[ i * 4 + 1 ] - aMean[ 1 ] ) * aAxis[ 1 ] +
+							( pBlock[ i * 4 + 2 ] - aMean[ 2 ] ) * aAxis[ 2 ] ) / length2;
+
+		minT = std::min( minT, t );
+		maxT = std::max( maxT, t );
+	}
+
+	float	aEnd0[ 3 ];
+	float	aEnd1[ 3 ];
+
+	for ( int c = 0; c < 3; c++ )
+	{
+		aEnd0[ c ] = aMean[ c ] + aAxis[ c ] * maxT;
+		aEnd1[ c ] = aMean[ c ] + aAxis[ c ] * minT;
+	}
+
+	int		c0			= To565( aEnd0 );
+	int		c1			= To565( aEnd1 );
+	uint32	indices;
+	int		error		= FitColorIndices( pBlock, &c0, &c1, &indices );
+
+	// Try the bounding box too
+
+	{
+		uint8	aMin[ 4 ];
+		uint8	aMax[ 4 ];
+
+		GetBounds( pBlock, aMin, aMax );
+
+		int		b0			= To565( aMax[ 0 ], aMax[ 1 ], aMax[ 2 ] );
+		int		b1			= To565( aMin[ 0 ], aMin[ 1 ], aMin[ 2 ] );
+		uint32	boxIndices;
+		int		boxError	= FitColorIndices( pBlock, &b0, &b1, &boxIndices );
+
+		if ( boxError < error )
+		{
+			c0		= b0;
+			c1		= b1;
+			indices	= boxIndices;
+			error	= boxError;
+		}
+	}
+
+	// Given the indices, find the endpoints that minimize the error, and repeat as long as the error goes down
+
+	static float const	s_aWeights[ 4 ]	= { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	for ( int step = 0; step < LEAST_SQUARES_STEPS && error > 0 && c0 != c1; step++ )
+	{
+		float	aa		= 0.0f;
+		float	ab		= 0.0f;
+		float	bb		= 0.0f;
+		float	aX[ 3 ]	= { 0.0f, 0.0f, 0.0f };
+		float	bX[ 3 ]	= { 0.0f, 0.0f, 0.0f };
+
+		for ( int i = 0; i < 16; i++ )
+		{
+			float const	w0	= s_aWeights[ ( indices >> ( i * 2 ) ) & 3 ];
+			float const	w1	= 1.0f - w0;
+
+			aa += w0 * w0;
+			ab += w0 * w1;
+			bb += w1 * w1;
+
+			for ( int c = 0; c < 3; c++ )
+			{
+				aX[ c ] += w0 * pBlock[ i * 4 + c ];
+				bX[ c ] += w1 * pBlock[ i * 4 + c ];
+			}
+		}
+
+		float const	determinant	= aa * bb - ab * ab;
+
+		if ( fabsf( determinant ) < 1.e-6f )
+		{
+			break;
+		}
+
+		for ( int c = 0; c < 3; c++ )
+		{
+			aEnd0[ c ] = ( bb * aX[ c ] - ab * bX[ c ] ) / determinant;
+			aEnd1[ c ] = ( aa * bX[ c ] - ab * aX[ c ] ) / determinant;
+		}
+
+		int		n0			= To565( aEnd0 );
+		int		n1			= To565( aEnd1 );
+		uint32	newIndices;
+		int		newError	= FitColorIndices( pBlock, &n0, &n1, &newIndices );
+
+		if ( newError >= error )
+		{
+			break;
+		}
+
+		c0		= n0;
+		c1		= n1;
+		indices	= newIndices;
+		error	= newError;
+	}
+
+	WriteColorBlock( c0, c1, indices, pDst );
+}
+
+// Compresses the alpha of a block using its range, in the 8-value mode. Indices are chosen by projection.
+
+void CompressAlphaFast( uint8 const * pBlock, uint8 * pDst )
+{
+	uint8	aMin[ 4 ];
+	uint8	aMax[ 4 ];
+
+	GetBounds( pBlock, aMin, aMax );
+
+	int const	a0			= aMax[ 3 ];
+	int const	a1			= aMin[ 3 ];
+	int const	range		= a0 - a1;
+	int			aIndices[ 16 ];
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		if ( range == 0 )
+		{
+			aIndices[ i ] = 0;
+		}
+		else
+		{
+			int const	step	= ( ( pBlock[ i * 4 + 3 ] - a1 ) * 14 + range ) / ( 2 * range );
+
+			aIndices[ i ] = ( step == 7 ) ? 0 : ( step == 0 ) ? 1 : 8 - step;
+		}
+	}
+
+	WriteAlphaBlock( a0, a1, aIndices, pDst );
+}
+
+// Compresses the alpha of a block in both the 8-value mode and the 6-value mode (which has exact 0 and 255), and
+// keeps the better one.
+
+void CompressAlphaHigh( uint8 const * pBlock, uint8 * pDst )
+{
+	int	min8	= 255;
+	int	max8	= 0;
+	int	min6	= 255;
+	int	max6	= 0;
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		int const	alpha	= pBlock[ i * 4 + 3 ];
+
+		min8 = std::min( min8, alpha );
+		max8 = std::max( max8, alpha );
+
+		if ( alpha != 0 && alpha != 255 )
+		{
+			min6 = std::min( min6, alpha );
+			max6 = std::max( max6, alpha );
+		}
+	}
+
+	if ( min6 > max6 )
+	{
+		min6 = max6 = 0;
+	}
+
+	int			aIndices8[ 16 ];
+	int			aIndices6[ 16 ];
+	int const	error8	= FitAlphaIndices( pBlock, max8, min8, aIndices8 );
+	int const	error6	= FitAlphaIndices( pBlock, min6, max6, aIndices6 );
+
+	if ( error6 < error8 )
+	{
+		WriteAlphaBlock( min6, max6, aIndices6, pDst );
+	}
+	else
+	{
+		WriteAlphaBlock( max8, min8, aIndices8, pDst );
+	}
+}
+
+// Decodes a BC1 color block into 16 RGBA texels. Blocks in BC3 are always decoded in 4-color mode.
+
+void DecodeColorBlock( uint8 const * pSrc, bool bAlwaysFourColor, uint8 * pBlock )
+{
+	int const	c0		= pSrc[ 0 ] | ( pSrc[ 1 ] << 8 );
+	int const	c1		= pSrc[ 2 ] | ( pSrc[ 3 ] << 8 );
+	uint32		indices	= pSrc[ 4 ] | ( pSrc[ 5 ] << 8 ) | ( pSrc[ 6 ] << 16 ) | ( uint32( pSrc[ 7 ] ) << 24 );
+	int			aPalette[ 4 ][ 3 ];
+
+	BuildColorPalette( c0, c1, bAlwaysFourColor || c0 > c1, aPalette );
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		int const * const	pColor	= aPalette[ ( indices >> ( i * 2 ) ) & 3 ];
+
+		pBlock[ i * 4 + 0 ] = uint8( pColor[ 0 ] );
+		pBlock[ i * 4 + 1 ] = uint8( pColor[ 1 ] );
+		pBlock[ i * 4 + 2 ] = uint8( pColor[ 2 ] );
+		pBlock[ i * 4 + 3 ] = 255;
+	}
+}
+
+// Decodes a BC3 alpha block into the alpha components of 16 RGBA texels
+
+void DecodeAlphaBlock( uint8 const * pSrc, uint8 * pBlock )
+{
+	int	aPalette[ 8 ];
+
+	BuildAlphaPalette( pSrc[ 0 ], pSrc[ 1 ], aPalette );
+
+	for ( int half = 0; half < 2; half++ )
+	{
+		uint32 const	bits	= pSrc[ 2 + half * 3 ] | ( pSrc[ 3 + half * 3 ] << 8 ) | ( pSrc[ 4 + half * 3 ] << 16 );
+
+		for ( int i = 0; i < 8; i++ )
+		{
+			pBlock[ ( half * 8 + i ) * 4 + 3 ] = uint8( aPalette[ ( bits >> ( i * 3 ) ) & 7 ] );
+		}
+	}
+}
+
+// Returns the number of bytes in a block of the format
+
+inline int GetBlockSize( GlObjects::DxtCompressor::Format format )
+{
+	return ( format == GlObjects::DxtCompressor::FORMAT_BC1 ) ? 8 : 16;
+}
+
+// Gets the extension entry points. Returns false if they are not available.
+
+bool InitializeEntryPoints()
+{
+	if ( s_glCompressedTexImage2DARB == 0 )
+	{
+		s_glCompressedTexImage2DARB = (CompressedTexImage2DProc) wglGetProcAddress( "glCompressedTexImage2DARB" );
+	}
+
+	return s_glCompressedTexImage2DARB != 0;
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// An image being compressed
+
+struct DxtCompressor::Image
+{
+	uint8 const *	pSrc;			///< The source image
+	int				width;			///< Width of the source image
+	int				height;			///< Height of the source image
+	Layout			layout;			///< Layout of the source texels
+	Format			format;			///< The compressed format
+	uint8 *			pDst;			///< The compressed image
+	int				blocksWide;		///< Number of blocks in a row
+	int				blocksHigh;		///< Number of rows of blocks
+	int				bandHeight;		///< Number of rows of blocks in a band
+	int				nBands;			///< Number of bands
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	quality		Compression quality
+/// @param	nThreads	Number of threads (including the calling thread) that compress an image. If 0, the number of
+///						processors is used.
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the worker threads cannot be created.
+
+DxtCompressor::DxtCompressor( Quality	quality		/* = QUALITY_FAST*/,
+							  int		nThreads	/* = 0*/ )
+	: m_Quality( quality ),
+	m_hWorkAvailable( NULL ),
+	m_hWorkDone( NULL ),
+	m_pImage( 0 ),
+	m_NextBand( 0 ),
+	m_bShutdown( false )
+{
+	if ( nThreads <= 0 )
+	{
+		SYSTEM_INFO	info;
+		GetSystemInfo( &info );
+		nThreads = info.dwNumberOfProcessors;
+	}
+
+	// The calling thread does some of the work, so one less worker is needed
+
+	int const	nWorkers	= nThreads - 1;
+
+	if ( nWorkers > 0 )
+	{
+		m_hWorkAvailable	= CreateSemaphore( NULL, 0, LONG_MAX, NULL );
+		m_hWorkDone			= CreateSemaphore( NULL, 0, LONG_MAX, NULL );
+
+		if ( m_hWorkAvailable == NULL || m_hWorkDone == NULL )
+		{
+			Shutdown();
+			throw std::runtime_error( "Unable to create synchronization objects" );
+		}
+
+		m_WorkerThreads.reserve( nWorkers );
+
+		for ( int i = 0; i < nWorkers; i++ )
+		{
+			HANDLE const	hThread	= (HANDLE)_beginthreadex( NULL, 0, WorkerThread, this, 0, NULL );
+
+			if ( hThread == 0 )
+			{
+				Shutdown();
+				throw std::runtime_error( "Unable to create worker thread" );
+			}
+
+			m_WorkerThreads.push_back( hThread );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+DxtCompressor::~DxtCompressor()
+{
+	Shutdown();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If the width or height is not a multiple of 4, the texels along the right or top edge are repeated to fill the
+/// blocks. BC1 does not store alpha, so the alpha component of the source (if any) is ignored.
+///
+/// @param	pSrc		The source image
+/// @param	width		Width of the source image
+/// @param	height		Height of the source image
+/// @param	srcFormat	Format of the source texels (@c GL_BGR_EXT, @c GL_BGRA_EXT, @c GL_RGB, @c GL_RGBA,
+///						@c GL_LUMINANCE, or @c GL_LUMINANCE_ALPHA). Each component is one byte.
+/// @param	format		The compressed format
+/// @param	pDst		Where to put the compressed image. It must hold at least GetCompressedSize() bytes.
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the source format is not supported.
+
+void DxtCompressor::Compress( uint8 const * pSrc, int width, int height, GLenum srcFormat, Format format, uint8 * pDst )
+{
+	assert( width > 0 && height > 0 );
+
+	Image	image;
+
+	image.pSrc			= pSrc;
+	image.width			= width;
+	image.height		= height;
+	image.layout		= GetLayout( srcFormat );
+	image.format		= format;
+	image.pDst			= pDst;
+	image.blocksWide	= ( width + 3 ) / 4;
+	image.blocksHigh	= ( height + 3 ) / 4;
+
+	int const	nThreads	= int( m_WorkerThreads.size() ) + 1;
+
+	// Small images aren't worth splitting up
+
+	if ( nThreads == 1 || image.blocksWide * image.blocksHigh < MIN_PARALLEL_BLOCKS )
+	{
+		CompressRows( image, 0, image.blocksHigh );
+		return;
+	}
+
+	int const	nBands	= std::min( image.blocksHigh, nThreads * BANDS_PER_THREAD );
+
+	image.bandHeight	= ( image.blocksHigh + nBands - 1 ) / nBands;
+	image.nBands		= ( image.blocksHigh + image.bandHeight - 1 ) / image.bandHeight;
+
+	// Wake up the workers and help them
+
+	int const	nWorkers	= std::min( int( m_WorkerThreads.size() ), image.nBands - 1 );
+
+	m_pImage	= &image;
+	m_NextBand	= 0;
+
+	ReleaseSemaphore( m_hWorkAvailable, nWorkers, NULL );
+
+	CompressBands( image );
+
+	for ( int i = 0; i < nWorkers; i++ )
+	{
+		WaitForSingleObject( m_hWorkDone, INFINITE );
+	}
+
+	m_pImage = 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function is the reference decoder for the compressed formats. The output can be compared with the source
+/// image to measure the quality of the compression without a GPU.
+///
+/// @param	pSrc		The compressed image
+/// @param	width		Width of the image
+/// @param	height		Height of the image
+/// @param	format		The compressed format
+/// @param	pDst		Where to put the decompressed image (32-bit RGBA). Alpha is 255 if the format is BC1.
+
+void DxtCompressor::Decompress( uint8 const * pSrc, int width, int height, Format format, uint8 * pDst )
+{
+	int const	blocksWide	= ( width + 3 ) / 4;
+	int const	blocksHigh	= ( height + 3 ) / 4;
+	int const	blockSize	= GetBlockSize( format );
+	uint8		aBlock[ 16 * 4 ];
+
+	for ( int by = 0; by < blocksHigh; by++ )
+	{
+		for ( int bx = 0; bx < blocksWide; bx++ )
+		{
+			if ( format == FORMAT_BC3 )
+			{
+				DecodeColorBlock( pSrc + 8, true, aBlock );
+				DecodeAlphaBlock( pSrc, aBlock );
+			}
+			else
+			{
+				DecodeColorBlock( pSrc, false, aBlock );
+			}
+
+			pSrc += blockSize;
+
+			// Copy the texels that are inside the image
+
+			int const	w	= std::min( 4, width - bx * 4 );
+			int const	h	= std::min( 4, height - by * 4 );
+
+			for ( int y = 0; y < h; y++ )
+			{
+				memcpy( pDst + ( size_t( by * 4 + y ) * width + bx * 4 ) * 4, aBlock + y * 16, w * 4 );
+			}
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The compressed image is decompressed with Decompress() and compared with the source image. Alpha is only compared
+/// if the format is BC3.
+///
+/// @param	pSrc		The source image
+/// @param	width		Width of the image
+/// @param	height		Height of the image
+/// @param	srcFormat	Format of the source texels (see Compress())
+/// @param	format		The compressed format
+/// @param	pCompressed	The compressed image
+///
+/// @return		The root-mean-square difference of the components, in the range 0 - 255
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the source format is not supported.
+
+double DxtCompressor::GetRmsError( uint8 const *	pSrc,
+								   int				width,
+								   int				height,
+								   GLenum			srcFormat,
+								   Format			format,
+								   uint8 const *	pCompressed )
+{
+	Layout const			layout		= GetLayout( srcFormat );
+	size_t const			nTexels		= size_t( width ) * height;
+	int const				nComponents	= ( format == FORMAT_BC3 ) ? 4 : 3;
+	std::vector< uint8 >	decompressed( nTexels * 4 );
+
+	Decompress( pCompressed, width, height, format, &decompressed[ 0 ] );
+
+	double	sum	= 0.0;
+
+	for ( size_t i = 0; i < nTexels; i++ )
+	{
+		uint8 const * const	pTexel		= pSrc + i * layout.texelSize;
+		uint8 const * const	pDecoded	= &decompressed[ i * 4 ];
+		int const			aSource[ 4 ]	=
+		{
+			pTexel[ layout.r ],
+			pTexel[ layout.g ],
+			pTexel[ layout.b ],
+			( layout.a >= 0 ) ? pTexel[ layout.a ] : 255
+		};
+
+		for ( int c = 0; c < nComponents; c++ )
+		{
+			int const	d	= aSource[ c ] - pDecoded[ c ];
+
+			sum += d * d;
+		}
+	}
+
+	return sqrt( sum / ( double( nTexels ) * nComponents ) );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+size_t DxtCompressor::GetCompressedSize( int width, int height, Format format )
+{
+	return size_t( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * GetBlockSize( format );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+GLenum DxtCompressor::GetInternalFormat( Format format )
+{
+	return ( format == FORMAT_BC1 ) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool DxtCompressor::IsUploadSupported()
+{
+	return Glx::Extension::IsSupported( "GL_ARB_texture_compression" ) &&
+		   Glx::Extension::IsSupported( "GL_EXT_texture_compression_s3tc" ) &&
+		   InitializeEntryPoints();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function must be called by the thread that owns the GL context, and IsUploadSupported() must have returned
+/// @c true.
+///
+/// @param	level			Mip level
+/// @param	width			Width of the level
+/// @param	height			Height of the level
+/// @param	internalFormat	Compressed internal format (see GetInternalFormat())
+/// @param	size			Size of the compressed data
+/// @param	pData			The compressed data
+
+void DxtCompressor::Upload( int level, int width, int height, GLenum internalFormat, size_t size, void const * pData )
+{
+	assert( s_glCompressedTexImage2DARB != 0 );
+
+	s_glCompressedTexImage2DARB( GL_TEXTURE_2D, level, internalFormat, width, height, 0, GLsizei( size ), pData );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void DxtCompressor::CompressBands( Image const & image )
+{
+	for ( ;; )
+	{
+		int const	band	= InterlockedIncrement( &m_NextBand ) - 1;
+
+		if ( band >= image.nBands )
+		{
+			break;
+		}
+
+		int const	by0	= band * image.bandHeight;
+		int const	by1	= std::min( by0 + image.bandHeight, image.blocksHigh );
+
+		CompressRows( image, by0, by1 );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void DxtCompressor::CompressRows( Image const & image, int by0, int by1 ) const
+{
+	int const	blockSize	= GetBlockSize( image.format );
+	bool const	bHigh		= ( m_Quality == QUALITY_HIGH );
+	uint8		aBlock[ 16 * 4 ];
+
+	for ( int by = by0; by < by1; by++ )
+	{
+		uint8 *	pDst	= image.pDst + size_t( by ) * image.blocksWide * blockSize;
+
+		for ( int bx = 0; bx < image.blocksWide; bx++ )
+		{
+			FetchBlock( image.pSrc, image.width, image.height, image.layout, bx, by, aBlock );
+
+			if ( image.format == FORMAT_BC3 )
+			{
+				if ( bHigh )
+				{
+					CompressAlphaHigh( aBlock, pDst );
+				}
+				else
+				{
+					CompressAlphaFast( aBlock, pDst );
+				}
+				pDst += 8;
+			}
+
+			if ( bHigh )
+			{
+				CompressColorHigh( aBlock, pDst );
+			}
+			else
+			{
+				CompressColorFast( aBlock, pDst );
+			}
+			pDst += 8;
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void DxtCompressor::Shutdown()
+{
+	m_bShutdown = true;
+
+	if ( !m_WorkerThreads.empty() )
+	{
+		ReleaseSemaphore( m_hWorkAvailable, LONG( m_WorkerThreads.size() ), NULL );
+	}
+
+	for ( std::vector< HANDLE >::iterator pThread = m_WorkerThreads.begin(); pThread != m_WorkerThreads.end(); ++pThread )
+	{
+		WaitForSingleObject( *pThread, INFINITE );
+		CloseHandle( *pThread );
+	}
+	m_WorkerThreads.clear();
+
+	if ( m_hWorkAvailable != NULL )
+	{
+		CloseHandle( m_hWorkAvailable );
+		m_hWorkAvailable = NULL;
+	}
+
+	if ( m_hWorkDone != NULL )
+	{
+		CloseHandle( m_hWorkDone );
+		m_hWorkDone = NULL;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+unsigned __stdcall DxtCompressor::WorkerThread( void * pArg )
+{
+	static_cast< DxtCompressor * >( pArg )->Work();
+
+	return 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void DxtCompressor::Work()
+{
+	for ( ;; )
+	{
+		WaitForSingleObject( m_hWorkAvailable, INFINITE );
+
+		if ( m_bShutdown )
+		{
+			break;
+		}
+
+		CompressBands( *m_pImage );
+
+		ReleaseSemaphore( m_hWorkDone, 1, NULL );
+	}
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,129 @@
+#if !defined( GLOBJECTS_DXTCOMPRESSOR_H_INCLUDED )
+#define GLOBJECTS_DXTCOMPRESSOR_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  DxtCompressor.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/DxtCompressor.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <vector>
+#include <gl/gl.h>
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Compresses images into S3TC (DXT) blocks on the CPU.
+///
+/// BC1 (DXT1) stores the color of each 4x4 block of texels in 8 bytes. BC3 (DXT5) adds 8 bytes of interpolated alpha.
+/// The rows of blocks are split into bands that are compressed in parallel by a pool of worker threads. The calling
+/// thread compresses bands too, and small images are compressed entirely by the calling thread.
+///
+/// In the fast mode, the endpoints of each block are taken from the (slightly inset) bounding box of its colors, which
+/// is computed with SSE2. In the high-quality mode, the endpoints are fit to the principal axis of the colors and then
+/// refined by least squares, and both alpha interpolation modes are tried.
+///
+/// Blocks are stored in the same order as the rows of the source image, so the compressed data can be uploaded with
+/// @c glCompressedTexImage2D exactly as the uncompressed data would be uploaded with @c glTexImage2D.
+
+class DxtCompressor
+{
+public:
+
+	/// Compressed formats
+	enum Format
+	{
+		FORMAT_BC1,				///< DXT1: RGB, 4 bits per texel
+		FORMAT_BC3				///< DXT5: RGBA, 8 bits per texel
+	};
+
+	/// Compression quality
+	enum Quality
+	{
+		QUALITY_FAST,			///< Bounding-box endpoints
+		QUALITY_HIGH			///< Principal-axis endpoints refined by least squares
+	};
+
+	/// Constructor
+	DxtCompressor( Quality quality = QUALITY_FAST, int nThreads = 0 );
+
+	/// Destructor
+	~DxtCompressor();
+
+	/// Compresses an image
+	void Compress( uint8 const * pSrc, int width, int height, GLenum srcFormat, Format format, uint8 * pDst );
+
+	/// Decompresses an image into 32-bit RGBA texels
+	static void Decompress( uint8 const * pSrc, int width, int height, Format format, uint8 * pDst );
+
+	/// Returns the RMS difference between an image and its compressed version
+	static double GetRmsError( uint8 const * pSrc, int width, int height, GLenum srcFormat,
+							   Format format, uint8 const * pCompressed );
+
+	/// Returns the size of a compressed image
+	static size_t GetCompressedSize( int width, int height, Format format );
+
+	/// Returns the GL internal format of a compressed format
+	static GLenum GetInternalFormat( Format format );
+
+	/// Returns @c true if compressed textures can be uploaded by the current context
+	static bool IsUploadSupported();
+
+	/// Uploads a compressed level of the bound 2D texture
+	static void Upload( int level, int width, int height, GLenum internalFormat, size_t size, void const * pData );
+
+private:
+
+	struct Image;
+
+	// Prevent copying
+	DxtCompressor( DxtCompressor const & );
+	DxtCompressor & operator =( DxtCompressor const & );
+
+	// Compresses bands of the image until there are none left
+	void CompressBands( Image const & image );
+
+	// Compresses rows of blocks by0 through by1-1 of the image
+	void CompressRows( Image const & image, int by0, int by1 ) const;
+
+	// Stops the workers
+	void Shutdown();
+
+	// Worker thread entry point
+	static unsigned __stdcall WorkerThread( void * pArg );
+
+	// Worker thread loop
+	void Work();
+
+	Quality					m_Quality;			///< Compression quality
+	std::vector< HANDLE >	m_WorkerThreads;	///< The worker threads
+	HANDLE					m_hWorkAvailable;	///< Released once for each worker that should compress bands
+	HANDLE					m_hWorkDone;		///< Released by each worker when there are no bands left
+	Image const *			m_pImage;			///< The image being compressed
+	LONG volatile			m_NextBand;			///< The next band to be compressed
+	bool volatile			m_bShutdown;		///< Set when the workers must exit
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_DXTCOMPRESSOR_H_INCLUDED )
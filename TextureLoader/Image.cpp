@@ -0,0 +1,316 @@
+/** @file *//********************************************************************************************************
+
+                                                     Image.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/Image.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "Image.h"
+
+#include "TgaImage.h"
+
+#include <algorithm>
+#include <cassert>
+#include <malloc.h>
+#include <new>
+#include <stdexcept>
+
+namespace
+{
+
+// Allocates an aligned buffer for an Image. The buffer is freed unless it is released.
+
+class AlignedAllocator : public GlObjects::TgaImageAllocator
+{
+public:
+
+	AlignedAllocator()
+		: m_pBuffer( 0 )
+	{
+	}
+
+	virtual ~AlignedAllocator()
+	{
+		_aligned_free( m_pBuffer );
+	}
+
+	virtual uint8 * Allocate( size_t size )
+	{
+		_aligned_free( m_pBuffer );
+		m_pBuffer = static_cast< uint8 * >( _aligned_malloc( std::max( size, size_t( 1 ) ), GlObjects::Image::ALIGNMENT ) );
+
+		return m_pBuffer;
+	}
+
+	// Gives up ownership of the buffer
+	uint8 * Release()
+	{
+		uint8 * const	pBuffer	= m_pBuffer;
+
+		m_pBuffer = 0;
+
+		return pBuffer;
+	}
+
+private:
+
+	uint8 *	m_pBuffer;
+};
+
+// Minimum number of samples taken across a preview. Small previews average several samples per texel.
+
+int const	MIN_PREVIEW_SAMPLES	= 16;
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+Image::Image()
+	: m_Width( 0 ),
+	m_Height( 0 ),
+	m_Format( GL_RGBA ),
+	m_TexelSize( 0 ),
+	m_pData( 0 ),
+	m_pBuffer( 0 )
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	width		Width in texels
+/// @param	height		Height in texels
+/// @param	format		GL format of the texels
+/// @param	texelSize	Bytes per texel
+///
+/// @warning	This function throws a <tt>std::bad_alloc</tt> if the buffer can't be allocated.
+
+Image::Image( int width, int height, GLenum format, int texelSize )
+	: m_Width( width ),
+	m_Height( height ),
+	m_Format( format ),
+	m_TexelSize( texelSize ),
+	m_pData( 0 ),
+	m_pBuffer( 0 )
+{
+	assert( width > 0 && height > 0 && texelSize > 0 );
+
+	m_pBuffer = static_cast< uint8 * >( _aligned_malloc( GetSize(), ALIGNMENT ) );
+	if ( m_pBuffer == 0 ) throw std::bad_alloc();
+
+	m_pData = m_pBuffer;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	width		Width in texels
+/// @param	height		Height in texels
+/// @param	format		GL format of the texels
+/// @param	texelSize	Bytes per texel
+/// @param	pData		The texels. They must remain valid for the lifetime of the image.
+
+Image::Image( int width, int height, GLenum format, int texelSize, uint8 const * pData )
+	: m_Width( width ),
+	m_Height( height ),
+	m_Format( format ),
+	m_TexelSize( texelSize ),
+	m_pData( pData ),
+	m_pBuffer( 0 )
+{
+	assert( width > 0 && height > 0 && texelSize > 0 );
+	assert( pData != 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+Image::~Image()
+{
+	_aligned_free( m_pBuffer );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The file format must be 24-bit or 32-bit truecolor, or 8-bit or 16-bit grayscale, and may be run-length encoded.
+/// Any previous contents of the image are released first.
+///
+/// If the texels can be used in place in a memory-mapped file (see TGA_LOAD_MAP), they are borrowed from the file,
+/// which is kept open by the image. Otherwise they are decoded into memory from @a pAllocator, or into a buffer owned
+/// by the image if @a pAllocator is 0.
+///
+/// @param	sFileName	Name of the file to load
+/// @param	flags		Options (a combination of TgaLoadFlags)
+/// @param	pAllocator	If not 0, supplies the memory the texels are decoded into. The memory must remain valid for
+///						the lifetime of the image.
+///
+/// @warning	This function may throw a ConstructorFailedException, <tt>std::runtime_error</tt>, or a
+///				<tt>std::bad_alloc</tt>. If it does, the image is empty.
+
+void Image::LoadTga( char const * sFileName, unsigned flags, TgaImageAllocator * pAllocator/* = 0*/ )
+{
+	Reset();
+
+	AlignedAllocator	allocator;
+	TgaImage			tga;
+
+	LoadTgaImage( sFileName, flags, &tga, ( pAllocator != 0 ) ? pAllocator : &allocator );
+
+	m_Width			= tga.width;
+	m_Height		= tga.height;
+	m_Format		= tga.format;
+	m_TexelSize		= tga.texelSize;
+	m_pData			= tga.pData;
+	m_pBuffer		= allocator.Release();
+	m_qMappedFile	= tga.qMappedFile;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The file is memory-mapped and point-sampled on a grid, so only the rows that are sampled are read. Each texel of
+/// the preview is the average of its samples. A size of 1 gives the average color of the image. The preview is
+/// always BGRA, whatever the format of the file. Any previous contents of the image are released first.
+///
+/// @param	sFileName	Name of the file to preview
+/// @param	size		Width and height of the preview
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the file can't be mapped or is not an uncompressed
+///				24-bit or 32-bit truecolor, or 8-bit or 16-bit grayscale image. It throws a <tt>std::bad_alloc</tt> if
+///				the buffer can't be allocated. If it throws, the image is empty.
+
+void Image::LoadTgaPreview( char const * sFileName, int size )
+{
+	assert( size > 0 );
+
+	Reset();
+
+	MappedTgaFile const	file( sFileName );
+
+	bool const	bGrayscale	= ( file.m_ImageType == MappedTgaFile::IMAGE_GRAYSCALE );
+	int const	texelSize	= file.m_Depth / 8;
+
+	if ( ( file.m_ImageType != MappedTgaFile::IMAGE_TRUECOLOR && !bGrayscale ) ||
+		 ( file.m_Order != MappedTgaFile::ORDER_BOTTOMLEFT && file.m_Order != MappedTgaFile::ORDER_TOPLEFT ) )
+	{
+		throw std::runtime_error( "The file can't be previewed" );
+	}
+
+	if ( ( bGrayscale ? ( texelSize != 1 && texelSize != 2 ) : ( texelSize != 3 && texelSize != 4 ) ) ||
+		 file.m_Width <= 0 || file.m_Height <= 0 ||
+		 file.GetPixelDataSize() < size_t( file.m_Width ) * file.m_Height * texelSize )
+	{
+		throw std::runtime_error( "Invalid pixel format" );
+	}
+
+	int const	k			= ( size >= MIN_PREVIEW_SAMPLES ) ? 1 : ( MIN_PREVIEW_SAMPLES + size - 1 ) / size;
+	int const	nSamples	= size * k;
+	bool const	bFlip		= ( file.m_Order == MappedTgaFile::ORDER_TOPLEFT );
+
+	uint8 * const	pBuffer	= static_cast< uint8 * >( _aligned_malloc( size_t( size ) * size * 4, ALIGNMENT ) );
+	if ( pBuffer == 0 ) throw std::bad_alloc();
+
+	uint8 *	pDest	= pBuffer;
+
+	for ( int y = 0; y < size; y++ )
+	{
+		for ( int x = 0; x < size; x++ )
+		{
+			int	aSums[ 4 ]	= { 0, 0, 0, 0 };
+
+			for ( int j = 0; j < k; j++ )
+			{
+				int const		sy		= int( ( ( y * k + j ) * 2 + 1 ) * uint64( file.m_Height ) / ( nSamples * 2 ) );
+				int const		row		= bFlip ? file.m_Height - 1 - sy : sy;
+				uint8 const *	pRow	= file.GetPixels() + size_t( row ) * file.m_Width * texelSize;
+
+				for ( int i = 0; i < k; i++ )
+				{
+					int const		sx	= int( ( ( x * k + i ) * 2 + 1 ) * uint64( file.m_Width ) / ( nSamples * 2 ) );
+					uint8 const *	p	= pRow + sx * texelSize;
+
+					if ( bGrayscale )
+					{
+						aSums[ 0 ] += p[ 0 ];
+						aSums[ 1 ] += p[ 0 ];
+						aSums[ 2 ] += p[ 0 ];
+						aSums[ 3 ] += ( texelSize == 2 ) ? p[ 1 ] : 255;
+					}
+					else
+					{
+						aSums[ 0 ] += p[ 0 ];
+						aSums[ 1 ] += p[ 1 ];
+						aSums[ 2 ] += p[ 2 ];
+						aSums[ 3 ] += ( texelSize == 4 ) ? p[ 3 ] : 255;
+					}
+				}
+			}
+
+			for ( int c = 0; c < 4; c++ )
+			{
+				*pDest++ = uint8( ( aSums[ c ] + k * k / 2 ) / ( k * k ) );
+			}
+		}
+	}
+
+	m_Width		= size;
+	m_Height	= size;
+	m_Format	= GL_BGRA_EXT;
+	m_TexelSize	= 4;
+	m_pData		= pBuffer;
+	m_pBuffer	= pBuffer;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void Image::Reset()
+{
+	_aligned_free( m_pBuffer );
+	m_qMappedFile.reset();
+
+	m_Width		= 0;
+	m_Height	= 0;
+	m_TexelSize	= 0;
+	m_pData		= 0;
+	m_pBuffer	= 0;
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,126 @@
+#if !defined( GLOBJECTS_IMAGE_H_INCLUDED )
+#define GLOBJECTS_IMAGE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                      Image.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/Image.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <memory>
+#include <gl/gl.h>
+#include "MappedTgaFile.h"
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+class TgaImageAllocator;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// An uncompressed image in CPU memory, ready to be uploaded.
+///
+/// The texels are tightly packed, bottom row first, in the GL format given by GetFormat() with a type of
+/// @c GL_UNSIGNED_BYTE. They are either in a buffer owned by the image, which is aligned to ALIGNMENT bytes, or in
+/// memory borrowed from someone else (an allocator, a memory-mapped file, or the caller).
+///
+/// An image has nothing to do with GL, so images can be created, decoded, and processed on any thread. Uploading
+/// an image is a separate step (see TextureLoader::Upload()).
+
+class Image
+{
+public:
+
+	/// Alignment of an owned buffer
+	static size_t const	ALIGNMENT	= 16;
+
+	/// Constructor. The image is empty.
+	Image();
+
+	/// Constructor. The image owns an uninitialized buffer.
+	Image( int width, int height, GLenum format, int texelSize );
+
+	/// Constructor. The image borrows the caller's texels.
+	Image( int width, int height, GLenum format, int texelSize, uint8 const * pData );
+
+	/// Destructor
+	~Image();
+
+	/// Decodes a TGA file
+	void LoadTga( char const * sFileName, unsigned flags, TgaImageAllocator * pAllocator = 0 );
+
+	/// Creates a small BGRA preview of an uncompressed TGA file without reading all of it
+	void LoadTgaPreview( char const * sFileName, int size );
+
+	/// Returns @c true if the image has no texels
+	bool IsEmpty() const						{ return m_pData == 0; }
+
+	/// Returns the width in texels
+	int GetWidth() const						{ return m_Width; }
+
+	/// Returns the height in texels
+	int GetHeight() const						{ return m_Height; }
+
+	/// Returns the GL format of the texels
+	GLenum GetFormat() const					{ return m_Format; }
+
+	/// Returns the GL type of the texels
+	GLenum GetType() const						{ return GL_UNSIGNED_BYTE; }
+
+	/// Returns the number of bytes per texel
+	int GetTexelSize() const					{ return m_TexelSize; }
+
+	/// Returns the number of bytes in the image
+	size_t GetSize() const						{ return size_t( m_Width ) * m_Height * m_TexelSize; }
+
+	/// Returns the texels
+	uint8 const * GetData() const				{ return m_pData; }
+
+	/// Returns the texels if the image owns its buffer, or 0 if they are borrowed
+	uint8 * GetBuffer()							{ return m_pBuffer; }
+
+	/// Returns @c true if the image owns its buffer
+	bool IsOwner() const						{ return m_pBuffer != 0; }
+
+	/// Returns @c true if the texels are aligned to ALIGNMENT bytes
+	bool IsAligned() const						{ return ( size_t( m_pData ) & ( ALIGNMENT - 1 ) ) == 0; }
+
+	/// Releases the texels and empties the image
+	void Reset();
+
+private:
+
+	// Prevent copying
+	Image( Image const & );
+	Image & operator =( Image const & );
+
+	int								m_Width;		///< Width in texels
+	int								m_Height;		///< Height in texels
+	GLenum							m_Format;		///< GL format of the texels
+	int								m_TexelSize;	///< Bytes per texel
+	uint8 const *					m_pData;		///< The texels
+	uint8 *							m_pBuffer;		///< The buffer owned by the image, or 0
+	std::auto_ptr< MappedTgaFile >	m_qMappedFile;	///< Set if the texels are borrowed from a mapped file
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_IMAGE_H_INCLUDED )
@@ -0,0 +1,111 @@
+/** @file *//********************************************************************************************************
+
+                                                   MappedFile.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/MappedFile.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "MappedFile.h"
+
+#include "Misc/Types.h"
+
+#include <stdexcept>
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	sFileName	Name of the file to map
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the file cannot be opened and mapped, or if it is
+///				empty.
+
+MappedFile::MappedFile( char const * sFileName )
+	: m_hFile( INVALID_HANDLE_VALUE ),
+	m_hMapping( NULL ),
+	m_pView( 0 ),
+	m_Size( 0 )
+{
+	m_hFile = CreateFile( sFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if ( m_hFile == INVALID_HANDLE_VALUE ) throw std::runtime_error( "Unable to open file" );
+
+	DWORD const	size	= GetFileSize( m_hFile, NULL );
+	if ( size == INVALID_FILE_SIZE || size == 0 )
+	{
+		Close();
+		throw std::runtime_error( "Unable to map file" );
+	}
+
+	m_hMapping = CreateFileMapping( m_hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( m_hMapping == NULL )
+	{
+		Close();
+		throw std::runtime_error( "Unable to map file" );
+	}
+
+	m_pView = static_cast< uint8 const * >( MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 ) );
+	if ( m_pView == 0 )
+	{
+		Close();
+		throw std::runtime_error( "Unable to map file" );
+	}
+
+	m_Size = size;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void MappedFile::Close()
+{
+	if ( m_pView != 0 )
+	{
+		UnmapViewOfFile( m_pView );
+		m_pView = 0;
+	}
+
+	if ( m_hMapping != NULL )
+	{
+		CloseHandle( m_hMapping );
+		m_hMapping = NULL;
+	}
+
+	if ( m_hFile != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( m_hFile );
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+
+	m_Size = 0;
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,69 @@
+#if !defined( GLOBJECTS_MAPPEDFILE_H_INCLUDED )
+#define GLOBJECTS_MAPPEDFILE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                    MappedFile.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/MappedFile.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A read-only memory-mapped file
+
+class MappedFile
+{
+public:
+
+	/// Constructor
+	MappedFile( char const * sFileName );
+
+	/// Destructor
+	~MappedFile();
+
+	/// Returns a pointer to the contents of the file
+	uint8 const * GetData() const		{ return m_pView; }
+
+	/// Returns the size of the file
+	size_t GetSize() const				{ return m_Size; }
+
+private:
+
+	// Prevent copying
+	MappedFile( MappedFile const & );
+	MappedFile & operator =( MappedFile const & );
+
+	// Unmaps the file and closes the handles
+	void Close();
+
+	HANDLE			m_hFile;			///< The file
+	HANDLE			m_hMapping;			///< The file mapping object
+	uint8 const *	m_pView;			///< The mapped view of the file
+	size_t			m_Size;				///< Size of the file
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_MAPPEDFILE_H_INCLUDED )
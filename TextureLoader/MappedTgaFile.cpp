@@ -0,0 +1,100 @@
+/** @file *//********************************************************************************************************
+
+                                                  MappedTgaFile.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/MappedTgaFile.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "MappedTgaFile.h"
+
+#include "Misc/Types.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace
+{
+
+size_t const	HEADER_SIZE	= 18;	// Size of the fixed part of a TGA file header
+
+// Returns the little-endian 16-bit value at p
+inline int GetUint16( uint8 const * p )
+{
+	return p[0] | ( p[1] << 8 );
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	sFileName	Name of the file to map
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the file cannot be opened and mapped, or if the
+///				header is not valid.
+
+MappedTgaFile::MappedTgaFile( char const * sFileName )
+	: m_File( sFileName ),
+	m_pPixels( 0 ),
+	m_PixelDataSize( 0 )
+{
+	size_t const	fileSize	= m_File.GetSize();
+
+	if ( fileSize < HEADER_SIZE ) throw std::runtime_error( "Invalid TGA file" );
+
+	// Parse the header
+
+	uint8 const * const	pHeader			= m_File.GetData();
+	int const			idLength		= pHeader[ 0 ];
+	int const			colorMapType	= pHeader[ 1 ];
+	int const			colorMapLength	= GetUint16( &pHeader[ 5 ] );
+	int const			colorMapDepth	= pHeader[ 7 ];
+	int const			descriptor		= pHeader[ 17 ];
+
+	m_ImageType		= pHeader[ 2 ];
+	m_Width			= GetUint16( &pHeader[ 12 ] );
+	m_Height		= GetUint16( &pHeader[ 14 ] );
+	m_Depth			= pHeader[ 16 ];
+	m_AlphaDepth	= descriptor & 0x0f;
+
+	switch ( descriptor & 0x30 )
+	{
+	case 0x00:	m_Order = ORDER_BOTTOMLEFT;		break;
+	case 0x10:	m_Order = ORDER_BOTTOMRIGHT;	break;
+	case 0x20:	m_Order = ORDER_TOPLEFT;		break;
+	default:	m_Order = ORDER_TOPRIGHT;		break;
+	}
+
+	// Locate the pixel data (it follows the image id and the color map)
+
+	size_t	offset	= HEADER_SIZE + idLength;
+
+	if ( colorMapType != 0 )
+	{
+		offset += colorMapLength * ( ( colorMapDepth + 7 ) / 8 );
+	}
+
+	if ( offset > fileSize ) throw std::runtime_error( "Invalid TGA file" );
+
+	m_pPixels		= m_File.GetData() + offset;
+	m_PixelDataSize	= fileSize - offset;
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,93 @@
+#if !defined( GLOBJECTS_MAPPEDTGAFILE_H_INCLUDED )
+#define GLOBJECTS_MAPPEDTGAFILE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                   MappedTgaFile.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/MappedTgaFile.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <cstddef>
+#include "MappedFile.h"
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A TGA file that is memory-mapped rather than read.
+///
+/// The header is parsed from the mapped view and the pixel data can be accessed in place, so an uncompressed image
+/// whose layout already matches what GL expects can be uploaded without being copied.
+
+class MappedTgaFile
+{
+public:
+
+	/// Image types (as specified by the TGA file format)
+	enum ImageType
+	{
+		IMAGE_NONE				= 0,
+		IMAGE_COLORMAPPED		= 1,
+		IMAGE_TRUECOLOR			= 2,
+		IMAGE_GRAYSCALE			= 3,
+		IMAGE_RLE_COLORMAPPED	= 9,
+		IMAGE_RLE_TRUECOLOR		= 10,
+		IMAGE_RLE_GRAYSCALE		= 11
+	};
+
+	/// Location of the first pixel in the file
+	enum Order
+	{
+		ORDER_BOTTOMLEFT,
+		ORDER_BOTTOMRIGHT,
+		ORDER_TOPLEFT,
+		ORDER_TOPRIGHT
+	};
+
+	/// Constructor
+	MappedTgaFile( char const * sFileName );
+
+	/// Returns a pointer to the pixel data in the mapped file
+	uint8 const * GetPixels() const		{ return m_pPixels; }
+
+	/// Returns the number of bytes in the mapped file following the header
+	size_t GetPixelDataSize() const		{ return m_PixelDataSize; }
+
+	int		m_ImageType;		///< Image type
+	int		m_Width;			///< Width of the image in pixels
+	int		m_Height;			///< Height of the image in pixels
+	int		m_Depth;			///< Bits per pixel
+	int		m_AlphaDepth;		///< Bits of alpha per pixel
+	Order	m_Order;			///< Location of the first pixel
+
+private:
+
+	// Prevent copying
+	MappedTgaFile( MappedTgaFile const & );
+	MappedTgaFile & operator =( MappedTgaFile const & );
+
+	MappedFile		m_File;				///< The mapped file
+	uint8 const *	m_pPixels;			///< Start of the pixel data in the view
+	size_t			m_PixelDataSize;	///< Number of bytes from the start of the pixel data to the end of the file
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_MAPPEDTGAFILE_H_INCLUDED )
@@ -0,0 +1,838 @@
+/** @file *//********************************************************************************************************
+
+                                                 MipMapGenerator.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/MipMapGenerator.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "MipMapGenerator.h"
+
+#include "ScopedUnpackAlignment.h"
+#include "ScratchArena.h"
+
+#include "Glx/MipMappedTexture.h"
+#include "Misc/auto_array_ptr.h"
+#include "Misc/Types.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <emmintrin.h>
+#include <gl/gl.h>
+#include <new>
+#include <process.h>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+int const		KAISER_TAPS			= 8;		// Number of taps in each dimension of the Kaiser filter
+double const	KAISER_ALPHA		= 4.0;		// Shape of the Kaiser window
+int const		MIN_PARALLEL_SIZE	= 128 * 128;	// Levels smaller than this (in texels) are not split into bands
+int const		BANDS_PER_THREAD	= 4;		// Number of bands each thread gets (on average)
+
+LONG volatile	s_TablesInitialized	= 0;				// Set when the tables below have been built
+float			s_aByteToFloat[ 256 ];					// Byte value -> [0,1]
+float			s_aSrgbToLinear[ 256 ];					// sRGB-encoded byte value -> linear [0,1]
+uint16			s_aSrgbToLinear16[ 256 ];				// sRGB-encoded byte value -> linear [0,65535]
+uint8			s_aLinear16ToSrgb[ 65536 ];				// Linear [0,65535] -> sRGB-encoded byte value
+float			s_aKaiserWeights[ KAISER_TAPS ];		// Weights of the Kaiser filter taps
+
+// Zeroth-order modified Bessel function of the first kind
+
+double BesselI0( double x )
+{
+	double	sum		= 1.0;
+	double	term	= 1.0;
+	double	k		= 1.0;
+
+	do
+	{
+		term *= ( x * x ) / ( 4.0 * k * k );
+		sum += term;
+		k += 1.0;
+	} while ( term > sum * 1.e-12 );
+
+	return sum;
+}
+
+// Builds the conversion tables and the filter weights. They are the same every time, so it doesn't matter if two
+// threads build them at the same time.
+
+void InitializeTables()
+{
+	if ( s_TablesInitialized != 0 )
+	{
+		return;
+	}
+
+	for ( int i = 0; i < 256; i++ )
+	{
+		double const	s	= i / 255.0;
+		double const	l	= ( s <= 0.04045 ) ? s / 12.92 : pow( ( s + 0.055 ) / 1.055, 2.4 );
+
+		s_aByteToFloat[ i ]		= float( s );
+		s_aSrgbToLinear[ i ]	= float( l );
+		s_aSrgbToLinear16[ i ]	= uint16( l * 65535.0 + 0.5 );
+	}
+
+	for ( int i = 0; i < 65536; i++ )
+	{
+		double const	l	= i / 65535.0;
+		double const	s	= ( l <= 0.0031308 ) ? l * 12.92 : 1.055 * pow( l, 1.0 / 2.4 ) - 0.055;
+
+		s_aLinear16ToSrgb[ i ] = uint8( s * 255.0 + 0.5 );
+	}
+
+	// The filter is a sinc with a cutoff at half the source frequency, windowed by a Kaiser window. The taps are
+	// centered between the two source texels that correspond to each destination texel.
+
+	double	sum	= 0.0;
+	double	aWeights[ KAISER_TAPS ];
+
+	for ( int i = 0; i < KAISER_TAPS; i++ )
+	{
+		double const	d		= i - ( KAISER_TAPS - 1 ) * 0.5;
+		double const	x		= 3.14159265358979323846 * d * 0.5;
+		double const	sinc	= ( x != 0.0 ) ? sin( x ) / x : 1.0;
+		double const	r		= d / ( KAISER_TAPS * 0.5 );
+		double const	window	= BesselI0( KAISER_ALPHA * sqrt( 1.0 - r * r ) ) / BesselI0( KAISER_ALPHA );
+
+		aWeights[ i ] = sinc * window;
+		sum += aWeights[ i ];
+	}
+
+	for ( int i = 0; i < KAISER_TAPS; i++ )
+	{
+		s_aKaiserWeights[ i ] = float( aWeights[ i ] / sum );
+	}
+
+	InterlockedExchange( &s_TablesInitialized, 1 );
+}
+
+// Returns the index of the alpha component of a texel, or -1 if it has none
+
+inline int GetAlphaIndex( int texelSize )
+{
+	return ( texelSize == 2 || texelSize == 4 ) ? texelSize - 1 : -1;
+}
+
+// Converts a filtered value back to a byte
+
+inline uint8 ToByte( float v, bool bSrgb )
+{
+	if ( v <= 0.0f ) return 0;
+	if ( v >= 1.0f ) return 255;
+
+	return bSrgb ? s_aLinear16ToSrgb[ int( v * 65535.0f + 0.5f ) ] : uint8( v * 255.0f + 0.5f );
+}
+
+/********************************************************************************************************************/
+/* Box filter																										*/
+/********************************************************************************************************************/
+
+// Filters one row of any texel size
+
+void BoxRow( uint8 const * pRow0, uint8 const * pRow1, int srcWidth, int texelSize, uint8 * pDst, int dstWidth )
+{
+	for ( int x = 0; x < dstWidth; x++ )
+	{
+		int const			sx0	= 2 * x;
+		int const			sx1	= std::min( 2 * x + 1, srcWidth - 1 );
+		uint8 const * const	p00	= pRow0 + sx0 * texelSize;
+		uint8 const * const	p01	= pRow0 + sx1 * texelSize;
+		uint8 const * const	p10	= pRow1 + sx0 * texelSize;
+		uint8 const * const	p11	= pRow1 + sx1 * texelSize;
+
+		for ( int c = 0; c < texelSize; c++ )
+		{
+			*pDst++ = uint8( ( p00[ c ] + p01[ c ] + p10[ c ] + p11[ c ] + 2 ) >> 2 );
+		}
+	}
+}
+
+// Filters one row of any texel size in linear space
+
+void BoxRowGamma( uint8 const * pRow0, uint8 const * pRow1, int srcWidth, int texelSize, uint8 * pDst, int dstWidth )
+{
+	int const	alpha	= GetAlphaIndex( texelSize );
+
+	for ( int x = 0; x < dstWidth; x++ )
+	{
+		int const			sx0	= 2 * x;
+		int const			sx1	= std::min( 2 * x + 1, srcWidth - 1 );
+		uint8 const * const	p00	= pRow0 + sx0 * texelSize;
+		uint8 const * const	p01	= pRow0 + sx1 * texelSize;
+		uint8 const * const	p10	= pRow1 + sx0 * texelSize;
+		uint8 const * const	p11	= pRow1 + sx1 * texelSize;
+
+		for ( int c = 0; c < texelSize; c++ )
+		{
+			if ( c == alpha )
+			{
+				*pDst++ = uint8( ( p00[ c ] + p01[ c ] + p10[ c ] + p11[ c ] + 2 ) >> 2 );
+			}
+			else
+			{
+				int const	sum	= s_aSrgbToLinear16[ p00[ c ] ] + s_aSrgbToLinear16[ p01[ c ] ] +
+								  s_aSrgbToLinear16[ p10[ c ] ] + s_aSrgbToLinear16[ p11[ c ] ];
+
+				*pDst++ = s_aLinear16ToSrgb[ ( sum + 2 ) >> 2 ];
+			}
+		}
+	}
+}
+
+// Filters one row of 32-bit texels using SSE2. The source row must be at least twice as wide as the destination row.
+
+void BoxRow4Sse2( uint8 const * pRow0, uint8 const * pRow1, uint8 * pDst, int dstWidth )
+{
+	__m128i const	zero	= _mm_setzero_si128();
+	__m128i const	two		= _mm_set1_epi16( 2 );
+	int				x		= 0;
+
+	// 8 source texels from each row make 4 destination texels
+
+	for ( ; x + 4 <= dstWidth; x += 4 )
+	{
+		__m128i const	a0	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pRow0 + x * 8 ) );
+		__m128i const	a1	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pRow0 + x * 8 + 16 ) );
+		__m128i const	b0	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pRow1 + x * 8 ) );
+		__m128i const	b1	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pRow1 + x * 8 + 16 ) );
+
+		// Add the rows (each register holds 2 texels of 16-bit components)
+
+		__m128i const	s0	= _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+		__m128i const	s1	= _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+		__m128i const	s2	= _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+		__m128i const	s3	= _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+		// Add adjacent texels (the sums end up in the low halves)
+
+		__m128i const	h0	= _mm_add_epi16( s0, _mm_srli_si128( s0, 8 ) );
+		__m128i const	h1	= _mm_add_epi16( s1, _mm_srli_si128( s1, 8 ) );
+		__m128i const	h2	= _mm_add_epi16( s2, _mm_srli_si128( s2, 8 ) );
+		__m128i const	h3	= _mm_add_epi16( s3, _mm_srli_si128( s3, 8 ) );
+
+		__m128i const	lo	= _mm_srli_epi16( _mm_add_epi16( _mm_unpacklo_epi64( h0, h1 ), two ), 2 );
+		__m128i const	hi	= _mm_srli_epi16( _mm_add_epi16( _mm_unpacklo_epi64( h2, h3 ), two ), 2 );
+
+		_mm_storeu_si128( reinterpret_cast< __m128i * >( pDst + x * 4 ), _mm_packus_epi16( lo, hi ) );
+	}
+
+	// The rest
+
+	if ( x < dstWidth )
+	{
+		BoxRow( pRow0 + x * 8, pRow1 + x * 8, ( dstWidth - x ) * 2, 4, pDst + x * 4, dstWidth - x );
+	}
+}
+
+// Filters one row of 24-bit texels using SSE2. The source row must be at least twice as wide as the destination row.
+
+void BoxRow3Sse2( uint8 const * pRow0, uint8 const * pRow1, uint8 * pDst, int dstWidth )
+{
+	__m128i const	zero	= _mm_setzero_si128();
+	__m128i const	two		= _mm_set1_epi16( 2 );
+	__m128i const	m012	= _mm_set_epi16( 0, 0, 0, 0, 0, -1, -1, -1 );
+	__m128i const	m34		= _mm_set_epi16( 0, 0, 0, -1, -1, 0, 0, 0 );
+	__m128i const	m5		= _mm_set_epi16( 0, 0, -1, 0, 0, 0, 0, 0 );
+	__m128i const	m67		= _mm_set_epi16( -1, -1, 0, 0, 0, 0, 0, 0 );
+	__m128i const	m0		= _mm_set_epi16( 0, 0, 0, 0, 0, 0, 0, -1 );
+	__m128i const	m123	= _mm_set_epi16( 0, 0, 0, 0, -1, -1, -1, 0 );
+	int				x		= 0;
+
+	// 8 source texels (24 bytes) from each row make 4 destination texels (12 bytes)
+
+	for ( ; x + 4 <= dstWidth; x += 4 )
+	{
+		__m128i const	a0	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pRow0 + x * 6 ) );
+		__m128i const	a1	= _mm_loadl_epi64( reinterpret_cast< __m128i const * >( pRow0 + x * 6 + 16 ) );
+		__m128i const	b0	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pRow1 + x * 6 ) );
+		__m128i const	b1	= _mm_loadl_epi64( reinterpret_cast< __m128i const * >( pRow1 + x * 6 + 16 ) );
+
+		// Add the rows. The 24 components are in 16-bit lanes, c0-c7, c8-c15, and c16-c23.
+
+		__m128i const	r0	= _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+		__m128i const	r1	= _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+		__m128i const	r2	= _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+
+		// Add each component to the same component of the next texel, 3 lanes over. The sums of texels 0+1, 2+3,
+		// 4+5, and 6+7 end up in lanes 0-2 and 6-7 of s0, lanes 0 and 4-6 of s1, and lanes 2-4 of s2.
+
+		__m128i const	s0	= _mm_add_epi16( r0, _mm_or_si128( _mm_srli_si128( r0, 6 ), _mm_slli_si128( r1, 10 ) ) );
+		__m128i const	s1	= _mm_add_epi16( r1, _mm_or_si128( _mm_srli_si128( r1, 6 ), _mm_slli_si128( r2, 10 ) ) );
+		__m128i const	s2	= _mm_add_epi16( r2, _mm_srli_si128( r2, 6 ) );
+
+		__m128i const	v0	= _mm_srli_epi16( _mm_add_epi16( s0, two ), 2 );
+		__m128i const	v1	= _mm_srli_epi16( _mm_add_epi16( s1, two ), 2 );
+		__m128i const	v2	= _mm_srli_epi16( _mm_add_epi16( s2, two ), 2 );
+
+		// Gather the 12 destination components into consecutive lanes
+
+		__m128i const	lo	= _mm_or_si128( _mm_or_si128( _mm_and_si128( v0, m012 ),
+														  _mm_and_si128( _mm_srli_si128( v0, 6 ), m34 ) ),
+										_mm_or_si128( _mm_and_si128( _mm_slli_si128( v1, 10 ), m5 ),
+													  _mm_and_si128( _mm_slli_si128( v1, 4 ), m67 ) ) );
+		__m128i const	hi	= _mm_or_si128( _mm_and_si128( _mm_srli_si128( v1, 12 ), m0 ),
+										_mm_and_si128( _mm_srli_si128( v2, 2 ), m123 ) );
+		__m128i const	d	= _mm_packus_epi16( lo, hi );
+
+		_mm_storel_epi64( reinterpret_cast< __m128i * >( pDst + x * 3 ), d );
+		*reinterpret_cast< int * >( pDst + x * 3 + 8 ) = _mm_cvtsi128_si32( _mm_srli_si128( d, 8 ) );
+	}
+
+	// The rest
+
+	if ( x < dstWidth )
+	{
+		BoxRow( pRow0 + x * 6, pRow1 + x * 6, ( dstWidth - x ) * 2, 3, pDst + x * 3, dstWidth - x );
+	}
+}
+
+/********************************************************************************************************************/
+/* Kaiser filter																									*/
+/********************************************************************************************************************/
+
+// Filters destination rows y0 through y1-1. The filter is separable, so the source rows under the band are filtered
+// horizontally into a temporary buffer and then the buffer is filtered vertically.
+
+void KaiserRows( uint8 const * pSrc, int srcWidth, int srcHeight,
+				 uint8 * pDst, int dstWidth,
+				 int texelSize, bool bGammaCorrect,
+				 int y0, int y1 )
+{
+	int const		alpha		= GetAlphaIndex( texelSize );
+	int const		firstRow	= 2 * y0 - ( KAISER_TAPS / 2 - 1 );
+	int const		nRows		= 2 * ( y1 - y0 ) + KAISER_TAPS - 2;
+	int const		rowSize		= dstWidth * texelSize;
+	float const *	apTables[ 4 ];
+
+	for ( int c = 0; c < texelSize; c++ )
+	{
+		apTables[ c ] = ( bGammaCorrect && c != alpha ) ? s_aSrgbToLinear : s_aByteToFloat;
+	}
+
+	std::vector< float >	horizontal( size_t( nRows ) * rowSize );
+
+	// Horizontal pass
+
+	for ( int r = 0; r < nRows; r++ )
+	{
+		int const			sy		= std::min( std::max( firstRow + r, 0 ), srcHeight - 1 );
+		uint8 const * const	pRow	= pSrc + size_t( sy ) * srcWidth * texelSize;
+		float *				pOut	= &horizontal[ size_t( r ) * rowSize ];
+
+		for ( int x = 0; x < dstWidth; x++ )
+		{
+			int const	firstColumn	= 2 * x - ( KAISER_TAPS / 2 - 1 );
+
+			for ( int c = 0; c < texelSize; c++ )
+			{
+				float	sum	= 0.0f;
+
+				for ( int i = 0; i < KAISER_TAPS; i++ )
+				{
+					int const	sx	= std::min( std::max( firstColumn + i, 0 ), srcWidth - 1 );
+
+					sum += s_aKaiserWeights[ i ] * apTables[ c ][ pRow[ sx * texelSize + c ] ];
+				}
+
+				*pOut++ = sum;
+			}
+		}
+	}
+
+	// Vertical pass
+
+	for ( int y = y0; y < y1; y++ )
+	{
+		float const * const	pIn		= &horizontal[ size_t( 2 * ( y - y0 ) ) * rowSize ];
+		uint8 *				pOut	= pDst + size_t( y ) * rowSize;
+
+		for ( int i = 0; i < rowSize; i++ )
+		{
+			float	sum	= 0.0f;
+
+			for ( int t = 0; t < KAISER_TAPS; t++ )
+			{
+				sum += s_aKaiserWeights[ t ] * pIn[ t * rowSize + i ];
+			}
+
+			*pOut++ = ToByte( sum, bGammaCorrect && ( i % texelSize ) != alpha );
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A level being built
+
+struct MipMapGenerator::Level
+{
+	uint8 const *	pSrc;			///< The previous level
+	int				srcWidth;		///< Width of the previous level
+	int				srcHeight;		///< Height of the previous level
+	uint8 *			pDst;			///< The level being built
+	int				dstWidth;		///< Width of the level being built
+	int				dstHeight;		///< Height of the level being built
+	int				texelSize;		///< Bytes per texel
+	int				bandHeight;		///< Number of rows in a band
+	int				nBands;			///< Number of bands
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	filter			The filter used to build each level from the previous level
+/// @param	bGammaCorrect	If @c true, the color components are assumed to be sRGB-encoded and are filtered in
+///							linear space.
+/// @param	nThreads		Number of threads that filter a level, including the calling thread. If 0, one thread
+///							per processor is used.
+///
+/// @warning	This function may throw a <tt>std::runtime_error</tt> or a <tt>std::bad_alloc</tt>.
+
+MipMapGenerator::MipMapGenerator( Filter	filter			/* = FILTER_BOX*/,
+								  bool		bGammaCorrect	/* = false*/,
+								  int		nThreads		/* = 0*/ )
+	: m_Filter( filter ),
+	m_bGammaCorrect( bGammaCorrect ),
+	m_hWorkAvailable( NULL ),
+	m_hWorkDone( NULL ),
+	m_pLevel( 0 ),
+	m_NextBand( 0 ),
+	m_Failed( 0 ),
+	m_bShutdown( false )
+{
+	InitializeTables();
+
+	if ( nThreads <= 0 )
+	{
+		SYSTEM_INFO	info;
+		GetSystemInfo( &info );
+		nThreads = info.dwNumberOfProcessors;
+	}
+
+	// The calling thread does some of the work, so one less worker is needed
+
+	int const	nWorkers	= nThreads - 1;
+
+	if ( nWorkers > 0 )
+	{
+		m_hWorkAvailable	= CreateSemaphore( NULL, 0, LONG_MAX, NULL );
+		m_hWorkDone			= CreateSemaphore( NULL, 0, LONG_MAX, NULL );
+
+		if ( m_hWorkAvailable == NULL || m_hWorkDone == NULL )
+		{
+			Shutdown();
+			throw std::runtime_error( "Unable to create synchronization objects" );
+		}
+
+		m_WorkerThreads.reserve( nWorkers );
+
+		for ( int i = 0; i < nWorkers; i++ )
+		{
+			HANDLE const	hThread	= (HANDLE)_beginthreadex( NULL, 0, WorkerThread, this, 0, NULL );
+
+			if ( hThread == 0 )
+			{
+				Shutdown();
+				throw std::runtime_error( "Unable to create worker thread" );
+			}
+
+			m_WorkerThreads.push_back( hThread );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+MipMapGenerator::~MipMapGenerator()
+{
+	Shutdown();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The size of the new level is half the size of the source level (but not less than 1) in each dimension.
+///
+/// @param	pSrc		The source level
+/// @param	width		Width of the source level
+/// @param	height		Height of the source level
+/// @param	texelSize	Bytes per texel (1 to 4)
+/// @param	pDst		Where to put the new level
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+void MipMapGenerator::BuildNextLevel( uint8 const * pSrc, int width, int height, int texelSize, uint8 * pDst )
+{
+	assert( texelSize >= 1 && texelSize <= 4 );
+
+	Level	level;
+
+	level.pSrc		= pSrc;
+	level.srcWidth	= width;
+	level.srcHeight	= height;
+	level.pDst		= pDst;
+	level.dstWidth	= std::max( width / 2, 1 );
+	level.dstHeight	= std::max( height / 2, 1 );
+	level.texelSize	= texelSize;
+
+	int const	nThreads	= int( m_WorkerThreads.size() ) + 1;
+
+	// Small levels aren't worth splitting up
+
+	if ( nThreads == 1 || level.dstWidth * level.dstHeight < MIN_PARALLEL_SIZE )
+	{
+		FilterRows( level, 0, level.dstHeight );
+		return;
+	}
+
+	int const	nBands	= std::min( level.dstHeight, nThreads * BANDS_PER_THREAD );
+
+	level.bandHeight	= ( level.dstHeight + nBands - 1 ) / nBands;
+	level.nBands		= ( level.dstHeight + level.bandHeight - 1 ) / level.bandHeight;
+
+	// Wake up the workers and help them
+
+	int const	nWorkers	= std::min( int( m_WorkerThreads.size() ), level.nBands - 1 );
+
+	m_pLevel	= &level;
+	m_NextBand	= 0;
+	m_Failed	= 0;
+
+	ReleaseSemaphore( m_hWorkAvailable, nWorkers, NULL );
+
+	FilterBands( level );
+
+	for ( int i = 0; i < nWorkers; i++ )
+	{
+		WaitForSingleObject( m_hWorkDone, INFINITE );
+	}
+
+	m_pLevel = 0;
+
+	if ( m_Failed != 0 ) throw std::bad_alloc();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pSrc		Level 0
+/// @param	width		Width of level 0
+/// @param	height		Height of level 0
+/// @param	texelSize	Bytes per texel (1 to 4)
+/// @param	pChain		Where to put the levels. It must hold at least GetChainSize() bytes.
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+void MipMapGenerator::BuildChain( uint8 const * pSrc, int width, int height, int texelSize, uint8 * pChain )
+{
+	while ( width > 1 || height > 1 )
+	{
+		BuildNextLevel( pSrc, width, height, texelSize, pChain );
+
+		width	= std::max( width / 2, 1 );
+		height	= std::max( height / 2, 1 );
+		pSrc	= pChain;
+		pChain	+= size_t( width ) * height * texelSize;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Each level is uploaded with Glx::MipMappedTexture::AddMipMap() as soon as it is built. This function must be
+/// called by the thread that owns the GL context.
+///
+/// @param	pTexture	The texture
+/// @param	pData		Level 0
+/// @param	width		Width of level 0
+/// @param	height		Height of level 0
+/// @param	texelSize	Bytes per texel (1 to 4)
+/// @param	pArena		If not 0, the levels are built in memory from this arena instead of the heap
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+void MipMapGenerator::BuildAllMipMaps( Glx::MipMappedTexture * pTexture, uint8 const * pData, int width, int height, int texelSize,
+									   ScratchArena * pArena /* = 0*/ )
+{
+	ScratchArena::Scope		scope( pArena );
+	auto_array_ptr< uint8 >	qaChain;
+	uint8 *					pLevel	= ScratchArena::AllocateBuffer( pArena, GetChainSize( width, height, texelSize ), qaChain );
+	ScopedUnpackAlignment	alignment;
+
+	pTexture->AddMipMap( 0, pData );
+
+	for ( int i = 1; width > 1 || height > 1; i++ )
+	{
+		BuildNextLevel( pData, width, height, texelSize, pLevel );
+
+		pTexture->AddMipMap( i, pLevel );
+
+		width	= std::max( width / 2, 1 );
+		height	= std::max( height / 2, 1 );
+		pData	= pLevel;
+		pLevel	+= size_t( width ) * height * texelSize;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function must be called by the thread that owns the GL context.
+///
+/// @param	pTexture	The texture
+/// @param	pChain		The levels built by BuildChain()
+/// @param	width		Width of level 0
+/// @param	height		Height of level 0
+/// @param	texelSize	Bytes per texel (1 to 4)
+
+void MipMapGenerator::UploadChain( Glx::MipMappedTexture * pTexture, uint8 const * pChain, int width, int height, int texelSize )
+{
+	ScopedUnpackAlignment	alignment;
+
+	for ( int i = 1; width > 1 || height > 1; i++ )
+	{
+		width	= std::max( width / 2, 1 );
+		height	= std::max( height / 2, 1 );
+
+		pTexture->AddMipMap( i, pChain );
+
+		pChain += size_t( width ) * height * texelSize;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+int MipMapGenerator::GetLevelCount( int width, int height )
+{
+	int	n	= 1;
+
+	while ( width > 1 || height > 1 )
+	{
+		width	= std::max( width / 2, 1 );
+		height	= std::max( height / 2, 1 );
+		++n;
+	}
+
+	return n;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+size_t MipMapGenerator::GetChainSize( int width, int height, int texelSize )
+{
+	size_t	size	= 0;
+
+	while ( width > 1 || height > 1 )
+	{
+		width	= std::max( width / 2, 1 );
+		height	= std::max( height / 2, 1 );
+		size	+= size_t( width ) * height * texelSize;
+	}
+
+	return size;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void MipMapGenerator::FilterBands( Level const & level )
+{
+	for ( ;; )
+	{
+		int const	band	= InterlockedIncrement( &m_NextBand ) - 1;
+
+		if ( band >= level.nBands )
+		{
+			break;
+		}
+
+		int const	y0	= band * level.bandHeight;
+		int const	y1	= std::min( y0 + level.bandHeight, level.dstHeight );
+
+		try
+		{
+			FilterRows( level, y0, y1 );
+		}
+		catch ( ... )
+		{
+			InterlockedExchange( &m_Failed, 1 );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void MipMapGenerator::FilterRows( Level const & level, int y0, int y1 ) const
+{
+	if ( m_Filter == FILTER_KAISER )
+	{
+		KaiserRows( level.pSrc, level.srcWidth, level.srcHeight,
+					level.pDst, level.dstWidth,
+					level.texelSize, m_bGammaCorrect,
+					y0, y1 );
+		return;
+	}
+
+	size_t const	srcRowSize	= size_t( level.srcWidth ) * level.texelSize;
+	size_t const	dstRowSize	= size_t( level.dstWidth ) * level.texelSize;
+	bool const		bSimd		= !m_bGammaCorrect &&
+								  ( level.texelSize == 3 || level.texelSize == 4 ) &&
+								  level.srcWidth > 1;
+
+	for ( int y = y0; y < y1; y++ )
+	{
+		uint8 const * const	pRow0	= level.pSrc + 2 * y * srcRowSize;
+		uint8 const * const	pRow1	= level.pSrc + std::min( 2 * y + 1, level.srcHeight - 1 ) * srcRowSize;
+		uint8 * const		pDst	= level.pDst + y * dstRowSize;
+
+		if ( bSimd && level.texelSize == 4 )
+		{
+			BoxRow4Sse2( pRow0, pRow1, pDst, level.dstWidth );
+		}
+		else if ( bSimd )
+		{
+			BoxRow3Sse2( pRow0, pRow1, pDst, level.dstWidth );
+		}
+		else if ( m_bGammaCorrect )
+		{
+			BoxRowGamma( pRow0, pRow1, level.srcWidth, level.texelSize, pDst, level.dstWidth );
+		}
+		else
+		{
+			BoxRow( pRow0, pRow1, level.srcWidth, level.texelSize, pDst, level.dstWidth );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void MipMapGenerator::Shutdown()
+{
+	m_bShutdown = true;
+
+	if ( !m_WorkerThreads.empty() )
+	{
+		ReleaseSemaphore( m_hWorkAvailable, LONG( m_WorkerThreads.size() ), NULL );
+	}
+
+	for ( std::vector< HANDLE >::iterator pThread = m_WorkerThreads.begin(); pThread != m_WorkerThreads.end(); ++pThread )
+	{
+		WaitForSingleObject( *pThread, INFINITE );
+		CloseHandle( *pThread );
+	}
+	m_WorkerThreads.clear();
+
+	if ( m_hWorkAvailable != NULL )
+	{
+		CloseHandle( m_hWorkAvailable );
+		m_hWorkAvailable = NULL;
+	}
+
+	if ( m_hWorkDone != NULL )
+	{
+		CloseHandle( m_hWorkDone );
+		m_hWorkDone = NULL;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+unsigned __stdcall MipMapGenerator::WorkerThread( void * pArg )
+{
+	static_cast< MipMapGenerator * >( pArg )->Work();
+
+	return 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void MipMapGenerator::Work()
+{
+	for ( ;; )
+	{
+		WaitForSingleObject( m_hWorkAvailable, INFINITE );
+
+		if ( m_bShutdown )
+		{
+			break;
+		}
+
+		FilterBands( *m_pLevel );
+
+		ReleaseSemaphore( m_hWorkDone, 1, NULL );
+	}
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,134 @@
+#if !defined( GLOBJECTS_MIPMAPGENERATOR_H_INCLUDED )
+#define GLOBJECTS_MIPMAPGENERATOR_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  MipMapGenerator.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/MipMapGenerator.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <vector>
+#include "Misc/Types.h"
+
+namespace Glx
+{
+	class MipMappedTexture;
+}
+
+namespace GlObjects
+{
+
+class ScratchArena;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Generates mip levels on the CPU.
+///
+/// Each level is split into bands of rows that are filtered in parallel by a pool of worker threads. The calling
+/// thread filters bands too, and small levels are filtered entirely by the calling thread. The box filter is
+/// vectorized with SSE2 for 24-bit and 32-bit texels, except in gamma-correct mode. Other texel sizes, gamma-correct
+/// mode, and the Kaiser-windowed sinc filter (available for higher quality) are filtered one component at a time.
+///
+/// In gamma-correct mode, the color components are assumed to be sRGB-encoded and are filtered in linear space. The
+/// alpha component (the last component of 16-bit and 32-bit texels) is always filtered as is.
+///
+/// Creating the worker threads is expensive, so a generator should be kept and reused for many images. The filter
+/// can be changed between images. A generator builds one level at a time, so it must not be used by more than one
+/// thread at a time.
+
+class MipMapGenerator
+{
+public:
+
+	/// Filters used to build a level from the previous level
+	enum Filter
+	{
+		FILTER_BOX,				///< 2x2 box filter
+		FILTER_KAISER			///< 8x8 Kaiser-windowed sinc filter
+	};
+
+	/// Constructor
+	MipMapGenerator( Filter filter = FILTER_BOX, bool bGammaCorrect = false, int nThreads = 0 );
+
+	/// Destructor
+	~MipMapGenerator();
+
+	/// Sets the filter used to build each level from the previous level
+	void SetFilter( Filter filter )						{ m_Filter = filter; }
+
+	/// Enables or disables filtering the color components in linear space
+	void SetGammaCorrect( bool bGammaCorrect )			{ m_bGammaCorrect = bGammaCorrect; }
+
+	/// Builds the next smaller mip level
+	void BuildNextLevel( uint8 const * pSrc, int width, int height, int texelSize, uint8 * pDst );
+
+	/// Builds levels 1 through n, storing them consecutively
+	void BuildChain( uint8 const * pSrc, int width, int height, int texelSize, uint8 * pChain );
+
+	/// Uploads level 0 and then builds and uploads the rest of the levels one at a time
+	void BuildAllMipMaps( Glx::MipMappedTexture * pTexture, uint8 const * pData, int width, int height, int texelSize,
+						  ScratchArena * pArena = 0 );
+
+	/// Uploads levels 1 through n built by BuildChain()
+	static void UploadChain( Glx::MipMappedTexture * pTexture, uint8 const * pChain, int width, int height, int texelSize );
+
+	/// Returns the number of levels in a full mip chain, including level 0
+	static int GetLevelCount( int width, int height );
+
+	/// Returns the size of levels 1 through n of a full mip chain
+	static size_t GetChainSize( int width, int height, int texelSize );
+
+private:
+
+	struct Level;
+
+	// Prevent copying
+	MipMapGenerator( MipMapGenerator const & );
+	MipMapGenerator & operator =( MipMapGenerator const & );
+
+	// Filters bands of the level until there are none left
+	void FilterBands( Level const & level );
+
+	// Filters rows y0 through y1-1 of the level
+	void FilterRows( Level const & level, int y0, int y1 ) const;
+
+	// Stops the workers
+	void Shutdown();
+
+	// Worker thread entry point
+	static unsigned __stdcall WorkerThread( void * pArg );
+
+	// Worker thread loop
+	void Work();
+
+	Filter					m_Filter;			///< The filter
+	bool					m_bGammaCorrect;	///< If true, color is filtered in linear space
+	std::vector< HANDLE >	m_WorkerThreads;	///< The worker threads
+	HANDLE					m_hWorkAvailable;	///< Released once for each worker that should filter bands
+	HANDLE					m_hWorkDone;		///< Released by each worker when there are no bands left
+	Level const *			m_pLevel;			///< The level being built
+	LONG volatile			m_NextBand;			///< The next band to be filtered
+	LONG volatile			m_Failed;			///< Set if filtering a band failed
+	bool volatile			m_bShutdown;		///< Set when the workers must exit
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_MIPMAPGENERATOR_H_INCLUDED )
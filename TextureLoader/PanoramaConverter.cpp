@@ -0,0 +1,533 @@
+/** @file *//********************************************************************************************************
+
+                                               PanoramaConverter.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/PanoramaConverter.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "PanoramaConverter.h"
+
+#include "BakedTextureFile.h"
+#include "Image.h"
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <emmintrin.h>
+#include <process.h>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+float const	PI			= 3.14159265358979323846f;
+int const	BAND_HEIGHT	= 8;		// Number of rows of a face sampled by a thread at a time
+int const	MAX_TAPS	= 4;		// Number of taps of the largest filter in each dimension
+
+// Returns the direction of the center of a texel of a cube map face, as specified by ARB_texture_cube_map. The
+// direction is not normalized.
+
+void GetTexelDirection( int face, int size, int x, int y, float d[ 3 ] )
+{
+	float const	sc	= float( 2 * x + 1 ) / size - 1.f;
+	float const	tc	= float( 2 * y + 1 ) / size - 1.f;
+
+	switch ( face )
+	{
+	case GlObjects::CubeMapTexture::FACE_POSITIVE_X:
+		d[ 0 ] = 1.f;	d[ 1 ] = -tc;	d[ 2 ] = -sc;
+		break;
+
+	case GlObjects::CubeMapTexture::FACE_NEGATIVE_X:
+		d[ 0 ] = -1.f;	d[ 1 ] = -tc;	d[ 2 ] = sc;
+		break;
+
+	case GlObjects::CubeMapTexture::FACE_POSITIVE_Y:
+		d[ 0 ] = sc;	d[ 1 ] = 1.f;	d[ 2 ] = tc;
+		break;
+
+	case GlObjects::CubeMapTexture::FACE_NEGATIVE_Y:
+		d[ 0 ] = sc;	d[ 1 ] = -1.f;	d[ 2 ] = -tc;
+		break;
+
+	case GlObjects::CubeMapTexture::FACE_POSITIVE_Z:
+		d[ 0 ] = sc;	d[ 1 ] = -tc;	d[ 2 ] = 1.f;
+		break;
+
+	default:	// FACE_NEGATIVE_Z
+		d[ 0 ] = -sc;	d[ 1 ] = -tc;	d[ 2 ] = -1.f;
+		break;
+	}
+}
+
+// Computes the taps of a filter in one dimension. The taps are wrapped or clamped to [0, size). Returns the number
+// of taps.
+
+int GetTaps( float u, int size, bool bWrap, GlObjects::PanoramaConverter::Filter filter,
+			 int aIndexes[ MAX_TAPS ], float aWeights[ MAX_TAPS ] )
+{
+	int const	i0	= int( floorf( u ) );
+	float const	t	= u - i0;
+	int			nTaps;
+	int			first;
+
+	if ( filter == GlObjects::PanoramaConverter::FILTER_BILINEAR )
+	{
+		nTaps			= 2;
+		first			= i0;
+		aWeights[ 0 ]	= 1.f - t;
+		aWeights[ 1 ]	= t;
+	}
+	else
+	{
+		// Catmull-Rom weights
+
+		nTaps			= 4;
+		first			= i0 - 1;
+		aWeights[ 0 ]	= ( ( -t + 2.f ) * t - 1.f ) * t * 0.5f;
+		aWeights[ 1 ]	= ( ( 3.f * t - 5.f ) * t * t + 2.f ) * 0.5f;
+		aWeights[ 2 ]	= ( ( -3.f * t + 4.f ) * t + 1.f ) * t * 0.5f;
+		aWeights[ 3 ]	= ( t - 1.f ) * t * t * 0.5f;
+	}
+
+	for ( int i = 0; i < nTaps; i++ )
+	{
+		int const	index	= first + i;
+
+		aIndexes[ i ] = bWrap ? ( index % size + size ) % size : std::min( std::max( index, 0 ), size - 1 );
+	}
+
+	return nTaps;
+}
+
+// Returns a 32-bit texel as four floats
+
+inline __m128 LoadTexel( uint8 const * p )
+{
+	__m128i const	zero	= _mm_setzero_si128();
+	__m128i			t		= _mm_cvtsi32_si128( *reinterpret_cast< int const * >( p ) );
+
+	t = _mm_unpacklo_epi8( t, zero );
+	t = _mm_unpacklo_epi16( t, zero );
+
+	return _mm_cvtepi32_ps( t );
+}
+
+// Filters a texel from the taps in each dimension. The result is rounded and clamped to [0, 255].
+
+void FilterTexel( uint8 const * pImage, int width, int texelSize,
+				  int const aRows[], float const aRowWeights[],
+				  int const aColumns[], float const aColumnWeights[],
+				  int nTaps, uint8 * pDest )
+{
+	if ( texelSize == 4 )
+	{
+		__m128	sum	= _mm_setzero_ps();
+
+		for ( int j = 0; j < nTaps; j++ )
+		{
+			uint8 const * const	pRow	= pImage + size_t( aRows[ j ] ) * width * 4;
+			__m128				rowSum	= _mm_setzero_ps();
+
+			for ( int i = 0; i < nTaps; i++ )
+			{
+				rowSum = _mm_add_ps( rowSum, _mm_mul_ps( _mm_set1_ps( aColumnWeights[ i ] ),
+														 LoadTexel( pRow + aColumns[ i ] * 4 ) ) );
+			}
+
+			sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( aRowWeights[ j ] ), rowSum ) );
+		}
+
+		// The packs saturate, so overshoot from the bicubic filter is clamped
+
+		__m128i	t	= _mm_cvtps_epi32( sum );
+
+		t = _mm_packs_epi32( t, t );
+		t = _mm_packus_epi16( t, t );
+
+		*reinterpret_cast< int * >( pDest ) = _mm_cvtsi128_si32( t );
+	}
+	else
+	{
+		float	aSums[ 4 ]	= { 0.f, 0.f, 0.f, 0.f };
+
+		for ( int j = 0; j < nTaps; j++ )
+		{
+			uint8 const * const	pRow	= pImage + size_t( aRows[ j ] ) * width * texelSize;
+
+			for ( int i = 0; i < nTaps; i++ )
+			{
+				uint8 const * const	p	= pRow + aColumns[ i ] * texelSize;
+				float const			w	= aRowWeights[ j ] * aColumnWeights[ i ];
+
+				for ( int c = 0; c < texelSize; c++ )
+				{
+					aSums[ c ] += w * p[ c ];
+				}
+			}
+		}
+
+		for ( int c = 0; c < texelSize; c++ )
+		{
+			pDest[ c ] = uint8( std::min( std::max( aSums[ c ] + 0.5f, 0.f ), 255.f ) );
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+// The work shared by the threads that sample the faces
+
+struct PanoramaConverter::Job
+{
+	Image const *	pPanorama;								///< The panorama
+	uint8 *			apFaces[ CubeMapTexture::NUM_FACES ];	///< Where the faces are sampled to
+	int				faceSize;								///< Width and height of the faces
+	Filter			filter;									///< The filter
+	int				nBandsPerFace;							///< Number of bands of rows in each face
+	int				nBands;									///< Total number of bands
+	LONG volatile	nextBand;								///< The next band to be sampled
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	faceSize	Width and height of the faces. If 0, it is a quarter of the width of the panorama, which
+///						keeps the density of texels at the equator about the same.
+/// @param	filter		The filter used to sample the panorama
+/// @param	nThreads	Number of threads that sample the faces, including the calling thread. If 0, it is the
+///						number of processors.
+
+PanoramaConverter::PanoramaConverter( int faceSize	/* = 0*/,
+									  Filter filter	/* = FILTER_BICUBIC*/,
+									  int nThreads	/* = 0*/ )
+	: m_FaceSize( faceSize ),
+	m_Filter( filter ),
+	m_nThreads( nThreads )
+{
+	assert( faceSize >= 0 );
+	assert( nThreads >= 0 );
+
+	if ( m_nThreads == 0 )
+	{
+		SYSTEM_INFO	info;
+		GetSystemInfo( &info );
+
+		m_nThreads = std::max( int( info.dwNumberOfProcessors ), 1 );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The faces have the same format and texel size as the panorama. Their first rows are at t = 0.
+///
+/// @param	panorama	The panorama. Its first row is the bottom row.
+/// @param	aqFaces		Receives the faces, indexed by CubeMapTexture::Face
+///
+/// @warning	This function throws a <tt>std::bad_alloc</tt> if the faces can't be allocated. If it throws, the
+///				faces are empty.
+
+void PanoramaConverter::Convert( Image const & panorama,
+								 std::auto_ptr< Image > aqFaces[ CubeMapTexture::NUM_FACES ] ) const
+{
+	assert( !panorama.IsEmpty() );
+
+	int const	faceSize	= GetFaceSize( panorama );
+
+	Job	job;
+
+	job.pPanorama		= &panorama;
+	job.faceSize		= faceSize;
+	job.filter			= m_Filter;
+	job.nBandsPerFace	= ( faceSize + BAND_HEIGHT - 1 ) / BAND_HEIGHT;
+	job.nBands			= job.nBandsPerFace * CubeMapTexture::NUM_FACES;
+	job.nextBand		= 0;
+
+	try
+	{
+		for ( int face = 0; face < CubeMapTexture::NUM_FACES; face++ )
+		{
+			aqFaces[ face ].reset( new Image( faceSize, faceSize, panorama.GetFormat(), panorama.GetTexelSize() ) );
+			job.apFaces[ face ] = aqFaces[ face ]->GetBuffer();
+		}
+	}
+	catch ( ... )
+	{
+		for ( int face = 0; face < CubeMapTexture::NUM_FACES; face++ )
+		{
+			aqFaces[ face ].reset();
+		}
+		throw;
+	}
+
+	// The calling thread samples bands too, so one less worker than the number of threads is needed
+
+	int const				nWorkers	= std::min( m_nThreads, job.nBands ) - 1;
+	std::vector< HANDLE >	threads;
+
+	threads.reserve( std::max( nWorkers, 0 ) );
+
+	for ( int i = 0; i < nWorkers; i++ )
+	{
+		HANDLE const	hThread	= (HANDLE)_beginthreadex( NULL, 0, WorkerThread, &job, 0, NULL );
+
+		// If a thread can't be started, the remaining threads simply sample more of the bands
+
+		if ( hThread == 0 ) break;
+
+		threads.push_back( hThread );
+	}
+
+	Work( &job );
+
+	for ( std::vector< HANDLE >::iterator pThread = threads.begin(); pThread != threads.end(); ++pThread )
+	{
+		WaitForSingleObject( *pThread, INFINITE );
+		CloseHandle( *pThread );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The panorama is decoded with TextureLoader::Decode() and hashed with TextureLoader::HashImage(). If the faces of a
+/// panorama with the same hash have been cached with the same size and filter, they are loaded from the cache.
+/// Otherwise, the panorama is converted and the faces are saved in the cache. The cached faces are baked texture
+/// files named after the panorama file, the hash, the size and filter, and the face.
+///
+/// @param	sFileName	Name of the panorama file
+/// @param	aqFaces		Receives the faces, indexed by CubeMapTexture::Face
+///
+/// @return		@c true if the faces were loaded. If @c false, the faces are empty.
+///
+/// @note	Failing to save the faces in the cache is not an error.
+
+bool PanoramaConverter::Load( char const * sFileName,
+							  std::auto_ptr< Image > aqFaces[ CubeMapTexture::NUM_FACES ] ) const
+{
+	try
+	{
+		std::auto_ptr< Image > const	qPanorama	= TextureLoader::Decode( sFileName );
+		if ( qPanorama.get() == 0 ) throw std::runtime_error( "Unable to load the panorama" );
+
+		uint64 const	hash		= TextureLoader::HashImage( *qPanorama );
+		int const		faceSize	= GetFaceSize( *qPanorama );
+
+		if ( !LoadCache( sFileName, hash, faceSize, aqFaces ) )
+		{
+			Convert( *qPanorama, aqFaces );
+			SaveCache( sFileName, hash, aqFaces );
+		}
+
+		return true;
+	}
+	catch ( ... )
+	{
+		for ( int face = 0; face < CubeMapTexture::NUM_FACES; face++ )
+		{
+			aqFaces[ face ].reset();
+		}
+
+		return false;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	panorama	The panorama
+
+int PanoramaConverter::GetFaceSize( Image const & panorama ) const
+{
+	return ( m_FaceSize > 0 ) ? m_FaceSize : std::max( panorama.GetWidth() / 4, 1 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+std::string PanoramaConverter::GetCacheFileName( char const * sFileName, uint64 hash, int faceSize, int face ) const
+{
+	static char const	aSuffixes[ CubeMapTexture::NUM_FACES ][ 4 ]	= { "_+X", "_-X", "_+Y", "_-Y", "_+Z", "_-Z" };
+
+	char	suffix[ 64 ];
+
+	sprintf( suffix, ".%08x%08x.%d%c%s.glbt",
+			 unsigned( hash >> 32 ), unsigned( hash ),
+			 faceSize, ( m_Filter == FILTER_BICUBIC ) ? 'c' : 'b',
+			 aSuffixes[ face ] );
+
+	return std::string( sFileName ) + suffix;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool PanoramaConverter::LoadCache( char const * sFileName, uint64 hash, int faceSize,
+								   std::auto_ptr< Image > aqFaces[ CubeMapTexture::NUM_FACES ] ) const
+{
+	try
+	{
+		for ( int face = 0; face < CubeMapTexture::NUM_FACES; face++ )
+		{
+			BakedTextureFile const	file( GetCacheFileName( sFileName, hash, faceSize, face ).c_str() );
+
+			if ( file.IsCompressed() ||
+				 file.GetWidth() != faceSize || file.GetHeight() != faceSize ||
+				 file.GetLevelCount() < 1 )
+			{
+				return false;
+			}
+
+			aqFaces[ face ].reset( new Image( faceSize, faceSize, file.GetFormat(), file.GetTexelSize() ) );
+
+			if ( file.GetLevelInfo( 0 ).size < aqFaces[ face ]->GetSize() ) return false;
+
+			memcpy( aqFaces[ face ]->GetBuffer(), file.GetLevelData( 0 ), aqFaces[ face ]->GetSize() );
+		}
+	}
+	catch ( ... )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool PanoramaConverter::SaveCache( char const * sFileName, uint64 hash,
+								   std::auto_ptr< Image > const aqFaces[ CubeMapTexture::NUM_FACES ] ) const
+{
+	try
+	{
+		for ( int face = 0; face < CubeMapTexture::NUM_FACES; face++ )
+		{
+			Image const &			image	= *aqFaces[ face ];
+			uint8 const * const		pData	= image.GetData();
+
+			BakedTextureFile::Write( GetCacheFileName( sFileName, hash, image.GetWidth(), face ).c_str(),
+									 image.GetWidth(), image.GetHeight(),
+									 image.GetFormat(), image.GetType(), image.GetTexelSize(),
+									 1, &pData );
+		}
+	}
+	catch ( ... )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+unsigned __stdcall PanoramaConverter::WorkerThread( void * pArg )
+{
+	Work( static_cast< Job * >( pArg ) );
+	return 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void PanoramaConverter::Work( Job * pJob )
+{
+	Image const &		panorama	= *pJob->pPanorama;
+	int const			width		= panorama.GetWidth();
+	int const			height		= panorama.GetHeight();
+	int const			texelSize	= panorama.GetTexelSize();
+	uint8 const * const	pPanorama	= panorama.GetData();
+	int const			size		= pJob->faceSize;
+
+	while ( true )
+	{
+		int const	band	= InterlockedIncrement( &pJob->nextBand ) - 1;
+
+		if ( band >= pJob->nBands ) break;
+
+		int const	face	= band / pJob->nBandsPerFace;
+		int const	y0		= ( band % pJob->nBandsPerFace ) * BAND_HEIGHT;
+		int const	y1		= std::min( y0 + BAND_HEIGHT, size );
+
+		uint8 *	pDest	= pJob->apFaces[ face ] + size_t( y0 ) * size * texelSize;
+
+		for ( int y = y0; y < y1; y++ )
+		{
+			for ( int x = 0; x < size; x++ )
+			{
+				float	d[ 3 ];
+				GetTexelDirection( face, size, x, y, d );
+
+				// The longitude is 0 at -Z and increases toward +X. The latitude is 0 at the horizon. The texel
+				// centers are at integer coordinates.
+
+				float const	longitude	= atan2f( d[ 0 ], -d[ 2 ] );
+				float const	latitude	= atan2f( d[ 1 ], sqrtf( d[ 0 ] * d[ 0 ] + d[ 2 ] * d[ 2 ] ) );
+				float const	u			= ( longitude / ( 2.f * PI ) + 0.5f ) * width - 0.5f;
+				float const	v			= ( latitude / PI + 0.5f ) * height - 0.5f;
+
+				int		aColumns[ MAX_TAPS ];
+				float	aColumnWeights[ MAX_TAPS ];
+				int		aRows[ MAX_TAPS ];
+				float	aRowWeights[ MAX_TAPS ];
+
+				int const	nTaps	= GetTaps( u, width, true, pJob->filter, aColumns, aColumnWeights );
+				GetTaps( v, height, false, pJob->filter, aRows, aRowWeights );
+
+				FilterTexel( pPanorama, width, texelSize, aRows, aRowWeights, aColumns, aColumnWeights, nTaps, pDest );
+
+				pDest += texelSize;
+			}
+		}
+	}
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,103 @@
+#if !defined( GLOBJECTS_PANORAMACONVERTER_H_INCLUDED )
+#define GLOBJECTS_PANORAMACONVERTER_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                PanoramaConverter.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/PanoramaConverter.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <memory>
+#include <string>
+#include "CubeMapTexture.h"
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+class Image;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Converts an equirectangular panorama into the six faces of a cube map.
+///
+/// The horizontal axis of the panorama is the longitude, with -Z at the center and +X three quarters of the way
+/// across. The vertical axis is the latitude, with -Y at the bottom row and +Y at the top row. Each texel of each face
+/// is sampled from the panorama in the direction of the texel (as specified by ARB_texture_cube_map), so the faces
+/// can be uploaded with CubeMapTexture::SetFace() as is.
+///
+/// The faces are sampled in parallel by the calling thread and a set of worker threads. 32-bit texels are filtered
+/// with SSE2. Load() caches the faces on disk, keyed by a hash of the panorama's texels, so a panorama is only
+/// converted once.
+
+class PanoramaConverter
+{
+public:
+
+	/// Filters used to sample the panorama
+	enum Filter
+	{
+		FILTER_BILINEAR,		///< 2x2 bilinear filter
+		FILTER_BICUBIC			///< 4x4 Catmull-Rom filter
+	};
+
+	/// Constructor
+	PanoramaConverter( int faceSize = 0, Filter filter = FILTER_BICUBIC, int nThreads = 0 );
+
+	/// Converts a panorama into the six faces of a cube map
+	void Convert( Image const & panorama, std::auto_ptr< Image > aqFaces[ CubeMapTexture::NUM_FACES ] ) const;
+
+	/// Loads the six faces of a panorama TGA file, using the cached faces if the panorama has been converted before
+	bool Load( char const * sFileName, std::auto_ptr< Image > aqFaces[ CubeMapTexture::NUM_FACES ] ) const;
+
+	/// Returns the size of the faces of a panorama
+	int GetFaceSize( Image const & panorama ) const;
+
+	/// Returns the filter
+	Filter GetFilter() const						{ return m_Filter; }
+
+private:
+
+	struct Job;
+
+	// Returns the name of a cached face
+	std::string GetCacheFileName( char const * sFileName, uint64 hash, int faceSize, int face ) const;
+
+	// Loads the cached faces. Returns false if they are not all cached.
+	bool LoadCache( char const * sFileName, uint64 hash, int faceSize,
+					std::auto_ptr< Image > aqFaces[ CubeMapTexture::NUM_FACES ] ) const;
+
+	// Saves the faces in the cache. Returns false if they can't be saved.
+	bool SaveCache( char const * sFileName, uint64 hash,
+					std::auto_ptr< Image > const aqFaces[ CubeMapTexture::NUM_FACES ] ) const;
+
+	// Worker thread entry point
+	static unsigned __stdcall WorkerThread( void * pArg );
+
+	// Samples bands of rows until there are none left
+	static void Work( Job * pJob );
+
+	int		m_FaceSize;		///< Width and height of the faces, or 0 for a quarter of the panorama's width
+	Filter	m_Filter;		///< The filter
+	int		m_nThreads;		///< Number of threads that sample the faces, including the calling thread
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_PANORAMACONVERTER_H_INCLUDED )
@@ -0,0 +1,149 @@
+/** @file *//********************************************************************************************************
+
+                                                 PixelBufferRing.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/PixelBufferRing.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "PixelBufferRing.h"
+
+#include "BufferObjects.h"
+
+#include "Glx/Glx.h"
+
+#include <cassert>
+#include <stdexcept>
+
+// ARB_pixel_buffer_object definitions
+
+#if !defined( GL_PIXEL_UNPACK_BUFFER_ARB )
+#define GL_PIXEL_UNPACK_BUFFER_ARB	0x88EC
+#endif
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	nBuffers	Number of buffers in the ring. With more buffers, more uploads can be in flight at once.
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if pixel buffer objects are not supported.
+
+PixelBufferRing::PixelBufferRing( int nBuffers/* = 3*/ )
+	: m_Buffers( nBuffers ),
+	m_Current( -1 ),
+	m_IsMapped( false )
+{
+	assert( nBuffers > 0 );
+
+	if ( !IsSupported() ) throw std::runtime_error( "Pixel buffer objects are not supported" );
+
+	BufferObjects::s_glGenBuffersARB( nBuffers, &m_Buffers[ 0 ] );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+PixelBufferRing::~PixelBufferRing()
+{
+	Unbind();
+	BufferObjects::s_glDeleteBuffersARB( GLsizei( m_Buffers.size() ), &m_Buffers[ 0 ] );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool PixelBufferRing::IsSupported()
+{
+	return Glx::Extension::IsSupported( "GL_ARB_pixel_buffer_object" ) && BufferObjects::Initialize();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The buffer's storage is re-specified before it is mapped, so the driver does not have to wait for a previous
+/// upload from this buffer to finish.
+///
+/// @param	size	Number of bytes needed
+///
+/// @return		Pointer to the mapped buffer, or 0 if it could not be mapped
+///
+/// @note	The buffer remains bound to @c GL_PIXEL_UNPACK_BUFFER_ARB after this call. Client-memory uploads must not
+///			be done until Unbind() is called.
+
+void * PixelBufferRing::Map( size_t size )
+{
+	assert( !m_IsMapped );
+
+	m_Current = ( m_Current + 1 ) % int( m_Buffers.size() );
+
+	BufferObjects::s_glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, m_Buffers[ m_Current ] );
+	BufferObjects::s_glBufferDataARB( GL_PIXEL_UNPACK_BUFFER_ARB, GLsizeiptrARB( size ), 0, GL_STREAM_DRAW_ARB );
+
+	void * const	pData	= BufferObjects::s_glMapBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB );
+
+	m_IsMapped = ( pData != 0 );
+
+	return pData;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// After this call, a texture upload with a data pointer of 0 reads its data from the start of the buffer.
+///
+/// @return		@c false if the contents of the buffer were lost while it was mapped
+
+bool PixelBufferRing::Unmap()
+{
+	bool	ok	= true;
+
+	if ( m_IsMapped )
+	{
+		ok = ( BufferObjects::s_glUnmapBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB ) == GL_TRUE );
+		m_IsMapped = false;
+	}
+
+	return ok;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void PixelBufferRing::Unbind()
+{
+	Unmap();
+	BufferObjects::s_glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,85 @@
+#if !defined( GLOBJECTS_PIXELBUFFERRING_H_INCLUDED )
+#define GLOBJECTS_PIXELBUFFERRING_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  PixelBufferRing.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/PixelBufferRing.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <vector>
+#include <gl/gl.h>
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A ring of pixel unpack buffers (ARB_pixel_buffer_object) used to stream texture data to GL.
+///
+/// Decoded image data is copied into a mapped buffer. When the buffer is unmapped, it is left bound to
+/// @c GL_PIXEL_UNPACK_BUFFER_ARB so that a texture upload sources its data from the buffer (at offset 0) rather than
+/// from client memory. The upload is then performed by the GPU asynchronously, and the next image is copied into
+/// the next buffer in the ring while the transfer is still in progress.
+///
+/// A buffer is mapped write-only, so its contents must only be written, sequentially if possible. Reading it back
+/// is undefined, and the memory is often uncached, which makes reads very slow.
+///
+/// @note	All functions must be called by the thread that owns the GL context.
+
+class PixelBufferRing
+{
+public:
+
+	/// Constructor
+	PixelBufferRing( int nBuffers = 3 );
+
+	/// Destructor
+	~PixelBufferRing();
+
+	/// Returns @c true if pixel buffer objects are supported by the current context
+	static bool IsSupported();
+
+	/// Maps the next buffer in the ring for writing and returns a pointer to it
+	void * Map( size_t size );
+
+	/// Unmaps the current buffer and leaves it bound for an upload
+	bool Unmap();
+
+	/// Unbinds the pixel unpack buffer (and unmaps it, if it is mapped)
+	void Unbind();
+
+	/// Returns @c true if a buffer is currently mapped
+	bool IsMapped() const		{ return m_IsMapped; }
+
+private:
+
+	// Prevent copying
+	PixelBufferRing( PixelBufferRing const & );
+	PixelBufferRing & operator =( PixelBufferRing const & );
+
+	std::vector< GLuint >	m_Buffers;		///< The buffer objects
+	int						m_Current;		///< Index of the most recently mapped buffer
+	bool					m_IsMapped;		///< @c true if the current buffer is mapped
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_PIXELBUFFERRING_H_INCLUDED )
@@ -0,0 +1,602 @@
+/** @file *//********************************************************************************************************
+
+                                                 PixelConverter.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/PixelConverter.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PixelConverter.h"
+
+#include "Misc/Types.h"
+
+#include <cassert>
+#include <emmintrin.h>
+
+// AVX2 intrinsics are only available in newer compilers
+
+#if defined( _MSC_VER ) && _MSC_VER >= 1700
+#define PIXELCONVERTER_AVX2_SUPPORTED
+#include <immintrin.h>
+#endif
+
+#if defined( _MSC_VER ) && _MSC_VER >= 1500
+#include <intrin.h>
+#endif
+
+namespace
+{
+
+using GlObjects::PixelConverter;
+
+typedef void ( * ExpandFunction )( uint8 const * pSrc, uint8 * pDst, size_t nPixels );
+typedef void ( * SwizzleFunction )( uint8 const * pSrc, uint8 * pDst, size_t nPixels );
+typedef void ( * FlipFunction )( uint8 * pData, size_t rowSize, int nRows );
+typedef void ( * PremultiplyFunction )( uint8 const * pSrc, uint8 * pDst, size_t nPixels );
+
+// Implementations of the conversions for an instruction set
+
+struct Kernels
+{
+	ExpandFunction		pExpandBgrToBgra;
+	SwizzleFunction		pSwizzleBgraToRgba;
+	FlipFunction		pFlipVertical;
+	PremultiplyFunction	pPremultiplyAlpha;
+};
+
+/********************************************************************************************************************/
+/* Scalar implementations																							*/
+/********************************************************************************************************************/
+
+void ExpandBgrToBgraScalar( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	for ( size_t i = 0; i < nPixels; i++ )
+	{
+		pDst[ 0 ] = pSrc[ 0 ];
+		pDst[ 1 ] = pSrc[ 1 ];
+		pDst[ 2 ] = pSrc[ 2 ];
+		pDst[ 3 ] = 0xff;
+
+		pSrc += 3;
+		pDst += 4;
+	}
+}
+
+void SwizzleBgraToRgbaScalar( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	for ( size_t i = 0; i < nPixels; i++ )
+	{
+		uint8 const	b	= pSrc[ 0 ];
+		uint8 const	r	= pSrc[ 2 ];
+
+		pDst[ 0 ] = r;
+		pDst[ 1 ] = pSrc[ 1 ];
+		pDst[ 2 ] = b;
+		pDst[ 3 ] = pSrc[ 3 ];
+
+		pSrc += 4;
+		pDst += 4;
+	}
+}
+
+void SwapBytesScalar( uint8 * pA, uint8 * pB, size_t size )
+{
+	for ( size_t i = 0; i < size; i++ )
+	{
+		uint8 const	t	= pA[ i ];
+		pA[ i ] = pB[ i ];
+		pB[ i ] = t;
+	}
+}
+
+void FlipVerticalScalar( uint8 * pData, size_t rowSize, int nRows )
+{
+	uint8 *	pTop	= pData;
+	uint8 *	pBottom	= pData + ( nRows - 1 ) * rowSize;
+
+	while ( pTop < pBottom )
+	{
+		SwapBytesScalar( pTop, pBottom, rowSize );
+		pTop += rowSize;
+		pBottom -= rowSize;
+	}
+}
+
+// Returns c * a / 255, rounded
+inline uint8 Premultiply( int c, int a )
+{
+	int const	t	= c * a + 128;
+	return uint8( ( t + ( t >> 8 ) ) >> 8 );
+}
+
+void PremultiplyAlphaScalar( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	for ( size_t i = 0; i < nPixels; i++ )
+	{
+		int const	a	= pSrc[ 3 ];
+
+		pDst[ 0 ] = Premultiply( pSrc[ 0 ], a );
+		pDst[ 1 ] = Premultiply( pSrc[ 1 ], a );
+		pDst[ 2 ] = Premultiply( pSrc[ 2 ], a );
+		pDst[ 3 ] = uint8( a );
+
+		pSrc += 4;
+		pDst += 4;
+	}
+}
+
+Kernels const	s_ScalarKernels	=
+{
+	ExpandBgrToBgraScalar,
+	SwizzleBgraToRgbaScalar,
+	FlipVerticalScalar,
+	PremultiplyAlphaScalar
+};
+
+/********************************************************************************************************************/
+/* SSE2 implementations																								*/
+/********************************************************************************************************************/
+
+void ExpandBgrToBgraSse2( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	__m128i const	alpha	= _mm_set1_epi32( int( 0xff000000 ) );
+	size_t			i		= 0;
+
+	// SSE2 has no byte shuffle, so the 4 pixels are gathered with 32-bit loads. The last load reads one byte past
+	// the 4th pixel, so there must be at least one more pixel after the group.
+
+	for ( ; i + 5 <= nPixels; i += 4 )
+	{
+		__m128i const	v	= _mm_setr_epi32( *reinterpret_cast< int const * >( pSrc + 0 ),
+											  *reinterpret_cast< int const * >( pSrc + 3 ),
+											  *reinterpret_cast< int const * >( pSrc + 6 ),
+											  *reinterpret_cast< int const * >( pSrc + 9 ) );
+
+		_mm_storeu_si128( reinterpret_cast< __m128i * >( pDst ), _mm_or_si128( v, alpha ) );
+
+		pSrc += 12;
+		pDst += 16;
+	}
+
+	ExpandBgrToBgraScalar( pSrc, pDst, nPixels - i );
+}
+
+void SwizzleBgraToRgbaSse2( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	__m128i const	greenAlpha	= _mm_set1_epi32( int( 0xff00ff00 ) );
+	size_t			i			= 0;
+
+	for ( ; i + 4 <= nPixels; i += 4 )
+	{
+		__m128i const	v	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pSrc ) );
+		__m128i const	ga	= _mm_and_si128( v, greenAlpha );
+		__m128i const	rb	= _mm_andnot_si128( greenAlpha, v );
+		__m128i const	br	= _mm_or_si128( _mm_slli_epi32( rb, 16 ), _mm_srli_epi32( rb, 16 ) );
+
+		_mm_storeu_si128( reinterpret_cast< __m128i * >( pDst ), _mm_or_si128( ga, br ) );
+
+		pSrc += 16;
+		pDst += 16;
+	}
+
+	SwizzleBgraToRgbaScalar( pSrc, pDst, nPixels - i );
+}
+
+void SwapBytesSse2( uint8 * pA, uint8 * pB, size_t size )
+{
+	size_t	i	= 0;
+
+	for ( ; i + 16 <= size; i += 16 )
+	{
+		__m128i const	a	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pA + i ) );
+		__m128i const	b	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pB + i ) );
+
+		_mm_storeu_si128( reinterpret_cast< __m128i * >( pA + i ), b );
+		_mm_storeu_si128( reinterpret_cast< __m128i * >( pB + i ), a );
+	}
+
+	SwapBytesScalar( pA + i, pB + i, size - i );
+}
+
+void FlipVerticalSse2( uint8 * pData, size_t rowSize, int nRows )
+{
+	uint8 *	pTop	= pData;
+	uint8 *	pBottom	= pData + ( nRows - 1 ) * rowSize;
+
+	while ( pTop < pBottom )
+	{
+		SwapBytesSse2( pTop, pBottom, rowSize );
+		pTop += rowSize;
+		pBottom -= rowSize;
+	}
+}
+
+// Premultiplies two pixels whose components have been expanded to 16 bits
+inline __m128i Premultiply2Sse2( __m128i p )
+{
+	__m128i const	bias	= _mm_set1_epi16( 128 );
+	__m128i const	a		= _mm_shufflehi_epi16( _mm_shufflelo_epi16( p, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+	__m128i const	t		= _mm_add_epi16( _mm_mullo_epi16( p, a ), bias );
+
+	return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+}
+
+void PremultiplyAlphaSse2( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	__m128i const	zero		= _mm_setzero_si128();
+	__m128i const	alphaMask	= _mm_set1_epi32( int( 0xff000000 ) );
+	size_t			i			= 0;
+
+	for ( ; i + 4 <= nPixels; i += 4 )
+	{
+		__m128i const	v	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pSrc ) );
+		__m128i const	lo	= Premultiply2Sse2( _mm_unpacklo_epi8( v, zero ) );
+		__m128i const	hi	= Premultiply2Sse2( _mm_unpackhi_epi8( v, zero ) );
+		__m128i const	rgb	= _mm_andnot_si128( alphaMask, _mm_packus_epi16( lo, hi ) );
+
+		_mm_storeu_si128( reinterpret_cast< __m128i * >( pDst ), _mm_or_si128( rgb, _mm_and_si128( v, alphaMask ) ) );
+
+		pSrc += 16;
+		pDst += 16;
+	}
+
+	PremultiplyAlphaScalar( pSrc, pDst, nPixels - i );
+}
+
+Kernels const	s_Sse2Kernels	=
+{
+	ExpandBgrToBgraSse2,
+	SwizzleBgraToRgbaSse2,
+	FlipVerticalSse2,
+	PremultiplyAlphaSse2
+};
+
+/********************************************************************************************************************/
+/* AVX2 implementations																								*/
+/********************************************************************************************************************/
+
+#if defined( PIXELCONVERTER_AVX2_SUPPORTED )
+
+void ExpandBgrToBgraAvx2( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	__m256i const	shuffle	= _mm256_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+												0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+	__m256i const	alpha	= _mm256_set1_epi32( int( 0xff000000 ) );
+	size_t			i		= 0;
+
+	// Each lane gets 4 pixels from a 16-byte load. The second load reads 4 bytes past the 8th pixel, so there must
+	// be at least two more pixels after the group.
+
+	for ( ; i + 10 <= nPixels; i += 8 )
+	{
+		__m128i const	lo	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pSrc ) );
+		__m128i const	hi	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pSrc + 12 ) );
+		__m256i const	v	= _mm256_inserti128_si256( _mm256_castsi128_si256( lo ), hi, 1 );
+
+		_mm256_storeu_si256( reinterpret_cast< __m256i * >( pDst ), _mm256_or_si256( _mm256_shuffle_epi8( v, shuffle ), alpha ) );
+
+		pSrc += 24;
+		pDst += 32;
+	}
+
+	_mm256_zeroupper();
+
+	ExpandBgrToBgraSse2( pSrc, pDst, nPixels - i );
+}
+
+void SwizzleBgraToRgbaAvx2( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	__m256i const	shuffle	= _mm256_setr_epi8( 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+												2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+	size_t			i		= 0;
+
+	for ( ; i + 8 <= nPixels; i += 8 )
+	{
+		__m256i const	v	= _mm256_loadu_si256( reinterpret_cast< __m256i const * >( pSrc ) );
+
+		_mm256_storeu_si256( reinterpret_cast< __m256i * >( pDst ), _mm256_shuffle_epi8( v, shuffle ) );
+
+		pSrc += 32;
+		pDst += 32;
+	}
+
+	_mm256_zeroupper();
+
+	SwizzleBgraToRgbaSse2( pSrc, pDst, nPixels - i );
+}
+
+void SwapBytesAvx2( uint8 * pA, uint8 * pB, size_t size )
+{
+	size_t	i	= 0;
+
+	for ( ; i + 32 <= size; i += 32 )
+	{
+		__m256i const	a	= _mm256_loadu_si256( reinterpret_cast< __m256i const * >( pA + i ) );
+		__m256i const	b	= _mm256_loadu_si256( reinterpret_cast< __m256i const * >( pB + i ) );
+
+		_mm256_storeu_si256( reinterpret_cast< __m256i * >( pA + i ), b );
+		_mm256_storeu_si256( reinterpret_cast< __m256i * >( pB + i ), a );
+	}
+
+	_mm256_zeroupper();
+
+	SwapBytesSse2( pA + i, pB + i, size - i );
+}
+
+void FlipVerticalAvx2( uint8 * pData, size_t rowSize, int nRows )
+{
+	uint8 *	pTop	= pData;
+	uint8 *	pBottom	= pData + ( nRows - 1 ) * rowSize;
+
+	while ( pTop < pBottom )
+	{
+		SwapBytesAvx2( pTop, pBottom, rowSize );
+		pTop += rowSize;
+		pBottom -= rowSize;
+	}
+}
+
+// Premultiplies four pixels (two per lane) whose components have been expanded to 16 bits
+inline __m256i Premultiply4Avx2( __m256i p )
+{
+	__m256i const	bias	= _mm256_set1_epi16( 128 );
+	__m256i const	a		= _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( p, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+	__m256i const	t		= _mm256_add_epi16( _mm256_mullo_epi16( p, a ), bias );
+
+	return _mm256_srli_epi16( _mm256_add_epi16( t, _mm256_srli_epi16( t, 8 ) ), 8 );
+}
+
+void PremultiplyAlphaAvx2( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	__m256i const	zero		= _mm256_setzero_si256();
+	__m256i const	alphaMask	= _mm256_set1_epi32( int( 0xff000000 ) );
+	size_t			i			= 0;
+
+	// Unpacking and packing both work within 128-bit lanes, so the pixels end up back in their original order
+
+	for ( ; i + 8 <= nPixels; i += 8 )
+	{
+		__m256i const	v	= _mm256_loadu_si256( reinterpret_cast< __m256i const * >( pSrc ) );
+		__m256i const	lo	= Premultiply4Avx2( _mm256_unpacklo_epi8( v, zero ) );
+		__m256i const	hi	= Premultiply4Avx2( _mm256_unpackhi_epi8( v, zero ) );
+		__m256i const	rgb	= _mm256_andnot_si256( alphaMask, _mm256_packus_epi16( lo, hi ) );
+
+		_mm256_storeu_si256( reinterpret_cast< __m256i * >( pDst ), _mm256_or_si256( rgb, _mm256_and_si256( v, alphaMask ) ) );
+
+		pSrc += 32;
+		pDst += 32;
+	}
+
+	_mm256_zeroupper();
+
+	PremultiplyAlphaSse2( pSrc, pDst, nPixels - i );
+}
+
+Kernels const	s_Avx2Kernels	=
+{
+	ExpandBgrToBgraAvx2,
+	SwizzleBgraToRgbaAvx2,
+	FlipVerticalAvx2,
+	PremultiplyAlphaAvx2
+};
+
+#endif // defined( PIXELCONVERTER_AVX2_SUPPORTED )
+
+/********************************************************************************************************************/
+/* Dispatch																											*/
+/********************************************************************************************************************/
+
+// Executes the CPUID instruction
+void Cpuid( int aInfo[ 4 ], int leaf )
+{
+#if defined( _MSC_VER ) && _MSC_VER >= 1500
+	__cpuidex( aInfo, leaf, 0 );
+#else
+	__asm
+	{
+		mov		eax, leaf
+		xor		ecx, ecx
+		cpuid
+		mov		esi, aInfo
+		mov		[esi], eax
+		mov		[esi+4], ebx
+		mov		[esi+8], ecx
+		mov		[esi+12], edx
+	}
+#endif
+}
+
+// Determines the best instruction set supported by the CPU (and compiler)
+PixelConverter::InstructionSet DetectInstructionSet()
+{
+	int		aInfo[ 4 ];
+
+	Cpuid( aInfo, 0 );
+	int const	maxLeaf	= aInfo[ 0 ];
+
+	Cpuid( aInfo, 1 );
+	bool const	sse2	= ( aInfo[ 3 ] & ( 1 << 26 ) ) != 0;
+
+#if defined( PIXELCONVERTER_AVX2_SUPPORTED )
+
+	// AVX2 requires that the OS saves the YMM registers
+
+	bool const	osxsave	= ( aInfo[ 2 ] & ( 1 << 27 ) ) != 0;
+	bool const	avx		= ( aInfo[ 2 ] & ( 1 << 28 ) ) != 0;
+
+	if ( osxsave && avx && maxLeaf >= 7 && ( _xgetbv( 0 ) & 6 ) == 6 )
+	{
+		Cpuid( aInfo, 7 );
+		if ( ( aInfo[ 1 ] & ( 1 << 5 ) ) != 0 )
+		{
+			return PixelConverter::INSTRUCTIONS_AVX2;
+		}
+	}
+
+#endif // defined( PIXELCONVERTER_AVX2_SUPPORTED )
+
+	(void)maxLeaf;
+
+	return sse2 ? PixelConverter::INSTRUCTIONS_SSE2 : PixelConverter::INSTRUCTIONS_SCALAR;
+}
+
+// Returns the kernels for an instruction set
+Kernels const * GetKernels( PixelConverter::InstructionSet instructions )
+{
+	switch ( instructions )
+	{
+#if defined( PIXELCONVERTER_AVX2_SUPPORTED )
+	case PixelConverter::INSTRUCTIONS_AVX2:	return &s_Avx2Kernels;
+#endif
+	case PixelConverter::INSTRUCTIONS_SSE2:	return &s_Sse2Kernels;
+	default:								return &s_ScalarKernels;
+	}
+}
+
+bool								s_Detected				= false;
+PixelConverter::InstructionSet		s_SupportedInstructions	= PixelConverter::INSTRUCTIONS_SCALAR;
+PixelConverter::InstructionSet		s_Instructions			= PixelConverter::INSTRUCTIONS_SCALAR;
+Kernels const *						s_pKernels				= 0;
+
+// Returns the current kernels, selecting them if necessary. Concurrent first calls all select the same kernels, so
+// no locking is needed.
+inline Kernels const & CurrentKernels()
+{
+	if ( s_pKernels == 0 )
+	{
+		PixelConverter::SetInstructionSet( PixelConverter::GetSupportedInstructionSet() );
+	}
+
+	return *s_pKernels;
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pSrc		Source pixels (3 bytes each)
+/// @param	pDst		Destination pixels (4 bytes each). Must not overlap the source.
+/// @param	nPixels		Number of pixels to convert
+
+void PixelConverter::ExpandBgrToBgra( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	CurrentKernels().pExpandBgrToBgra( pSrc, pDst, nPixels );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pSrc		Source pixels (4 bytes each)
+/// @param	pDst		Destination pixels (4 bytes each)
+/// @param	nPixels		Number of pixels to convert
+
+void PixelConverter::SwizzleBgraToRgba( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	CurrentKernels().pSwizzleBgraToRgba( pSrc, pDst, nPixels );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pData		The image
+/// @param	rowSize		Size of a row in bytes
+/// @param	nRows		Number of rows in the image
+
+void PixelConverter::FlipVertical( uint8 * pData, size_t rowSize, int nRows )
+{
+	CurrentKernels().pFlipVertical( pData, rowSize, nRows );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The alpha component must be the 4th byte of each pixel. Components are rounded to the nearest value.
+///
+/// @param	pSrc		Source pixels (4 bytes each)
+/// @param	pDst		Destination pixels (4 bytes each)
+/// @param	nPixels		Number of pixels to convert
+
+void PixelConverter::PremultiplyAlpha( uint8 const * pSrc, uint8 * pDst, size_t nPixels )
+{
+	CurrentKernels().pPremultiplyAlpha( pSrc, pDst, nPixels );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+PixelConverter::InstructionSet PixelConverter::GetInstructionSet()
+{
+	CurrentKernels();
+
+	return s_Instructions;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+PixelConverter::InstructionSet PixelConverter::GetSupportedInstructionSet()
+{
+	if ( !s_Detected )
+	{
+		s_SupportedInstructions = DetectInstructionSet();
+		s_Detected = true;
+	}
+
+	return s_SupportedInstructions;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This is mainly for benchmarking and testing the implementations against each other.
+///
+/// @param	instructions	The instruction set to use
+///
+/// @return		@c false if the instruction set is not supported (in which case nothing is changed)
+
+bool PixelConverter::SetInstructionSet( InstructionSet instructions )
+{
+	if ( instructions > GetSupportedInstructionSet() )
+	{
+		return false;
+	}
+
+	s_Instructions	= instructions;
+	s_pKernels		= GetKernels( instructions );
+
+	return true;
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,75 @@
+#if !defined( GLOBJECTS_PIXELCONVERTER_H_INCLUDED )
+#define GLOBJECTS_PIXELCONVERTER_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  PixelConverter.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/PixelConverter.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <cstddef>
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Pixel conversion functions used when loading textures.
+///
+/// Each function has a scalar, an SSE2, and an AVX2 implementation. The implementation is selected the first time
+/// a function is called, according to the features supported by the CPU. Source and destination buffers do not need
+/// to be aligned.
+
+class PixelConverter
+{
+public:
+
+	/// Instruction sets that the conversions can use
+	enum InstructionSet
+	{
+		INSTRUCTIONS_SCALAR,		///< No SIMD instructions
+		INSTRUCTIONS_SSE2,			///< SSE2
+		INSTRUCTIONS_AVX2			///< AVX2 (only if the compiler supports it)
+	};
+
+	/// Converts 24-bit BGR pixels to opaque 32-bit BGRA pixels
+	static void ExpandBgrToBgra( uint8 const * pSrc, uint8 * pDst, size_t nPixels );
+
+	/// Swaps the red and blue components of 32-bit pixels. The source and destination may be the same.
+	static void SwizzleBgraToRgba( uint8 const * pSrc, uint8 * pDst, size_t nPixels );
+
+	/// Reverses the order of the rows of an image in place
+	static void FlipVertical( uint8 * pData, size_t rowSize, int nRows );
+
+	/// Multiplies the color components of 32-bit pixels by their alpha. The source and destination may be the same.
+	static void PremultiplyAlpha( uint8 const * pSrc, uint8 * pDst, size_t nPixels );
+
+	/// Returns the instruction set currently used by the conversions
+	static InstructionSet GetInstructionSet();
+
+	/// Returns the best instruction set supported by the CPU
+	static InstructionSet GetSupportedInstructionSet();
+
+	/// Overrides the instruction set used by the conversions. Returns @c false if it is not supported.
+	static bool SetInstructionSet( InstructionSet instructions );
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_PIXELCONVERTER_H_INCLUDED )
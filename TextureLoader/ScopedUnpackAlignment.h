@@ -0,0 +1,66 @@
+#if !defined( GLOBJECTS_SCOPEDUNPACKALIGNMENT_H_INCLUDED )
+#define GLOBJECTS_SCOPEDUNPACKALIGNMENT_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                               ScopedUnpackAlignment.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/ScopedUnpackAlignment.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <gl/gl.h>
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Sets @c GL_UNPACK_ALIGNMENT for the lifetime of the object and then restores it.
+///
+/// Tightly-packed images whose rows are not a multiple of 4 bytes (24-bit, 16-bit, and 8-bit images with odd widths,
+/// and small mip levels) must be uploaded with an alignment of 1.
+
+class ScopedUnpackAlignment
+{
+public:
+
+	/// Constructor
+	ScopedUnpackAlignment( GLint alignment = 1 )
+	{
+		glGetIntegerv( GL_UNPACK_ALIGNMENT, &m_Saved );
+		glPixelStorei( GL_UNPACK_ALIGNMENT, alignment );
+	}
+
+	/// Destructor
+	~ScopedUnpackAlignment()
+	{
+		glPixelStorei( GL_UNPACK_ALIGNMENT, m_Saved );
+	}
+
+private:
+
+	// Prevent copying
+	ScopedUnpackAlignment( ScopedUnpackAlignment const & );
+	ScopedUnpackAlignment & operator =( ScopedUnpackAlignment const & );
+
+	GLint	m_Saved;	///< The previous alignment
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_SCOPEDUNPACKALIGNMENT_H_INCLUDED )
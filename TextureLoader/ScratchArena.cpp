@@ -0,0 +1,395 @@
+/** @file *//********************************************************************************************************
+
+                                                 ScratchArena.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/ScratchArena.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "ScratchArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <malloc.h>
+#include <new>
+
+namespace
+{
+
+// Blocks are never smaller than this
+
+size_t const	MIN_BLOCK_SIZE	= 64 * 1024;
+
+// The arena used by each thread, and the arena created for it by GetThreadArena()
+
+__declspec( thread ) GlObjects::ScratchArena *	t_pThreadArena	= 0;
+__declspec( thread ) GlObjects::ScratchArena *	t_pOwnArena		= 0;
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pArena	The arena, or 0
+
+ScratchArena::Scope::Scope( ScratchArena * pArena )
+	: m_pArena( pArena )
+{
+	if ( m_pArena != 0 )
+	{
+		m_Mark = m_pArena->GetMark();
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+ScratchArena::Scope::~Scope()
+{
+	if ( m_pArena != 0 )
+	{
+		m_pArena->Rewind( m_Mark );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	initialSize		Size of the first block. If 0, no memory is allocated until it is needed.
+/// @param	alignment		Alignment of each allocation. It must be a power of 2.
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+ScratchArena::ScratchArena( size_t initialSize /* = 0*/, size_t alignment /* = 16*/ )
+	: m_Alignment( alignment ),
+	m_CurrentBlock( 0 ),
+	m_Offset( 0 ),
+	m_PeakUsage( 0 )
+{
+	assert( alignment > 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+
+	if ( initialSize > 0 && !AddBlock( initialSize ) )
+	{
+		throw std::bad_alloc();
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+ScratchArena::~ScratchArena()
+{
+	FreeBlocks();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If the allocation does not fit in the current block, the next block that it fits in is used. If there is none, a
+/// new block is added.
+
+uint8 * ScratchArena::Allocate( size_t size )
+{
+	size = std::max( size, size_t( 1 ) );
+
+	for ( ;; )
+	{
+		if ( m_CurrentBlock < m_Blocks.size() )
+		{
+			Block const &	block	= m_Blocks[ m_CurrentBlock ];
+			size_t const	offset	= ( m_Offset + m_Alignment - 1 ) & ~( m_Alignment - 1 );
+
+			if ( offset <= block.size && size <= block.size - offset )
+			{
+				m_Offset	= offset + size;
+				m_PeakUsage	= std::max( m_PeakUsage, GetUsage() );
+
+				return block.pMemory + offset;
+			}
+
+			// Try the next block
+
+			if ( m_CurrentBlock + 1 < m_Blocks.size() )
+			{
+				++m_CurrentBlock;
+				m_Offset = 0;
+				continue;
+			}
+		}
+
+		// None of the blocks are big enough, so add one
+
+		if ( !AddBlock( std::max( size, GetCapacity() * 2 ) ) )
+		{
+			return 0;
+		}
+
+		m_CurrentBlock	= m_Blocks.size() - 1;
+		m_Offset		= 0;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+ScratchArena::Mark ScratchArena::GetMark() const
+{
+	Mark	mark;
+
+	mark.block	= m_CurrentBlock;
+	mark.offset	= m_Offset;
+
+	return mark;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The memory is not released. It is reused by later allocations.
+///
+/// @param	mark	A mark returned by GetMark(). Any marks taken after it are no longer valid.
+
+void ScratchArena::Rewind( Mark const & mark )
+{
+	assert( mark.block < m_CurrentBlock || ( mark.block == m_CurrentBlock && mark.offset <= m_Offset ) );
+
+	m_CurrentBlock	= mark.block;
+	m_Offset		= mark.offset;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If the arena has grown to more than one block, the blocks are replaced by a single block of the same total size, so
+/// that the next batch of allocations fits in one block. All marks are invalidated.
+
+void ScratchArena::Reset()
+{
+	if ( m_Blocks.size() > 1 )
+	{
+		size_t const	capacity	= GetCapacity();
+
+		FreeBlocks();
+		AddBlock( capacity );
+	}
+
+	m_CurrentBlock	= 0;
+	m_Offset		= 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Blocks that were skipped because an allocation did not fit in them count as being in use.
+
+size_t ScratchArena::GetUsage() const
+{
+	if ( m_Blocks.empty() ) return 0;
+
+	size_t	usage	= m_Offset;
+
+	for ( size_t i = 0; i < m_CurrentBlock; i++ )
+	{
+		usage += m_Blocks[ i ].size;
+	}
+
+	return usage;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+size_t ScratchArena::GetCapacity() const
+{
+	size_t	capacity	= 0;
+
+	for ( BlockList::const_iterator pBlock = m_Blocks.begin(); pBlock != m_Blocks.end(); ++pBlock )
+	{
+		capacity += pBlock->size;
+	}
+
+	return capacity;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pArena			The arena to allocate from. If 0, the memory is allocated from the heap.
+/// @param	size			Number of bytes to allocate
+/// @param	qaHeapBuffer	Takes ownership of the memory if it is allocated from the heap
+///
+/// @return		The memory
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+uint8 * ScratchArena::AllocateBuffer( ScratchArena * pArena, size_t size, auto_array_ptr< uint8 > & qaHeapBuffer )
+{
+	uint8 *	pBuffer;
+
+	if ( pArena != 0 )
+	{
+		pBuffer = pArena->Allocate( size );
+	}
+	else
+	{
+		qaHeapBuffer = auto_array_ptr< uint8 >( new uint8[ std::max( size, size_t( 1 ) ) ] );
+		pBuffer = qaHeapBuffer.get();
+	}
+	if ( pBuffer == 0 ) throw std::bad_alloc();
+
+	return pBuffer;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This lets a caller supply the arena that is used on its thread, for example by TextureLoader.
+///
+/// @param	pArena	The arena. If 0, GetThreadArena() returns an arena that it creates.
+
+void ScratchArena::SetThreadArena( ScratchArena * pArena )
+{
+	t_pThreadArena = pArena;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If no arena has been set for the calling thread with SetThreadArena(), one is created. It belongs to the thread and
+/// it is destroyed by FreeThreadArena().
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+ScratchArena & ScratchArena::GetThreadArena()
+{
+	if ( t_pThreadArena == 0 )
+	{
+		if ( t_pOwnArena == 0 )
+		{
+			t_pOwnArena = new ScratchArena;
+			if ( t_pOwnArena == 0 ) throw std::bad_alloc();
+		}
+
+		t_pThreadArena = t_pOwnArena;
+	}
+
+	return *t_pThreadArena;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A thread that has called GetThreadArena() without first calling SetThreadArena() should call this function before
+/// it exits.
+
+void ScratchArena::FreeThreadArena()
+{
+	if ( t_pThreadArena == t_pOwnArena )
+	{
+		t_pThreadArena = 0;
+	}
+
+	delete t_pOwnArena;
+	t_pOwnArena = 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool ScratchArena::AddBlock( size_t size )
+{
+	Block	block;
+
+	block.size		= std::max( size, MIN_BLOCK_SIZE );
+	block.pMemory	= static_cast< uint8 * >( _aligned_malloc( block.size, m_Alignment ) );
+
+	if ( block.pMemory == 0 ) return false;
+
+	try
+	{
+		m_Blocks.push_back( block );
+	}
+	catch ( ... )
+	{
+		_aligned_free( block.pMemory );
+		return false;
+	}
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void ScratchArena::FreeBlocks()
+{
+	for ( BlockList::iterator pBlock = m_Blocks.begin(); pBlock != m_Blocks.end(); ++pBlock )
+	{
+		_aligned_free( pBlock->pMemory );
+	}
+
+	m_Blocks.clear();
+}
+
+
+} // namespace GlObjects
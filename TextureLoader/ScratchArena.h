@@ -0,0 +1,149 @@
+#if !defined( GLOBJECTS_SCRATCHARENA_H_INCLUDED )
+#define GLOBJECTS_SCRATCHARENA_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  ScratchArena.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/ScratchArena.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <cstddef>
+#include <vector>
+#include "TgaImage.h"
+#include "Misc/auto_array_ptr.h"
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A growable stack of aligned memory for staging images before they are uploaded.
+///
+/// Memory is allocated by advancing through a list of blocks, and it is freed all at once by returning to an earlier
+/// mark (usually with a Scope). The blocks are kept, so a batch of loads reuses the same memory instead of allocating
+/// a new buffer for every image. When an allocation doesn't fit, a new block at least twice the current capacity is
+/// added, and Reset() merges the blocks into one.
+///
+/// An arena must only be used by one thread at a time. Each thread can have its own arena (see GetThreadArena()).
+
+class ScratchArena : public TgaImageAllocator
+{
+public:
+
+	/// A position in the arena
+	struct Mark
+	{
+		size_t	block;		///< Index of the block
+		size_t	offset;		///< Offset in the block
+	};
+
+	/// Returns the arena to its current position when destroyed
+	class Scope
+	{
+	public:
+
+		/// Constructor. If @a pArena is 0, the scope does nothing.
+		Scope( ScratchArena * pArena );
+
+		/// Destructor
+		~Scope();
+
+	private:
+
+		// Prevent copying
+		Scope( Scope const & );
+		Scope & operator =( Scope const & );
+
+		ScratchArena *	m_pArena;		///< The arena
+		Mark			m_Mark;			///< The position to return to
+	};
+
+	/// Constructor
+	ScratchArena( size_t initialSize = 0, size_t alignment = 16 );
+
+	/// Destructor
+	virtual ~ScratchArena();
+
+	/// Returns a buffer of at least @a size bytes, or 0 if it can't be allocated
+	virtual uint8 * Allocate( size_t size );
+
+	/// Returns the current position
+	Mark GetMark() const;
+
+	/// Frees everything allocated since the mark was taken
+	void Rewind( Mark const & mark );
+
+	/// Frees everything and merges the blocks into one
+	void Reset();
+
+	/// Returns the number of bytes in use
+	size_t GetUsage() const;
+
+	/// Returns the largest number of bytes that have been in use since the last call to ResetPeakUsage()
+	size_t GetPeakUsage() const					{ return m_PeakUsage; }
+
+	/// Resets the peak usage to the current usage
+	void ResetPeakUsage()						{ m_PeakUsage = GetUsage(); }
+
+	/// Returns the total size of the blocks
+	size_t GetCapacity() const;
+
+	/// Allocates from an arena, or from the heap if the arena is 0
+	static uint8 * AllocateBuffer( ScratchArena * pArena, size_t size, auto_array_ptr< uint8 > & qaHeapBuffer );
+
+	/// Sets the arena returned by GetThreadArena() for the calling thread
+	static void SetThreadArena( ScratchArena * pArena );
+
+	/// Returns the calling thread's arena, creating one if necessary
+	static ScratchArena & GetThreadArena();
+
+	/// Destroys the arena created for the calling thread by GetThreadArena()
+	static void FreeThreadArena();
+
+private:
+
+	/// A block of memory
+	struct Block
+	{
+		uint8 *		pMemory;	///< The memory
+		size_t		size;		///< Size of the memory
+	};
+
+	typedef std::vector< Block > BlockList;
+
+	// Prevent copying
+	ScratchArena( ScratchArena const & );
+	ScratchArena & operator =( ScratchArena const & );
+
+	// Adds a block. Returns false if it can't be allocated.
+	bool AddBlock( size_t size );
+
+	// Frees all of the blocks
+	void FreeBlocks();
+
+	BlockList	m_Blocks;			///< The blocks
+	size_t		m_Alignment;		///< Alignment of each allocation
+	size_t		m_CurrentBlock;		///< Index of the block being allocated from
+	size_t		m_Offset;			///< Offset of the next allocation in the current block
+	size_t		m_PeakUsage;		///< Largest usage since the last reset
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_SCRATCHARENA_H_INCLUDED )
@@ -0,0 +1,626 @@
+/** @file *//********************************************************************************************************
+
+                                                 TextureAtlas.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureAtlas.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "TextureAtlas.h"
+
+#include "BakedTextureFile.h"
+#include "TextureLoader.h"
+#include "TgaImage.h"
+
+#include "Glx/Texture.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+
+// The signature and version of a saved atlas
+
+char const		ATLAS_SIGNATURE[]	= "GLBA";
+int const		ATLAS_VERSION		= 1;
+
+// A rectangle in a page
+
+struct Rect
+{
+	int		x, y;
+	int		width, height;
+};
+
+// Returns true if rectangle a is entirely inside rectangle b
+
+bool IsContainedIn( Rect const & a, Rect const & b )
+{
+	return a.x >= b.x && a.y >= b.y && a.x + a.width <= b.x + b.width && a.y + a.height <= b.y + b.height;
+}
+
+// Packs rectangles into a page using the MaxRects algorithm. The free space is kept as a list of maximal free
+// rectangles (which may overlap), and each rectangle is placed where it leaves the shortest leftover side.
+
+class MaxRectsPacker
+{
+public:
+
+	MaxRectsPacker( int width, int height )
+	{
+		Rect const	page	= { 0, 0, width, height };
+
+		m_FreeRects.push_back( page );
+	}
+
+	// Places a rectangle. Returns false if it doesn't fit.
+	bool Insert( int width, int height, Rect * pPlaced )
+	{
+		int		bestShortSide	= INT_MAX;
+		int		bestLongSide	= INT_MAX;
+		bool	bFound			= false;
+
+		for ( std::vector< Rect >::const_iterator pFree = m_FreeRects.begin(); pFree != m_FreeRects.end(); ++pFree )
+		{
+			if ( pFree->width < width || pFree->height < height ) continue;
+
+			int const	leftoverX	= pFree->width - width;
+			int const	leftoverY	= pFree->height - height;
+			int const	shortSide	= std::min( leftoverX, leftoverY );
+			int const	longSide	= std::max( leftoverX, leftoverY );
+
+			if ( shortSide < bestShortSide || ( shortSide == bestShortSide && longSide < bestLongSide ) )
+			{
+				pPlaced->x		= pFree->x;
+				pPlaced->y		= pFree->y;
+				pPlaced->width	= width;
+				pPlaced->height	= height;
+				bestShortSide	= shortSide;
+				bestLongSide	= longSide;
+				bFound			= true;
+			}
+		}
+
+		if ( !bFound ) return false;
+
+		// Split every free rectangle that overlaps the placed rectangle into the parts that don't
+
+		std::vector< Rect >	split;
+
+		for ( size_t i = 0; i < m_FreeRects.size(); )
+		{
+			if ( Split( m_FreeRects[ i ], *pPlaced, &split ) )
+			{
+				m_FreeRects.erase( m_FreeRects.begin() + i );
+			}
+			else
+			{
+				++i;
+			}
+		}
+
+		m_FreeRects.insert( m_FreeRects.end(), split.begin(), split.end() );
+
+		Prune();
+
+		return true;
+	}
+
+private:
+
+	// Adds the parts of a free rectangle that are not covered by the used rectangle. Returns false if they don't
+	// overlap.
+	static bool Split( Rect const & free, Rect const & used, std::vector< Rect > * pSplit )
+	{
+		if ( used.x >= free.x + free.width || used.x + used.width <= free.x ||
+			 used.y >= free.y + free.height || used.y + used.height <= free.y )
+		{
+			return false;
+		}
+
+		// Below and above
+
+		if ( used.y > free.y )
+		{
+			Rect	r	= free;
+
+			r.height = used.y - free.y;
+			pSplit->push_back( r );
+		}
+
+		if ( used.y + used.height < free.y + free.height )
+		{
+			Rect	r	= free;
+
+			r.y			= used.y + used.height;
+			r.height	= free.y + free.height - r.y;
+			pSplit->push_back( r );
+		}
+
+		// Left and right
+
+		if ( used.x > free.x )
+		{
+			Rect	r	= free;
+
+			r.width = used.x - free.x;
+			pSplit->push_back( r );
+		}
+
+		if ( used.x + used.width < free.x + free.width )
+		{
+			Rect	r	= free;
+
+			r.x		= used.x + used.width;
+			r.width	= free.x + free.width - r.x;
+			pSplit->push_back( r );
+		}
+
+		return true;
+	}
+
+	// Removes the free rectangles that are inside other free rectangles
+	void Prune()
+	{
+		for ( size_t i = 0; i < m_FreeRects.size(); i++ )
+		{
+			for ( size_t j = i + 1; j < m_FreeRects.size(); )
+			{
+				if ( IsContainedIn( m_FreeRects[ i ], m_FreeRects[ j ] ) )
+				{
+					m_FreeRects.erase( m_FreeRects.begin() + i );
+					--i;
+					break;
+				}
+
+				if ( IsContainedIn( m_FreeRects[ j ], m_FreeRects[ i ] ) )
+				{
+					m_FreeRects.erase( m_FreeRects.begin() + j );
+				}
+				else
+				{
+					++j;
+				}
+			}
+		}
+	}
+
+	std::vector< Rect >	m_FreeRects;
+};
+
+// Returns true if the first image should be packed before the second. Larger images are packed first.
+
+bool PackBefore( GlObjects::TgaImage const * pA, GlObjects::TgaImage const * pB )
+{
+	int const	a	= std::max( pA->width, pA->height );
+	int const	b	= std::max( pB->width, pB->height );
+
+	if ( a != b ) return a > b;
+
+	return std::min( pA->width, pA->height ) > std::min( pB->width, pB->height );
+}
+
+// Returns the name of the file containing a page of a saved atlas
+
+std::string GetPageFileName( char const * sFileName, int page )
+{
+	char	suffix[ 32 ];
+
+	sprintf( suffix, ".%d.glbt", page );
+
+	return std::string( sFileName ) + suffix;
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pageSize	Width and height of each page in texels. It should be a power of 2.
+/// @param	gutter		Number of texels of padding around each image. A gutter of 1 is enough to prevent bleeding
+///						with bilinear filtering. More is needed if the pages are mip-mapped.
+
+TextureAtlas::TextureAtlas( int pageSize /* = 1024*/, int gutter /* = 2*/ )
+	: m_PageSize( pageSize ),
+	m_Gutter( gutter )
+{
+	assert( pageSize > 0 );
+	assert( gutter >= 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureAtlas::~TextureAtlas()
+{
+	for ( SourceList::iterator pSource = m_Sources.begin(); pSource != m_Sources.end(); ++pSource )
+	{
+		delete pSource->pImage;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The image is loaded immediately, but it is not placed until Pack() is called. 24-bit images are expanded to 32
+/// bits and grayscale images are expanded when they are copied into a page. Alpha is premultiplied if
+/// TextureLoader::SetPremultipliedAlpha() is enabled. A file that has already been added is ignored.
+///
+/// @param	sFileName	Name of the file. The same name is used to look up the image's location.
+///
+/// @warning	This function may throw a ConstructorFailedException, <tt>std::runtime_error</tt>, or a
+///				<tt>std::bad_alloc</tt>.
+
+void TextureAtlas::Add( char const * sFileName )
+{
+	for ( SourceList::const_iterator pSource = m_Sources.begin(); pSource != m_Sources.end(); ++pSource )
+	{
+		if ( pSource->name == sFileName ) return;
+	}
+
+	unsigned const			flags	= TGA_LOAD_EXPAND_TO_BGRA | ( TextureLoader::GetLoadFlags() & TGA_LOAD_PREMULTIPLY_ALPHA );
+	std::auto_ptr< TgaImage >	qImage( new TgaImage );
+
+	LoadTgaImage( sFileName, flags, qImage.get() );
+
+	if ( qImage->width + 2 * m_Gutter > m_PageSize || qImage->height + 2 * m_Gutter > m_PageSize )
+	{
+		throw std::runtime_error( "Image is too large for an atlas page" );
+	}
+
+	Source	source;
+
+	source.name		= sFileName;
+	source.pImage	= qImage.get();
+
+	m_Sources.push_back( source );
+	qImage.release();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// All of the images that have been added are packed, largest first. An image is placed in the first page it fits in,
+/// and a new page is started when it fits in none of them. Any previous packing is discarded.
+///
+/// @warning	This function may throw a <tt>std::bad_alloc</tt>.
+
+void TextureAtlas::Pack()
+{
+	m_Pages.clear();
+	m_Regions.clear();
+
+	std::vector< TgaImage const * >	order;
+
+	for ( SourceList::const_iterator pSource = m_Sources.begin(); pSource != m_Sources.end(); ++pSource )
+	{
+		order.push_back( pSource->pImage );
+	}
+
+	std::stable_sort( order.begin(), order.end(), PackBefore );
+
+	std::vector< MaxRectsPacker >	packers;
+
+	for ( std::vector< TgaImage const * >::const_iterator ppImage = order.begin(); ppImage != order.end(); ++ppImage )
+	{
+		TgaImage const &	image	= **ppImage;
+		int const			width	= image.width + 2 * m_Gutter;
+		int const			height	= image.height + 2 * m_Gutter;
+		Rect				placed;
+		int					page;
+
+		for ( page = 0; page < int( packers.size() ); page++ )
+		{
+			if ( packers[ page ].Insert( width, height, &placed ) ) break;
+		}
+
+		// If it didn't fit in any page, start a new one
+
+		if ( page == int( packers.size() ) )
+		{
+			packers.push_back( MaxRectsPacker( m_PageSize, m_PageSize ) );
+			m_Pages.push_back( std::vector< uint8 >( size_t( m_PageSize ) * m_PageSize * 4, 0 ) );
+
+			bool const	bPlaced	= packers.back().Insert( width, height, &placed );
+
+			assert( bPlaced );
+		}
+
+		Copy( image, page, placed.x + m_Gutter, placed.y + m_Gutter );
+
+		// Record the location. The source list is searched because the order was sorted.
+
+		Region	region;
+
+		region.page		= page;
+		region.x		= placed.x + m_Gutter;
+		region.y		= placed.y + m_Gutter;
+		region.width	= image.width;
+		region.height	= image.height;
+		region.u0		= float( region.x ) / float( m_PageSize );
+		region.v0		= float( region.y ) / float( m_PageSize );
+		region.u1		= float( region.x + region.width ) / float( m_PageSize );
+		region.v1		= float( region.y + region.height ) / float( m_PageSize );
+
+		for ( SourceList::const_iterator pSource = m_Sources.begin(); pSource != m_Sources.end(); ++pSource )
+		{
+			if ( pSource->pImage == &image )
+			{
+				m_Regions[ pSource->name ] = region;
+				break;
+			}
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	sFileName	Name of the file, exactly as it was passed to Add()
+
+TextureAtlas::Region const * TextureAtlas::Find( char const * sFileName ) const
+{
+	RegionMap::const_iterator const	i	= m_Regions.find( sFileName );
+
+	return ( i != m_Regions.end() ) ? &i->second : 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The texture is created with a wrap mode of @c GL_CLAMP, since the images in a page can't repeat.
+///
+/// @param	page			Index of the page
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the texture.
+
+std::auto_ptr< Glx::Texture > TextureAtlas::CreateTexture( int page,
+														   GLenum minFiltering	/* = GL_LINEAR*/,
+														   GLenum magFiltering	/* = GL_LINEAR*/,
+														   GLuint id			/* = 0*/ ) const
+{
+	assert( page >= 0 && page < GetPageCount() );
+
+	Glx::Texture *	pTexture	= 0;
+
+	try
+	{
+		pTexture = new Glx::Texture( m_PageSize, m_PageSize,
+									 GetPageData( page ),
+									 GL_BGRA_EXT, GL_UNSIGNED_BYTE, GL_CLAMP, minFiltering, magFiltering,
+									 id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::Texture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The regions are written to a text file, and each page is written to a baked texture file (see BakedTextureFile)
+/// named by appending ".<page>.glbt" to the name of the text file.
+///
+/// @param	sFileName	Name of the file to write
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if a file cannot be written.
+
+void TextureAtlas::Save( char const * sFileName ) const
+{
+	for ( int i = 0; i < GetPageCount(); i++ )
+	{
+		uint8 const * const	pData	= GetPageData( i );
+
+		BakedTextureFile::Write( GetPageFileName( sFileName, i ).c_str(),
+								 m_PageSize, m_PageSize,
+								 GL_BGRA_EXT, GL_UNSIGNED_BYTE, 4,
+								 1, &pData );
+	}
+
+	FILE * const	fp	= fopen( sFileName, "w" );
+	if ( fp == 0 ) throw std::runtime_error( "Unable to create file" );
+
+	bool	ok	= fprintf( fp, "%s %d %d %d %d %d\n",
+						   ATLAS_SIGNATURE, ATLAS_VERSION, m_PageSize, m_Gutter, GetPageCount(), GetRegionCount() ) > 0;
+
+	for ( RegionMap::const_iterator i = m_Regions.begin(); ok && i != m_Regions.end(); ++i )
+	{
+		Region const &	region	= i->second;
+
+		ok = fprintf( fp, "%d %d %d %d %d %s\n",
+					  region.page, region.x, region.y, region.width, region.height, i->first.c_str() ) > 0;
+	}
+
+	ok = ( fclose( fp ) == 0 ) && ok;
+
+	if ( !ok ) throw std::runtime_error( "Unable to write file" );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	sFileName	Name of the file written by Save()
+///
+/// @return		An @c std::auto_ptr to the atlas, or 0 if it could not be loaded
+
+std::auto_ptr< TextureAtlas > TextureAtlas::Load( char const * sFileName )
+{
+	std::auto_ptr< TextureAtlas >	qAtlas;
+	FILE *							fp	= 0;
+
+	try
+	{
+		fp = fopen( sFileName, "r" );
+		if ( fp == 0 ) throw std::runtime_error( "Unable to open file" );
+
+		char	signature[ 8 ];
+		int		version;
+		int		pageSize;
+		int		gutter;
+		int		nPages;
+		int		nRegions;
+
+		if ( fscanf( fp, "%4s %d %d %d %d %d", signature, &version, &pageSize, &gutter, &nPages, &nRegions ) != 6 ||
+			 strcmp( signature, ATLAS_SIGNATURE ) != 0 || version != ATLAS_VERSION ||
+			 pageSize <= 0 || gutter < 0 || nPages < 0 || nRegions < 0 )
+		{
+			throw std::runtime_error( "Invalid atlas file" );
+		}
+
+		qAtlas.reset( new TextureAtlas( pageSize, gutter ) );
+
+		// Read the regions. The name is the rest of the line, so it may contain spaces. It is limited to
+		// _MAX_PATH - 1 characters, and a longer name is an error rather than being truncated.
+
+		for ( int i = 0; i < nRegions; i++ )
+		{
+			Region	region;
+			char	name[ _MAX_PATH ];
+
+			if ( fscanf( fp, "%d %d %d %d %d %259[^\n]",
+						 &region.page, &region.x, &region.y, &region.width, &region.height, name ) != 6 )
+			{
+				throw std::runtime_error( "Invalid atlas file" );
+			}
+
+			int const	next	= fgetc( fp );
+
+			if ( next != '\n' && next != EOF )
+			{
+				throw std::runtime_error( "Region name is too long" );
+			}
+
+			// The region must be entirely within its page
+
+			if ( region.page < 0 || region.page >= nPages ||
+				 region.x < 0 || region.y < 0 || region.width <= 0 || region.height <= 0 ||
+				 region.width > pageSize - region.x || region.height > pageSize - region.y )
+			{
+				throw std::runtime_error( "Invalid atlas file" );
+			}
+
+			region.u0	= float( region.x ) / float( pageSize );
+			region.v0	= float( region.y ) / float( pageSize );
+			region.u1	= float( region.x + region.width ) / float( pageSize );
+			region.v1	= float( region.y + region.height ) / float( pageSize );
+
+			qAtlas->m_Regions[ name ] = region;
+		}
+
+		fclose( fp );
+		fp = 0;
+
+		// Read the pages
+
+		for ( int i = 0; i < nPages; i++ )
+		{
+			BakedTextureFile	file( GetPageFileName( sFileName, i ).c_str() );
+
+			if ( file.GetWidth() != pageSize || file.GetHeight() != pageSize ||
+				 file.GetFormat() != GL_BGRA_EXT || file.GetTexelSize() != 4 )
+			{
+				throw std::runtime_error( "Invalid atlas page" );
+			}
+
+			uint8 const * const	pData	= file.GetLevelData( 0 );
+
+			qAtlas->m_Pages.push_back( std::vector< uint8 >( pData, pData + file.GetLevelInfo( 0 ).size ) );
+		}
+	}
+	catch ( ... )
+	{
+		if ( fp != 0 ) fclose( fp );
+		qAtlas.reset();
+	}
+
+	return qAtlas;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The gutter is filled by extending the edges of the image outward.
+
+void TextureAtlas::Copy( TgaImage const & image, int page, int x, int y )
+{
+	uint8 * const	pPage	= &m_Pages[ page ][ 0 ];
+
+	for ( int row = -m_Gutter; row < image.height + m_Gutter; row++ )
+	{
+		int const				srcRow	= std::max( 0, std::min( row, image.height - 1 ) );
+		uint8 const * const		pSrc	= image.pData + size_t( srcRow ) * image.width * image.texelSize;
+		uint8 *					pDst	= pPage + ( ( size_t( y ) + row ) * m_PageSize + x - m_Gutter ) * 4;
+
+		for ( int col = -m_Gutter; col < image.width + m_Gutter; col++ )
+		{
+			int const				srcCol	= std::max( 0, std::min( col, image.width - 1 ) );
+			uint8 const * const		pTexel	= pSrc + size_t( srcCol ) * image.texelSize;
+
+			switch ( image.texelSize )
+			{
+			case 1:		pDst[ 0 ] = pDst[ 1 ] = pDst[ 2 ] = pTexel[ 0 ];	pDst[ 3 ] = 0xff;		break;
+			case 2:		pDst[ 0 ] = pDst[ 1 ] = pDst[ 2 ] = pTexel[ 0 ];	pDst[ 3 ] = pTexel[ 1 ];	break;
+			default:	memcpy( pDst, pTexel, 4 );												break;
+			}
+
+			pDst += 4;
+		}
+	}
+}
+
+
+} // namespace GlObjects
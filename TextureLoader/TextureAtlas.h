@@ -0,0 +1,140 @@
+#if !defined( GLOBJECTS_TEXTUREATLAS_H_INCLUDED )
+#define GLOBJECTS_TEXTUREATLAS_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  TextureAtlas.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureAtlas.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gl/gl.h>
+#include "Misc/Types.h"
+
+namespace Glx
+{
+	class Texture;
+}
+
+namespace GlObjects
+{
+
+struct TgaImage;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Packs many small images into one or more large textures.
+///
+/// Images are added from TGA files and then packed into square pages with a MaxRects packer (best short side fit).
+/// Each image is surrounded by a gutter filled with copies of its edge texels, so that filtering near an edge does not
+/// blend in the neighboring images. The pages are 32-bit BGRA and are created as ordinary Glx::Texture objects. The
+/// location of each image is looked up by its file name.
+///
+/// An atlas can be packed when it is loaded, or it can be packed offline, saved, and loaded later with Load().
+/// Packing does not touch GL, so it can be done on any thread.
+
+class TextureAtlas
+{
+public:
+
+	/// The location of an image in the atlas
+	struct Region
+	{
+		int		page;			///< Index of the page containing the image
+		int		x, y;			///< Location of the lower-left corner of the image in the page, in texels
+		int		width, height;	///< Size of the image in texels
+		float	u0, v0;			///< Texture coordinates of the lower-left corner
+		float	u1, v1;			///< Texture coordinates of the upper-right corner
+	};
+
+	/// Constructor
+	TextureAtlas( int pageSize = 1024, int gutter = 2 );
+
+	/// Destructor
+	~TextureAtlas();
+
+	/// Adds an image from a TGA file
+	void Add( char const * sFileName );
+
+	/// Packs the images into pages
+	void Pack();
+
+	/// Returns the number of pages
+	int GetPageCount() const						{ return int( m_Pages.size() ); }
+
+	/// Returns the width and height of each page
+	int GetPageSize() const							{ return m_PageSize; }
+
+	/// Returns the width of the gutter around each image
+	int GetGutter() const							{ return m_Gutter; }
+
+	/// Returns the BGRA texels of a page
+	uint8 const * GetPageData( int page ) const		{ return &m_Pages[ page ][ 0 ]; }
+
+	/// Returns the location of an image, or 0 if it is not in the atlas
+	Region const * Find( char const * sFileName ) const;
+
+	/// Returns the number of images in the atlas
+	int GetRegionCount() const						{ return int( m_Regions.size() ); }
+
+	/// Creates a texture from a page
+	std::auto_ptr< Glx::Texture > CreateTexture( int page,
+												 GLenum minFiltering	= GL_LINEAR,
+												 GLenum magFiltering	= GL_LINEAR,
+												 GLuint id				= 0 ) const;
+
+	/// Saves the packed atlas
+	void Save( char const * sFileName ) const;
+
+	/// Loads an atlas saved by Save()
+	static std::auto_ptr< TextureAtlas > Load( char const * sFileName );
+
+private:
+
+	/// An image that has been added
+	struct Source
+	{
+		std::string		name;		///< Name of the file
+		TgaImage *		pImage;		///< The image
+	};
+
+	typedef std::vector< Source >				SourceList;
+	typedef std::vector< std::vector< uint8 > >	PageList;
+	typedef std::map< std::string, Region >		RegionMap;
+
+	// Prevent copying
+	TextureAtlas( TextureAtlas const & );
+	TextureAtlas & operator =( TextureAtlas const & );
+
+	// Copies an image and its gutter into a page
+	void Copy( TgaImage const & image, int page, int x, int y );
+
+	int			m_PageSize;		///< Width and height of each page
+	int			m_Gutter;		///< Width of the gutter around each image
+	SourceList	m_Sources;		///< The images that have been added
+	PageList	m_Pages;		///< The texels of each page
+	RegionMap	m_Regions;		///< The location of each image
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_TEXTUREATLAS_H_INCLUDED )
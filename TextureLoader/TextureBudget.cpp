@@ -0,0 +1,382 @@
+/** @file *//********************************************************************************************************
+
+                                                 TextureBudget.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureBudget.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "TextureBudget.h"
+
+#include <algorithm>
+#include <cassert>
+#include <gl/gl.h>
+
+// These are not defined by the OpenGL 1.1 headers
+
+#if !defined( GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB )
+#define GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB	0x86A0
+#endif
+
+#if !defined( GL_TEXTURE_COMPRESSED_ARB )
+#define GL_TEXTURE_COMPRESSED_ARB				0x86A1
+#endif
+
+namespace
+{
+
+// Returns the current time in seconds
+
+double GetTime()
+{
+	static double	s_SecondsPerCount	= 0.0;
+
+	if ( s_SecondsPerCount == 0.0 )
+	{
+		LARGE_INTEGER	frequency;
+		QueryPerformanceFrequency( &frequency );
+		s_SecondsPerCount = 1.0 / double( frequency.QuadPart );
+	}
+
+	LARGE_INTEGER	count;
+	QueryPerformanceCounter( &count );
+
+	return double( count.QuadPart ) * s_SecondsPerCount;
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureBudget::Resident::Resident()
+	: m_pBudget( 0 ),
+	m_Size( 0 ),
+	m_bResident( true )
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The texture is removed from its budget.
+
+TextureBudget::Resident::~Resident()
+{
+	if ( m_pBudget != 0 )
+	{
+		m_pBudget->Remove( this );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	budget	Maximum number of bytes of texture memory used by the resident textures. If 0, there is no limit
+///					and nothing is evicted, though the memory is still tracked.
+
+TextureBudget::TextureBudget( size_t budget /* = 0*/ )
+	: m_Budget( budget ),
+	m_ResidentSize( 0 ),
+	m_ManagedCount( 0 ),
+	m_EvictionCount( 0 ),
+	m_ReloadCount( 0 ),
+	m_ReloadFailureCount( 0 ),
+	m_TotalReloadTime( 0.0 ),
+	m_MaxReloadTime( 0.0 )
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @warning	All textures must be removed before the budget is destroyed.
+
+TextureBudget::~TextureBudget()
+{
+	assert( m_ManagedCount == 0 );
+
+	for ( ResidentList::iterator ppResident = m_Residents.begin(); ppResident != m_Residents.end(); ++ppResident )
+	{
+		( *ppResident )->m_pBudget = 0;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The texture is treated as the most-recently used texture. If the resident textures no longer fit in the budget,
+/// other textures are evicted.
+///
+/// @param	pResident	The texture. It must not already be managed by a budget.
+/// @param	size		Number of bytes of texture memory used by the texture (see GetBoundTextureSize())
+
+void TextureBudget::Add( Resident * pResident, size_t size )
+{
+	assert( pResident->m_pBudget == 0 );
+
+	pResident->m_pBudget	= this;
+	pResident->m_Size		= size;
+	pResident->m_bResident	= true;
+	pResident->m_Position	= m_Residents.insert( m_Residents.end(), pResident );
+
+	m_ResidentSize += size;
+	++m_ManagedCount;
+
+	Enforce( pResident );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The texture is not evicted. It is simply no longer tracked.
+
+void TextureBudget::Remove( Resident * pResident )
+{
+	assert( pResident->m_pBudget == this );
+
+	if ( pResident->m_bResident )
+	{
+		m_Residents.erase( pResident->m_Position );
+		m_ResidentSize -= pResident->m_Size;
+	}
+
+	pResident->m_pBudget = 0;
+	--m_ManagedCount;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function should be called whenever the texture is bound. If the texture has been evicted, it is reloaded
+/// and the time taken is recorded. The texture becomes the most-recently used texture, and if the resident textures
+/// no longer fit in the budget, other textures are evicted.
+///
+/// @return		@c true if the texture is resident
+
+bool TextureBudget::Use( Resident * pResident )
+{
+	assert( pResident->m_pBudget == this );
+
+	if ( pResident->m_bResident )
+	{
+		m_Residents.splice( m_Residents.end(), m_Residents, pResident->m_Position );
+		return true;
+	}
+
+	double const	start	= GetTime();
+	bool const		bLoaded	= pResident->Reload();
+	double const	elapsed	= GetTime() - start;
+
+	if ( !bLoaded )
+	{
+		++m_ReloadFailureCount;
+		return false;
+	}
+
+	++m_ReloadCount;
+	m_TotalReloadTime	+= elapsed;
+	m_MaxReloadTime		= std::max( m_MaxReloadTime, elapsed );
+
+	pResident->m_bResident	= true;
+	pResident->m_Position	= m_Residents.insert( m_Residents.end(), pResident );
+	m_ResidentSize += pResident->m_Size;
+
+	Enforce( pResident );
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If the resident textures no longer fit, the least-recently used textures are evicted immediately.
+
+void TextureBudget::SetBudget( size_t budget )
+{
+	m_Budget = budget;
+	Enforce( 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void TextureBudget::ResetStatistics()
+{
+	m_EvictionCount			= 0;
+	m_ReloadCount			= 0;
+	m_ReloadFailureCount	= 0;
+	m_TotalReloadTime		= 0.0;
+	m_MaxReloadTime			= 0.0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The size of each level of the texture bound to @c GL_TEXTURE_2D is queried from GL. The size of an uncompressed
+/// level is computed from the sizes of its components, so it does not include any padding added by the driver.
+///
+/// Only the levels of a full chain are queried (floor(log2(max(width, height))) levels after level 0), because GL
+/// raises @c GL_INVALID_VALUE for a level beyond its maximum and leaves the results unwritten.
+
+size_t TextureBudget::GetBoundTextureSize()
+{
+	static GLenum const	aComponents[] =
+	{
+		GL_TEXTURE_RED_SIZE,
+		GL_TEXTURE_GREEN_SIZE,
+		GL_TEXTURE_BLUE_SIZE,
+		GL_TEXTURE_ALPHA_SIZE,
+		GL_TEXTURE_LUMINANCE_SIZE,
+		GL_TEXTURE_INTENSITY_SIZE
+	};
+
+	// Find the last level of a full chain from the size of level 0
+
+	GLint	width0	= 0;
+	GLint	height0	= 0;
+
+	glGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width0 );
+	glGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height0 );
+
+	int	maxLevel	= 0;
+
+	for ( GLint n = std::max( width0, height0 ); n > 1; n /= 2 )
+	{
+		++maxLevel;
+	}
+
+	size_t	size	= 0;
+
+	for ( int level = 0; level <= maxLevel; level++ )
+	{
+		GLint	width	= 0;
+		GLint	height	= 0;
+
+		glGetTexLevelParameteriv( GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width );
+		glGetTexLevelParameteriv( GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height );
+
+		if ( width <= 0 || height <= 0 ) break;
+
+		GLint	bCompressed	= GL_FALSE;
+
+		glGetTexLevelParameteriv( GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_ARB, &bCompressed );
+
+		// If compression is not supported, the query fails and leaves the value unchanged
+
+		if ( bCompressed != GL_FALSE )
+		{
+			GLint	compressedSize	= 0;
+
+			glGetTexLevelParameteriv( GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB, &compressedSize );
+			size += compressedSize;
+		}
+		else
+		{
+			GLint	bits	= 0;
+
+			for ( size_t i = 0; i < sizeof( aComponents ) / sizeof( aComponents[ 0 ] ); i++ )
+			{
+				GLint	componentBits	= 0;
+
+				glGetTexLevelParameteriv( GL_TEXTURE_2D, level, aComponents[ i ], &componentBits );
+				bits += componentBits;
+			}
+
+			size += ( size_t( width ) * height * bits + 7 ) / 8;
+		}
+	}
+
+	return size;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The shared budget is never destroyed. Its budget is initially unlimited.
+
+TextureBudget & TextureBudget::GetShared()
+{
+	static TextureBudget * const	s_pShared	= new TextureBudget;
+
+	return *s_pShared;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void TextureBudget::Enforce( Resident * pKeep )
+{
+	if ( m_Budget == 0 ) return;
+
+	ResidentList::iterator	ppResident	= m_Residents.begin();
+
+	while ( m_ResidentSize > m_Budget && ppResident != m_Residents.end() )
+	{
+		Resident * const	pResident	= *ppResident;
+
+		if ( pResident == pKeep )
+		{
+			++ppResident;
+			continue;
+		}
+
+		ppResident = m_Residents.erase( ppResident );
+		m_ResidentSize -= pResident->m_Size;
+		pResident->m_bResident = false;
+		++m_EvictionCount;
+
+		pResident->Evict();
+	}
+}
+
+
+} // namespace GlObjects
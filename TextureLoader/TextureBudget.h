@@ -0,0 +1,172 @@
+#if !defined( GLOBJECTS_TEXTUREBUDGET_H_INCLUDED )
+#define GLOBJECTS_TEXTUREBUDGET_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                  TextureBudget.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureBudget.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <list>
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Keeps the texture memory used by a set of textures within a budget.
+///
+/// Each texture is represented by a Resident, which is registered with Add() when the texture is created and is
+/// passed to Use() whenever the texture is bound. When the resident textures exceed the budget, the least-recently
+/// used ones are evicted. An evicted texture is reloaded (or re-rendered) by the next call to Use().
+///
+/// The budget and its residents must only be used by the thread that owns the GL context.
+
+class TextureBudget
+{
+public:
+
+	class Resident;
+
+private:
+
+	typedef std::list< Resident * > ResidentList;
+
+public:
+
+	/// A texture whose memory is managed by a TextureBudget
+	class Resident
+	{
+		friend class TextureBudget;
+
+	public:
+
+		/// Constructor
+		Resident();
+
+		/// Destructor
+		virtual ~Resident();
+
+		/// Returns the budget that manages this texture, or 0 if it is not managed
+		TextureBudget * GetBudget() const		{ return m_pBudget; }
+
+		/// Returns @c true if the texture's memory has not been evicted
+		bool IsResident() const					{ return m_bResident; }
+
+		/// Returns the number of bytes of texture memory used by the texture when it is resident
+		size_t GetSize() const					{ return m_Size; }
+
+	protected:
+
+		/// Releases the texture's memory
+		virtual void Evict() = 0;
+
+		/// Restores the texture's memory. Returns @c false if the texture could not be restored.
+		virtual bool Reload() = 0;
+
+	private:
+
+		// Prevent copying
+		Resident( Resident const & );
+		Resident & operator =( Resident const & );
+
+		TextureBudget *				m_pBudget;		///< The budget that manages this texture
+		size_t						m_Size;			///< Bytes of texture memory used when resident
+		bool						m_bResident;	///< @c true if the texture's memory has not been evicted
+		ResidentList::iterator		m_Position;		///< Location in the budget's list (if resident)
+	};
+
+	/// Constructor
+	TextureBudget( size_t budget = 0 );
+
+	/// Destructor
+	~TextureBudget();
+
+	/// Starts managing a texture that has just been created
+	void Add( Resident * pResident, size_t size );
+
+	/// Stops managing a texture
+	void Remove( Resident * pResident );
+
+	/// Marks a texture as used, reloading it if it has been evicted. Returns @c false if it could not be reloaded.
+	bool Use( Resident * pResident );
+
+	/// Sets the budget. 0 means there is no limit.
+	void SetBudget( size_t budget );
+
+	/// Returns the budget
+	size_t GetBudget() const				{ return m_Budget; }
+
+	/// Returns the number of bytes used by the resident textures
+	size_t GetResidentSize() const			{ return m_ResidentSize; }
+
+	/// Returns the number of resident textures
+	int GetResidentCount() const			{ return int( m_Residents.size() ); }
+
+	/// Returns the number of textures being managed
+	int GetManagedCount() const				{ return m_ManagedCount; }
+
+	/// Returns the number of textures that have been evicted
+	int GetEvictionCount() const			{ return m_EvictionCount; }
+
+	/// Returns the number of evicted textures that have been reloaded
+	int GetReloadCount() const				{ return m_ReloadCount; }
+
+	/// Returns the number of evicted textures that could not be reloaded
+	int GetReloadFailureCount() const		{ return m_ReloadFailureCount; }
+
+	/// Returns the total time spent reloading textures, in seconds
+	double GetTotalReloadTime() const		{ return m_TotalReloadTime; }
+
+	/// Returns the longest time spent reloading a texture, in seconds
+	double GetMaxReloadTime() const			{ return m_MaxReloadTime; }
+
+	/// Resets the eviction and reload statistics
+	void ResetStatistics();
+
+	/// Returns the number of bytes of texture memory used by the currently bound 2D texture
+	static size_t GetBoundTextureSize();
+
+	/// Returns a budget that is shared by all users of GlObjects
+	static TextureBudget & GetShared();
+
+private:
+
+	// Prevent copying
+	TextureBudget( TextureBudget const & );
+	TextureBudget & operator =( TextureBudget const & );
+
+	// Evicts least-recently used textures (other than the given one) until the resident textures fit in the budget
+	void Enforce( Resident * pKeep );
+
+	size_t				m_Budget;				///< Maximum bytes used by the resident textures, or 0 if unlimited
+	size_t				m_ResidentSize;			///< Bytes used by the resident textures
+	ResidentList		m_Residents;			///< Resident textures, least-recently used first
+	int					m_ManagedCount;			///< Number of textures being managed
+	int					m_EvictionCount;		///< Number of evictions
+	int					m_ReloadCount;			///< Number of reloads
+	int					m_ReloadFailureCount;	///< Number of failed reloads
+	double				m_TotalReloadTime;		///< Total time spent reloading
+	double				m_MaxReloadTime;		///< Longest time spent reloading
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_TEXTUREBUDGET_H_INCLUDED )
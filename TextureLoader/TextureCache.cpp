@@ -0,0 +1,589 @@
+/** @file *//********************************************************************************************************
+
+                                                  TextureCache.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureCache.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "TextureCache.h"
+
+#include "TextureLoader.h"
+#include "Image.h"
+
+#include "Glx/Texture.h"
+#include "Glx/MipMappedTexture.h"
+
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Returns true if two decoded images have the same size, format, and pixels
+
+bool IsSameImage( GlObjects::Image const & a, GlObjects::Image const & b )
+{
+	return a.GetWidth() == b.GetWidth() &&
+		   a.GetHeight() == b.GetHeight() &&
+		   a.GetFormat() == b.GetFormat() &&
+		   a.GetTexelSize() == b.GetTexelSize() &&
+		   memcmp( a.GetData(), b.GetData(), a.GetSize() ) == 0;
+}
+
+} // anonymous namespace
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A texture in the cache
+
+struct TextureCache::Entry : public TextureBudget::Resident
+{
+	typedef std::vector< EntryMap::iterator > PositionList;
+
+	Glx::Texture *				pTexture;				///< The texture (if not mip-mapped)
+	Glx::MipMappedTexture *		pMipMappedTexture;		///< The texture (if mip-mapped)
+	int							referenceCount;			///< Number of handles referring to this entry
+	PositionList				positions;				///< Locations of this entry in the cache, one for each file
+	ContentMap::iterator		contentPosition;		///< Location of this entry in the cache by content
+
+	// Destroys the texture
+	virtual void Evict();
+
+	// Loads the texture again
+	virtual bool Reload();
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void TextureCache::Entry::Evict()
+{
+	delete pTexture;
+	delete pMipMappedTexture;
+
+	pTexture			= 0;
+	pMipMappedTexture	= 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Any of the files can be reloaded, since their content is the same.
+
+bool TextureCache::Entry::Reload()
+{
+	Key const &	key	= positions.front()->first;
+
+	if ( key.bMipMapped )
+	{
+		pMipMappedTexture = TextureLoader::LoadMipMapped( key.path.c_str(), key.wrap, key.minFiltering, key.magFiltering ).release();
+		return pMipMappedTexture != 0;
+	}
+	else
+	{
+		pTexture = TextureLoader::Load( key.path.c_str(), key.wrap, key.minFiltering, key.magFiltering ).release();
+		return pTexture != 0;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool TextureCache::Key::operator <( Key const & b ) const
+{
+	if ( path != b.path )					return path < b.path;
+	if ( wrap != b.wrap )					return wrap < b.wrap;
+	if ( minFiltering != b.minFiltering )	return minFiltering < b.minFiltering;
+	if ( magFiltering != b.magFiltering )	return magFiltering < b.magFiltering;
+
+	return bMipMapped < b.bMipMapped;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool TextureCache::ContentKey::operator <( ContentKey const & b ) const
+{
+	if ( hash != b.hash )					return hash < b.hash;
+	if ( wrap != b.wrap )					return wrap < b.wrap;
+	if ( minFiltering != b.minFiltering )	return minFiltering < b.minFiltering;
+	if ( magFiltering != b.magFiltering )	return magFiltering < b.magFiltering;
+
+	return bMipMapped < b.bMipMapped;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureCache::Handle::Handle()
+	: m_pCache( 0 ),
+	m_pEntry( 0 )
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureCache::Handle::Handle( TextureCache * pCache, Entry * pEntry )
+	: m_pCache( pCache ),
+	m_pEntry( pEntry )
+{
+	++m_pEntry->referenceCount;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureCache::Handle::Handle( Handle const & handle )
+	: m_pCache( handle.m_pCache ),
+	m_pEntry( handle.m_pEntry )
+{
+	if ( m_pEntry != 0 )
+	{
+		++m_pEntry->referenceCount;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureCache::Handle::~Handle()
+{
+	Reset();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureCache::Handle & TextureCache::Handle::operator =( Handle const & handle )
+{
+	// Add the new reference before releasing the old one, in case they are the same
+
+	if ( handle.m_pEntry != 0 )
+	{
+		++handle.m_pEntry->referenceCount;
+	}
+
+	Reset();
+
+	m_pCache = handle.m_pCache;
+	m_pEntry = handle.m_pEntry;
+
+	return *this;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+Glx::Texture * TextureCache::Handle::GetTexture() const
+{
+	return ( m_pEntry != 0 ) ? m_pEntry->pTexture : 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+Glx::MipMappedTexture * TextureCache::Handle::GetMipMappedTexture() const
+{
+	return ( m_pEntry != 0 ) ? m_pEntry->pMipMappedTexture : 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If the texture has been evicted by the cache's budget, it is reloaded first. If it can't be reloaded, nothing is
+/// bound.
+
+void TextureCache::Handle::Apply() const
+{
+	assert( m_pEntry != 0 );
+
+	TextureBudget * const	pBudget	= m_pEntry->GetBudget();
+
+	if ( pBudget != 0 && !pBudget->Use( m_pEntry ) ) return;
+
+	if ( m_pEntry->pMipMappedTexture != 0 )
+	{
+		m_pEntry->pMipMappedTexture->Apply();
+	}
+	else
+	{
+		m_pEntry->pTexture->Apply();
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If this is the last handle to the texture, the texture is destroyed.
+
+void TextureCache::Handle::Reset()
+{
+	if ( m_pEntry != 0 )
+	{
+		m_pCache->Release( m_pEntry );
+		m_pCache = 0;
+		m_pEntry = 0;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pBudget		Budget that manages the memory used by the textures. If 0, the textures are never evicted.
+
+TextureCache::TextureCache( TextureBudget * pBudget /* = 0*/ )
+	: m_pBudget( pBudget ),
+	m_HitCount( 0 ),
+	m_MissCount( 0 ),
+	m_DuplicateCount( 0 ),
+	m_DuplicateSize( 0 )
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @warning	All handles must be released before the cache is destroyed.
+
+TextureCache::~TextureCache()
+{
+	assert( m_Contents.empty() );
+
+	for ( ContentMap::iterator i = m_Contents.begin(); i != m_Contents.end(); ++i )
+	{
+		Entry * const	pEntry	= i->second;
+
+		delete pEntry->pTexture;
+		delete pEntry->pMipMappedTexture;
+		delete pEntry;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The texture is loaded with TextureLoader::Load() if it is not already in the cache and no texture with the same
+/// content is in the cache.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+///
+/// @return		A handle to the texture. If the texture could not be loaded, the handle is not valid.
+
+TextureCache::Handle TextureCache::Load( char const *	sFileName,
+										 GLenum			wrap			/* = GL_REPEAT*/,
+										 GLenum			minFiltering	/* = GL_LINEAR*/,
+										 GLenum			magFiltering	/* = GL_LINEAR*/ )
+{
+	return Request( sFileName, false, wrap, minFiltering, magFiltering );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The texture is loaded with TextureLoader::LoadMipMapped() if it is not already in the cache and no texture with the
+/// same content is in the cache.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+///
+/// @return		A handle to the texture. If the texture could not be loaded, the handle is not valid.
+
+TextureCache::Handle TextureCache::LoadMipMapped( char const *	sFileName,
+												  GLenum		wrap			/* = GL_REPEAT*/,
+												  GLenum		minFiltering	/* = GL_LINEAR_MIPMAP_LINEAR*/,
+												  GLenum		magFiltering	/* = GL_LINEAR*/ )
+{
+	return Request( sFileName, true, wrap, minFiltering, magFiltering );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void TextureCache::ResetStatistics()
+{
+	m_HitCount			= 0;
+	m_MissCount			= 0;
+	m_DuplicateCount	= 0;
+	m_DuplicateSize		= 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Different names for the same file (relative or absolute, with either kind of slash, in any case) have the same
+/// normalized name, so they share an entry.
+///
+/// @param	sFileName	Name of the file
+///
+/// @return		The full path of the file in lower case with backslashes, or the name as is if it is not a valid path
+
+std::string TextureCache::NormalizePath( char const * sFileName )
+{
+	char	path[ _MAX_PATH ];
+
+	if ( _fullpath( path, sFileName, sizeof( path ) ) == 0 )
+	{
+		return sFileName;
+	}
+
+	// File names are not case-sensitive and either kind of slash can be used
+
+	for ( char * p = path; *p != 0; ++p )
+	{
+		*p = ( *p == '/' ) ? '\\' : char( tolower( static_cast< unsigned char >( *p ) ) );
+	}
+
+	return path;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The shared cache is never destroyed, so handles to its textures can safely be held in static objects. Its textures
+/// are managed by TextureBudget::GetShared().
+
+TextureCache & TextureCache::GetShared()
+{
+	static TextureCache * const	s_pShared	= new TextureCache( &TextureBudget::GetShared() );
+
+	return *s_pShared;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+TextureCache::Handle TextureCache::Request( char const *	sFileName,
+											bool			bMipMapped,
+											GLenum			wrap,
+											GLenum			minFiltering,
+											GLenum			magFiltering )
+{
+	Key	key;
+
+	key.path			= NormalizePath( sFileName );
+	key.wrap			= wrap;
+	key.minFiltering	= minFiltering;
+	key.magFiltering	= magFiltering;
+	key.bMipMapped		= bMipMapped;
+
+	// Look for the texture in the cache
+
+	EntryMap::iterator const	i	= m_Entries.find( key );
+
+	if ( i != m_Entries.end() )
+	{
+		++m_HitCount;
+		return Handle( this, i->second );
+	}
+
+	++m_MissCount;
+
+	// Not found, so decode the file. If it can't be decoded, nothing is added to the cache.
+
+	std::auto_ptr< Image >	qImage	= TextureLoader::Decode( sFileName );
+	if ( qImage.get() == 0 ) return Handle();
+
+	Image const &	image	= *qImage;
+
+	// If a texture with the same content is already in the cache, this file becomes another name for it. Images with
+	// different content can have the same hash, so the pixels of each candidate are decoded again and compared.
+
+	ContentKey	contentKey;
+
+	contentKey.hash			= TextureLoader::HashImage( image );
+	contentKey.wrap			= wrap;
+	contentKey.minFiltering	= minFiltering;
+	contentKey.magFiltering	= magFiltering;
+	contentKey.bMipMapped	= bMipMapped;
+
+	std::pair< ContentMap::iterator, ContentMap::iterator > const	candidates	= m_Contents.equal_range( contentKey );
+
+	for ( ContentMap::iterator j = candidates.first; j != candidates.second; ++j )
+	{
+		Entry * const					pEntry		= j->second;
+		std::string const &				path		= pEntry->positions.front()->first.path;
+		std::auto_ptr< Image > const	qCandidate	= TextureLoader::Decode( path.c_str() );
+
+		if ( qCandidate.get() == 0 || !IsSameImage( image, *qCandidate ) )
+		{
+			continue;
+		}
+
+		pEntry->positions.push_back( m_Entries.insert( EntryMap::value_type( key, pEntry ) ).first );
+
+		++m_DuplicateCount;
+		m_DuplicateSize += image.GetSize();
+		if ( bMipMapped )
+		{
+			m_DuplicateSize += MipMapGenerator::GetChainSize( image.GetWidth(), image.GetHeight(), image.GetTexelSize() );
+		}
+
+		return Handle( this, pEntry );
+	}
+
+	// Upload it
+
+	std::auto_ptr< Glx::Texture >			qTexture;
+	std::auto_ptr< Glx::MipMappedTexture >	qMipMappedTexture;
+
+	if ( bMipMapped )
+	{
+		qMipMappedTexture = TextureLoader::UploadMipMapped( image, wrap, minFiltering, magFiltering );
+		if ( qMipMappedTexture.get() == 0 ) return Handle();
+	}
+	else
+	{
+		qTexture = TextureLoader::Upload( image, wrap, minFiltering, magFiltering );
+		if ( qTexture.get() == 0 ) return Handle();
+	}
+
+	std::auto_ptr< Entry >	qEntry( new Entry );
+
+	qEntry->pTexture			= qTexture.get();
+	qEntry->pMipMappedTexture	= qMipMappedTexture.get();
+	qEntry->referenceCount		= 0;
+	qEntry->positions.push_back( m_Entries.insert( EntryMap::value_type( key, qEntry.get() ) ).first );
+	qEntry->contentPosition		= m_Contents.insert( ContentMap::value_type( contentKey, qEntry.get() ) );
+
+	qTexture.release();
+	qMipMappedTexture.release();
+
+	// Register the texture with the budget. Its size is measured from GL.
+
+	if ( m_pBudget != 0 )
+	{
+		if ( qEntry->pMipMappedTexture != 0 )
+		{
+			qEntry->pMipMappedTexture->Apply();
+		}
+		else
+		{
+			qEntry->pTexture->Apply();
+		}
+
+		m_pBudget->Add( qEntry.get(), TextureBudget::GetBoundTextureSize() );
+	}
+
+	return Handle( this, qEntry.release() );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void TextureCache::Release( Entry * pEntry )
+{
+	assert( pEntry->referenceCount > 0 );
+
+	if ( --pEntry->referenceCount == 0 )
+	{
+		for ( size_t i = 0; i < pEntry->positions.size(); i++ )
+		{
+			m_Entries.erase( pEntry->positions[ i ] );
+		}
+		m_Contents.erase( pEntry->contentPosition );
+
+		delete pEntry->pTexture;
+		delete pEntry->pMipMappedTexture;
+		delete pEntry;
+	}
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,210 @@
+#if !defined( GLOBJECTS_TEXTURECACHE_H_INCLUDED )
+#define GLOBJECTS_TEXTURECACHE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                   TextureCache.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureCache.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <map>
+#include <string>
+#include <gl/gl.h>
+#include "TextureBudget.h"
+#include "Misc/Types.h"
+
+namespace Glx
+{
+	class Texture;
+	class MipMappedTexture;
+}
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A cache of textures loaded from TGA files.
+///
+/// Textures are shared by all requests with the same file, wrap mode, filtering modes, and mip-mapping, so each is
+/// loaded and uploaded only once. The texture is destroyed when the last handle to it is released. The cache and the
+/// handles must only be used by the thread that owns the GL context.
+///
+/// Files with different names but identical decoded pixels (the same cloud in several skyboxes, for example) also share
+/// a texture if they are requested with the same wrap mode, filtering modes, and mip-mapping. Candidates are found by
+/// the hash of their pixels (see TextureLoader::HashImage()), and a candidate's file is decoded again to confirm that
+/// the pixels are identical, so a duplicate is detected after it is decoded but before it is uploaded. The savings are
+/// reported by GetDuplicateCount() and GetDuplicateSize().
+///
+/// If the cache has a TextureBudget, each texture is registered with it, and binding a texture through a handle marks
+/// it as used. A texture evicted by the budget is reloaded from its file the next time it is bound.
+
+class TextureCache
+{
+private:
+
+	struct Entry;
+
+public:
+
+	class Handle;
+	friend class Handle;
+
+	/// A shared reference to a texture in the cache
+	class Handle
+	{
+		friend class TextureCache;
+
+	public:
+
+		/// Constructor
+		Handle();
+
+		/// Copy constructor
+		Handle( Handle const & handle );
+
+		/// Destructor
+		~Handle();
+
+		/// Assignment operator
+		Handle & operator =( Handle const & handle );
+
+		/// Returns @c true if the handle refers to a texture
+		bool IsValid() const		{ return m_pEntry != 0; }
+
+		/// Returns the texture, or 0 if the handle is empty, the texture is mip-mapped, or it has been evicted
+		Glx::Texture * GetTexture() const;
+
+		/// Returns the mip-mapped texture, or 0 if the handle is empty, the texture is not mip-mapped, or it has been evicted
+		Glx::MipMappedTexture * GetMipMappedTexture() const;
+
+		/// Binds the texture
+		void Apply() const;
+
+		/// Releases the reference to the texture
+		void Reset();
+
+	private:
+
+		// Constructor
+		Handle( TextureCache * pCache, Entry * pEntry );
+
+		TextureCache *	m_pCache;		///< The cache that holds the texture
+		Entry *			m_pEntry;		///< The texture's entry in the cache
+	};
+
+	/// Constructor
+	TextureCache( TextureBudget * pBudget = 0 );
+
+	/// Destructor
+	~TextureCache();
+
+	/// Returns a handle to a texture, loading it if it is not in the cache
+	Handle Load( char const * sFileName,
+				 GLenum wrap			= GL_REPEAT,
+				 GLenum minFiltering	= GL_LINEAR,
+				 GLenum magFiltering	= GL_LINEAR );
+
+	/// Returns a handle to a mip-mapped texture, loading it if it is not in the cache
+	Handle LoadMipMapped( char const * sFileName,
+						  GLenum wrap			= GL_REPEAT,
+						  GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
+						  GLenum magFiltering	= GL_LINEAR );
+
+	/// Returns the number of requests that were satisfied by a texture already in the cache
+	int GetHitCount() const				{ return m_HitCount; }
+
+	/// Returns the number of requests that required a texture to be loaded
+	int GetMissCount() const			{ return m_MissCount; }
+
+	/// Returns the number of loads that found a texture with identical content already in the cache
+	int GetDuplicateCount() const		{ return m_DuplicateCount; }
+
+	/// Returns the number of bytes of texel data that were not uploaded because they were duplicates
+	size_t GetDuplicateSize() const		{ return m_DuplicateSize; }
+
+	/// Returns the number of textures in the cache
+	int GetTextureCount() const			{ return int( m_Contents.size() ); }
+
+	/// Returns the number of file names that refer to textures in the cache
+	int GetFileCount() const			{ return int( m_Entries.size() ); }
+
+	/// Resets the hit, miss, and duplicate counts
+	void ResetStatistics();
+
+	/// Returns the budget that manages the textures, or 0 if they are not managed
+	TextureBudget * GetBudget() const	{ return m_pBudget; }
+
+	/// Returns a cache that is shared by all users of GlObjects
+	static TextureCache & GetShared();
+
+	/// Returns the name that identifies a file in the cache
+	static std::string NormalizePath( char const * sFileName );
+
+private:
+
+	/// Identifies a texture in the cache
+	struct Key
+	{
+		std::string		path;				///< Normalized path of the file
+		GLenum			wrap;				///< Wrap mode
+		GLenum			minFiltering;		///< Minification filter
+		GLenum			magFiltering;		///< Magnification filter
+		bool			bMipMapped;			///< If @c true, the texture is mip-mapped
+
+		bool operator <( Key const & b ) const;
+	};
+
+	/// Identifies the content of a texture in the cache
+	struct ContentKey
+	{
+		uint64			hash;				///< Hash of the decoded image (see TextureLoader::HashImage())
+		GLenum			wrap;				///< Wrap mode
+		GLenum			minFiltering;		///< Minification filter
+		GLenum			magFiltering;		///< Magnification filter
+		bool			bMipMapped;			///< If @c true, the texture is mip-mapped
+
+		bool operator <( ContentKey const & b ) const;
+	};
+
+	typedef std::map< Key, Entry * >		EntryMap;
+	typedef std::multimap< ContentKey, Entry * >	ContentMap;
+
+	// Prevent copying
+	TextureCache( TextureCache const & );
+	TextureCache & operator =( TextureCache const & );
+
+	// Finds or loads a texture
+	Handle Request( char const * sFileName, bool bMipMapped, GLenum wrap, GLenum minFiltering, GLenum magFiltering );
+
+	// Releases a reference to an entry, destroying the texture if it was the last one
+	void Release( Entry * pEntry );
+
+	EntryMap		m_Entries;			///< The textures in the cache, by file
+	ContentMap		m_Contents;			///< The textures in the cache, by content
+	TextureBudget *	m_pBudget;			///< The budget that manages the textures (or 0)
+	int				m_HitCount;			///< Number of requests satisfied by the cache
+	int				m_MissCount;		///< Number of requests that required a load
+	int				m_DuplicateCount;	///< Number of loads that found a texture with the same content
+	size_t			m_DuplicateSize;	///< Number of bytes of texel data not uploaded because of duplicates
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_TEXTURECACHE_H_INCLUDED )
@@ -16,26 +16,231 @@
 
 #include "TextureLoader.h"
 
+#include "ArrayTexture.h"
+#include "BakedTextureFile.h"
+#include "DxtCompressor.h"
+#include "PixelBufferRing.h"
+#include "ScopedUnpackAlignment.h"
+#include "ScratchArena.h"
+#include "Image.h"
+
 #include "Glx/Texture.h"
 #include "Glx/MipMappedTexture.h"
 #include "Misc/auto_array_ptr.h"
-#include "Misc/Types.h"
-#include "TgaFile/TgaFile.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <memory>
+#include <process.h>
+#include <stdexcept>
 #include <utility>
+#include <vector>
+
+namespace
+{
+
+// OpenGL 1.2 definitions
+
+#if !defined( GL_TEXTURE_MAX_LEVEL )
+#define GL_TEXTURE_MAX_LEVEL		0x813D
+#endif
+
+// Makes sure that a custom mip level has the same format as level 0, and that its size is the size of level 0 halved
+// once per level (but not less than 1) in each dimension.
+
+void CheckMipLevel( GlObjects::Image const & level, int i, GLenum format, int texelSize, int width, int height )
+{
+	if ( level.GetFormat() != format || level.GetTexelSize() != texelSize )
+	{
+		throw std::runtime_error( "Inconsistent pixel format" );
+	}
+
+	for ( int j = 0; j < i; j++ )
+	{
+		width	= ( width > 1 ) ? width / 2 : 1;
+		height	= ( height > 1 ) ? height / 2 : 1;
+	}
+
+	if ( level.GetWidth() != width || level.GetHeight() != height )
+	{
+		throw std::runtime_error( "Inconsistent mip level size" );
+	}
+}
+
+// Loads a TGA file into the next pixel buffer in the ring. When this function returns, the buffer is unmapped and
+// bound, so the image's data should be uploaded using an offset of 0 rather than its data pointer.
+//
+// The buffer is mapped write-only, and its memory is usually uncached or write-combined, so reading it back is
+// undefined and very slow. The decoder reads what it has written (RLE runs, flipping, swizzling), so the image is
+// decoded in CPU memory (from pAllocator, if not 0) and then written to the buffer with one sequential copy.
+
+void LoadTgaImageIntoPixelBuffer( char const *					sFileName,
+								  unsigned						flags,
+								  GlObjects::PixelBufferRing *	pRing,
+								  GlObjects::TgaImageAllocator *	pAllocator,
+								  GlObjects::Image *			pImage )
+{
+	pImage->LoadTga( sFileName, flags, pAllocator );
+
+	size_t const	size	= pImage->GetSize();
+	void * const	pBuffer	= pRing->Map( size );
+	if ( pBuffer == 0 ) throw std::bad_alloc();
+
+	memcpy( pBuffer, pImage->GetData(), size );
+
+	if ( !pRing->Unmap() ) throw std::runtime_error( "Pixel buffer data was lost" );
+}
+
+// Serializes allocations from another allocator, so that it can be shared by several threads
+
+class SynchronizedAllocator : public GlObjects::TgaImageAllocator
+{
+public:
+
+	SynchronizedAllocator( GlObjects::TgaImageAllocator * pAllocator )
+		: m_pAllocator( pAllocator )
+	{
+		InitializeCriticalSection( &m_Lock );
+	}
+
+	virtual ~SynchronizedAllocator()
+	{
+		DeleteCriticalSection( &m_Lock );
+	}
+
+	virtual uint8 * Allocate( size_t size )
+	{
+		EnterCriticalSection( &m_Lock );
+		uint8 * const	pBuffer	= m_pAllocator->Allocate( size );
+		LeaveCriticalSection( &m_Lock );
+
+		return pBuffer;
+	}
+
+private:
+
+	GlObjects::TgaImageAllocator *	m_pAllocator;
+	CRITICAL_SECTION				m_Lock;
+};
+
+// Loads a set of TGA files concurrently. Each file is loaded by the next available thread, and the calling thread
+// loads files too. Once any file fails to load, no more files are started.
+
+class ParallelTgaLoader
+{
+public:
+
+	ParallelTgaLoader( char const * const * pasFileNames, int nImages, unsigned flags, GlObjects::Image * aImages,
+					   GlObjects::TgaImageAllocator * pAllocator )
+		: m_pasFileNames( pasFileNames ),
+		m_nImages( nImages ),
+		m_Flags( flags ),
+		m_aImages( aImages ),
+		m_pAllocator( pAllocator ),
+		m_NextImage( 0 ),
+		m_Failed( 0 )
+	{
+	}
+
+	// Loads the images and returns true if they were all loaded
+	bool Load()
+	{
+		SYSTEM_INFO	info;
+		GetSystemInfo( &info );
+
+		// The calling thread loads images too, so one less worker than the number of images is needed
+
+		int const				nWorkers	= std::min( int( info.dwNumberOfProcessors ), m_nImages ) - 1;
+		std::vector< HANDLE >	threads;
+
+		threads.reserve( std::max( nWorkers, 0 ) );
+
+		for ( int i = 0; i < nWorkers; i++ )
+		{
+			HANDLE const	hThread	= (HANDLE)_beginthreadex( NULL, 0, WorkerThread, this, 0, NULL );
+
+			// If a thread can't be started, the remaining threads simply load more of the images
+
+			if ( hThread == 0 ) break;
+
+			threads.push_back( hThread );
+		}
+
+		Work();
+
+		for ( std::vector< HANDLE >::iterator pThread = threads.begin(); pThread != threads.end(); ++pThread )
+		{
+			WaitForSingleObject( *pThread, INFINITE );
+			CloseHandle( *pThread );
+		}
+
+		return m_Failed == 0;
+	}
+
+private:
+
+	// Prevent copying
+	ParallelTgaLoader( ParallelTgaLoader const & );
+	ParallelTgaLoader & operator =( ParallelTgaLoader const & );
+
+	static unsigned __stdcall WorkerThread( void * pArg )
+	{
+		static_cast< ParallelTgaLoader * >( pArg )->Work();
+		return 0;
+	}
+
+	// Loads images until there are none left or one has failed
+	void Work()
+	{
+		while ( m_Failed == 0 )
+		{
+			int const	i	= InterlockedIncrement( &m_NextImage ) - 1;
+
+			if ( i >= m_nImages ) break;
+
+			try
+			{
+				m_aImages[ i ].LoadTga( m_pasFileNames[ i ], m_Flags, m_pAllocator );
+			}
+			catch ( ... )
+			{
+				InterlockedExchange( &m_Failed, 1 );
+			}
+		}
+	}
+
+	char const * const *			m_pasFileNames;		///< Names of the files to load
+	int								m_nImages;			///< Number of files to load
+	unsigned						m_Flags;			///< Load flags
+	GlObjects::Image *				m_aImages;			///< Where the images are loaded
+	GlObjects::TgaImageAllocator *	m_pAllocator;		///< Supplies the image memory (must be thread-safe), or 0
+	LONG volatile					m_NextImage;		///< The next image to be loaded
+	LONG volatile					m_Failed;			///< Set if any image failed to load
+};
+
+} // anonymous namespace
+
 
 namespace GlObjects
 {
 
+unsigned					TextureLoader::s_LoadFlags				= TGA_LOAD_MAP;
+MipMapGenerator::Filter		TextureLoader::s_MipMapFilter			= MipMapGenerator::FILTER_BOX;
+bool						TextureLoader::s_bGammaCorrectMipMaps	= false;
+DxtCompressor::Quality		TextureLoader::s_CompressionQuality		= DxtCompressor::QUALITY_FAST;
+bool						TextureLoader::s_bUseScratchArena		= false;
+std::auto_ptr< MipMapGenerator >	TextureLoader::s_qMipMapGenerator;
+std::auto_ptr< DxtCompressor >		TextureLoader::s_qDxtCompressor;
+
 
 /********************************************************************************************************************/
 /*																													*/
 /*																													*/
 /********************************************************************************************************************/
 
-/// This function loads a texture from a TGA file. The file format must be uncompressed 24-bit or 32-bit.
+/// This function loads a texture from a TGA file. The file format must be 24-bit or 32-bit truecolor, or 8-bit or
+/// 16-bit grayscale, and may be run-length encoded.
 ///
 /// @param	sFileName		Name of the file to load
 /// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
@@ -43,10 +248,13 @@ namespace GlObjects
 ///							@c GL_TEXTURE_MIN_FILTER texture parameter.
 /// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
 ///							@c GL_TEXTURE_MAG_FILTER texture parameter.
-/// @param	id				Texture id. If 0 is specified, then an id is
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
 ///
 /// @return		An @c std::auto_ptr to the loaded texture.
 ///
+/// @note	If memory-mapping is enabled (see SetMemoryMapping()) and the file's pixels are stored with a bottom-left
+///			origin, the pixels are uploaded directly from the mapped file without being copied.
+///
 /// @warning	This function may throw a ConstructorFailedException, <tt>std::runtime_error</tt>, or a
 ///				<tt>std::bad_alloc</tt>.
 
@@ -56,65 +264,27 @@ std::auto_ptr< Glx::Texture > TextureLoader::Load( char const * sFileName,
 												   GLenum magFiltering		/* = GL_LINEAR*/,
 												   GLuint id				/* = 0*/ )
 {
-	Glx::Texture *	pTexture	= 0;
+	std::auto_ptr< Glx::Texture >	qTexture;
 
 	try
 	{
-		bool					ok;
-		TgaFile					file( sFileName );
-		auto_array_ptr< uint8 >	qaImageData;
-		GLenum					format;
-		int						texelSize;
-		
-		// Determine the characteristics of this image
-
-		if ( file.m_ImageType == TgaFile::IMAGE_TRUECOLOR )
-		{
-			if ( file.m_Depth == 32 && file.m_AlphaDepth == 8 )
-			{
-				texelSize	= 4;
-				format		= GL_BGRA_EXT;
-			}
-			else if ( file.m_Depth == 24 && file.m_AlphaDepth == 0 )
-			{
-				texelSize	= 3;
-				format		= GL_BGR_EXT;
-			}
-			else
-			{
-				throw std::runtime_error( "Invalid pixel format" );
-			}
-		}
-		else
-		{
-			throw std::runtime_error( "Invalid pixel format" );
-		}
-
-		// Create the texture
-
-		pTexture = new Glx::Texture( file.m_Width, file.m_Height,
-									 qaImageData.get(),
-									 format, GL_UNSIGNED_BYTE, wrap, minFiltering, magFiltering,
-									 id );
-		if ( pTexture == 0 ) throw std::bad_alloc();
+		ScratchArena * const	pArena	= GetScratchArena();
+		ScratchArena::Scope		scope( pArena );
+		Image					image;
 
-		// Allocate temporary space for the image data
+		// Load the image data
 
-		qaImageData = auto_array_ptr< uint8 >( new uint8[ file.m_Width * file.m_Height * texelSize ] );
-		if ( qaImageData.get() == 0 ) throw std::bad_alloc();
+		image.LoadTga( sFileName, s_LoadFlags, pArena );
 
-		// Load the image data
+		// Create the texture
 
-		ok = file.Read( qaImageData.get(), TgaFile::ORDER_BOTTOMLEFT );
-		if ( !ok ) throw std::runtime_error("TGAFile read failed" );
+		qTexture = Upload( image, wrap, minFiltering, magFiltering, id );
 	}
 	catch ( ... )
 	{
-		delete pTexture;
-		pTexture = 0;
 	}
 
-	return std::auto_ptr< Glx::Texture >( pTexture );
+	return qTexture;
 }
 
 
@@ -123,7 +293,9 @@ std::auto_ptr< Glx::Texture > TextureLoader::Load( char const * sFileName,
 /*																													*/
 /********************************************************************************************************************/
 
-/// This function loads a mip-mapped texture from a TGA file. The file format must be uncompressed 24-bit or 32-bit.
+/// This function loads a mip-mapped texture from a TGA file. The file format must be 24-bit or 32-bit truecolor, or
+/// 8-bit or 16-bit grayscale, and may be run-length encoded. The mip levels are generated by a MipMapGenerator using
+/// the filter set by SetMipMapFilter() and the mode set by SetGammaCorrectMipMaps().
 ///
 /// @param	sFileName		Name of the file to load
 /// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
@@ -131,7 +303,7 @@ std::auto_ptr< Glx::Texture > TextureLoader::Load( char const * sFileName,
 ///							@c GL_TEXTURE_MIN_FILTER texture parameter.
 /// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
 ///							@c GL_TEXTURE_MAG_FILTER texture parameter.
-/// @param	id				Texture id. If 0 is specified, then an id is
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
 ///
 /// @return		An @c std::auto_ptr to the loaded texture.
 ///
@@ -144,67 +316,27 @@ std::auto_ptr< Glx::MipMappedTexture > TextureLoader::LoadMipMapped( char const
 												   					 GLenum magFiltering	/* = GL_LINEAR*/,
 												   					 GLuint id				/* = 0*/ )
 {
-	Glx::MipMappedTexture *	pTexture	= 0;
+	std::auto_ptr< Glx::MipMappedTexture >	qTexture;
 
 	try
 	{
-		bool					ok;
-		TgaFile					file( sFileName );
-		auto_array_ptr< uint8 >	qaImageData;
-		GLenum					format;
-		int						texelSize;
-		
-		// Determine the characteristics of this image
-
-		if ( file.m_ImageType == TgaFile::IMAGE_TRUECOLOR )
-		{
-			if ( file.m_Depth == 32 && file.m_AlphaDepth == 8 )
-			{
-				texelSize	= 4;
-				format		= GL_BGRA_EXT;
-			}
-			else if ( file.m_Depth == 24 && file.m_AlphaDepth == 0 )
-			{
-				texelSize	= 3;
-				format		= GL_BGR_EXT;
-			}
-			else
-			{
-				throw std::runtime_error( "Invalid pixel format" );
-			}
-		}
-		else
-		{
-			throw std::runtime_error( "Invalid pixel format" );
-		}
-
-		// Create the texture
-
-		pTexture = new Glx::MipMappedTexture( file.m_Width, file.m_Height,
-											  format, GL_UNSIGNED_BYTE,
-											  wrap, minFiltering, magFiltering,
-											  id );
-		if ( pTexture == 0 ) throw std::bad_alloc();
-
-		// Allocate temporary space for the image data
-
-		qaImageData = auto_array_ptr< uint8 >( new uint8[ file.m_Width * file.m_Height * texelSize ] );
-		if ( qaImageData.get() == 0 ) throw std::bad_alloc();
+		ScratchArena * const	pArena	= GetScratchArena();
+		ScratchArena::Scope		scope( pArena );
+		Image					image;
 
 		// Load the image data
 
-		ok = file.Read( qaImageData.get(), TgaFile::ORDER_BOTTOMLEFT );
-		if ( !ok ) throw std::runtime_error( "TGAFile read failed" );
+		image.LoadTga( sFileName, s_LoadFlags, pArena );
 
-		pTexture->BuildAllMipMaps( qaImageData.get() );
+		// Create the texture and generate the mip levels
+
+		qTexture = UploadMipMapped( image, wrap, minFiltering, magFiltering, id );
 	}
 	catch ( ... )
 	{
-		delete pTexture;
-		pTexture = 0;
 	}
 
-	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+	return qTexture;
 }
 
 
@@ -213,16 +345,21 @@ std::auto_ptr< Glx::MipMappedTexture > TextureLoader::LoadMipMapped( char const
 /*																													*/
 /********************************************************************************************************************/
 
-/// This function loads a mip-mapped texture from a TGA file. The file format must be uncompressed 24-bit or 32-bit.
+/// This function loads a mip-mapped texture from a set of TGA files, one for each mip level. The file format must be
+/// 24-bit or 32-bit truecolor, or 8-bit or 16-bit grayscale, and may be run-length encoded.
 ///
-/// @param	pasFileNames	Array of the names of the files to load
+/// The files are read and decoded concurrently on worker threads. Every level is checked against the previous level
+/// before anything is uploaded, so a missing or mismatched level fails without creating the texture. The levels are
+/// uploaded in order on the calling thread.
+///
+/// @param	pasFileNames	Array of the names of the files to load, starting with level 0
 /// @param	nLevels			Number of names in the array
 /// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
 /// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
 ///							@c GL_TEXTURE_MIN_FILTER texture parameter.
 /// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
 ///							@c GL_TEXTURE_MAG_FILTER texture parameter.
-/// @param	id				Texture id. If 0 is specified, then an id is
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
 ///
 /// @return		An @c std::auto_ptr to the loaded texture.
 ///
@@ -240,92 +377,195 @@ std::auto_ptr< Glx::MipMappedTexture > TextureLoader::LoadMipMapped( char const
 
 	Glx::MipMappedTexture *	pTexture	= 0;
 
-	// Load the highest resolution mip level first to get the size and format of the texture
-
 	try
 	{
-		TgaFile		file( pasFileNames[ 0 ] );
-		GLenum		format;
-		int			texelSize;
-		int const	pixelDepth	= file.m_Depth;
-		int const	alphaDepth	= file.m_AlphaDepth;
-		
-		// Determine the characteristics of this image
+		ScratchArena * const		pArena	= GetScratchArena();
+		ScratchArena::Scope			scope( pArena );
+		auto_array_ptr< Image >		qaImages( new Image[ nLevels ] );
+
+		// Load all of the levels at once. The loading threads share the arena.
 
-		if ( file.m_ImageType == TgaFile::IMAGE_TRUECOLOR )
+		std::auto_ptr< SynchronizedAllocator >	qAllocator;
+
+		if ( pArena != 0 )
 		{
-			if ( pixelDepth == 32 && alphaDepth == 8 )
-			{
-				texelSize	= 4;
-				format		= GL_BGRA_EXT;
-			}
-			else if ( pixelDepth == 24 && alphaDepth == 0 )
-			{
-				texelSize	= 3;
-				format		= GL_BGR_EXT;
-			}
-			else
-			{
-				throw std::runtime_error( "Invalid pixel format" );
-			}
+			qAllocator.reset( new SynchronizedAllocator( pArena ) );
 		}
-		else
+
+		ParallelTgaLoader	loader( pasFileNames, nLevels, s_LoadFlags, qaImages.get(), qAllocator.get() );
+
+		if ( !loader.Load() )
+		{
+			throw std::runtime_error( "Unable to load a mip level" );
+		}
+
+		// Make sure the characteristics of each level match the first mip level and that each level is half the size
+		// of the previous level.
+
+		Image const &	base	= *qaImages.get();
+
+		for ( int i = 1; i < nLevels; i++ )
 		{
-			throw std::runtime_error( "Invalid pixel format" );
+			CheckMipLevel( qaImages.get()[ i ], i,
+						   base.GetFormat(), base.GetTexelSize(), base.GetWidth(), base.GetHeight() );
 		}
 
 		// Create the texture
 
-		pTexture = new Glx::MipMappedTexture( file.m_Width, file.m_Height,
-											  format, GL_UNSIGNED_BYTE,
+		pTexture = new Glx::MipMappedTexture( base.GetWidth(), base.GetHeight(),
+											  base.GetFormat(), GL_UNSIGNED_BYTE,
 											  wrap, minFiltering, magFiltering,
 											  id );
 		if ( pTexture == 0 ) throw std::bad_alloc();
-		
-		// Load the first mip level
 
+		// Upload the mip levels
+
+		ScopedUnpackAlignment	alignment;
+
+		for ( int i = 0; i < nLevels; i++ )
 		{
-			bool	ok;
+			pTexture->AddMipMap( i, qaImages.get()[ i ].GetData() );
+		}
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function loads a set of TGA files into the layers of a 2D texture array (see ArrayTexture). The file format
+/// must be 24-bit or 32-bit truecolor, or 8-bit or 16-bit grayscale, and may be run-length encoded. Every file must
+/// have the same size and format.
+///
+/// The files are read and decoded concurrently on worker threads, and every layer is checked before anything is
+/// uploaded. If mip-mapping is requested, the mip levels of each layer are generated by a MipMapGenerator using the
+/// filter set by SetMipMapFilter() and the mode set by SetGammaCorrectMipMaps(). The generator filters each level on
+/// all of its threads.
+///
+/// @param	pasFileNames	Array of the names of the files to load, starting with layer 0
+/// @param	nLayers			Number of names in the array
+/// @param	bMipMapped		If @c true, a full mip chain is generated for each layer
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the loaded texture, or 0 if it could not be loaded or texture arrays are not
+///				supported.
+
+std::auto_ptr< ArrayTexture > TextureLoader::LoadArray( char const * const * pasFileNames,
+														int nLayers,
+														bool bMipMapped			/* = false*/,
+														GLenum wrap				/* = GL_REPEAT*/,
+														GLenum minFiltering		/* = GL_LINEAR*/,
+														GLenum magFiltering		/* = GL_LINEAR*/,
+														GLuint id				/* = 0*/ )
+{
+	assert( nLayers > 0 );
+
+	ArrayTexture *	pTexture	= 0;
 
-			auto_array_ptr< uint8 >	qaImageData( new uint8[ file.m_Width * file.m_Height * texelSize ] );
-			if ( qaImageData.get() == 0 ) throw std::bad_alloc();
+	try
+	{
+		ScratchArena * const		pArena	= GetScratchArena();
+		ScratchArena::Scope			scope( pArena );
+		auto_array_ptr< Image >		qaImages( new Image[ nLayers ] );
 
-			// Load the image data
+		// Load all of the layers at once. The loading threads share the arena.
 
-			ok = file.Read( qaImageData.get(), TgaFile::ORDER_BOTTOMLEFT );
-			if ( !ok ) throw std::runtime_error( "TGAFile read failed" );
+		std::auto_ptr< SynchronizedAllocator >	qAllocator;
 
-			pTexture->AddMipMap( 0, qaImageData.get() );
+		if ( pArena != 0 )
+		{
+			qAllocator.reset( new SynchronizedAllocator( pArena ) );
 		}
 
-		// Load the rest of the mip levels
+		ParallelTgaLoader	loader( pasFileNames, nLayers, s_LoadFlags, qaImages.get(), qAllocator.get() );
 
-		for ( int i = 1; i < nLevels; i++ )
+		if ( !loader.Load() )
+		{
+			throw std::runtime_error( "Unable to load a layer" );
+		}
+
+		// Make sure every layer matches the first layer
+
+		Image const &	base	= *qaImages.get();
+
+		for ( int i = 1; i < nLayers; i++ )
 		{
-			TgaFile					file( pasFileNames[i] );
-			auto_array_ptr< uint8 >	qaImageData;
-			bool					ok;
-	
-			// Determine the characteristics of this image. Make sure they match the first mip level.
-
-			if ( file.m_ImageType != TgaFile::IMAGE_TRUECOLOR ||
-				 file.m_Depth != pixelDepth ||
-				 file.m_AlphaDepth != alphaDepth )
+			Image const &	layer	= qaImages.get()[ i ];
+
+			if ( layer.GetFormat() != base.GetFormat() || layer.GetTexelSize() != base.GetTexelSize() )
 			{
 				throw std::runtime_error( "Inconsistent pixel format" );
 			}
 
-			// Allocate temporary space for the image data
+			if ( layer.GetWidth() != base.GetWidth() || layer.GetHeight() != base.GetHeight() )
+			{
+				throw std::runtime_error( "Inconsistent layer size" );
+			}
+		}
+
+		// Create the texture
+
+		int const	nLevels	= bMipMapped ? MipMapGenerator::GetLevelCount( base.GetWidth(), base.GetHeight() ) : 1;
+
+		pTexture = new ArrayTexture( base.GetWidth(), base.GetHeight(), nLayers,
+									 base.GetFormat(), GL_UNSIGNED_BYTE,
+									 nLevels, wrap, minFiltering, magFiltering,
+									 id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+
+		// Upload each layer, generating its mip levels into a buffer that is reused for every layer
+
+		MipMapGenerator *		pGenerator	= 0;
+		auto_array_ptr< uint8 >	qaHeapChain;
+		uint8 *					pChain		= 0;
+
+		if ( nLevels > 1 )
+		{
+			pGenerator	= &GetMipMapGenerator();
+			pChain		= ScratchArena::AllocateBuffer( pArena,
+												   MipMapGenerator::GetChainSize( base.GetWidth(), base.GetHeight(), base.GetTexelSize() ),
+												   qaHeapChain );
+		}
+
+		for ( int i = 0; i < nLayers; i++ )
+		{
+			Image const &	layer	= qaImages.get()[ i ];
 
-			qaImageData = auto_array_ptr< uint8 >( new uint8[ file.m_Width * file.m_Height * texelSize ] );
-			if ( qaImageData.get() == 0 ) throw std::bad_alloc();
+			pTexture->SetLayer( 0, i, layer.GetData() );
 
-			// Load the image data
+			if ( nLevels > 1 )
+			{
+				pGenerator->BuildChain( layer.GetData(), layer.GetWidth(), layer.GetHeight(), layer.GetTexelSize(), pChain );
+
+				// The levels are stored consecutively in the chain
 
-			ok = file.Read( qaImageData.get(), TgaFile::ORDER_BOTTOMLEFT );
-			if ( !ok ) throw std::runtime_error( "TGAFile read failed" );
+				uint8 const *	pLevel	= pChain;
+				int				w		= layer.GetWidth();
+				int				h		= layer.GetHeight();
 
-			pTexture->AddMipMap( i, qaImageData.get() );
+				for ( int level = 1; level < nLevels; level++ )
+				{
+					w = ( w > 1 ) ? w / 2 : 1;
+					h = ( h > 1 ) ? h / 2 : 1;
+
+					pTexture->SetLayer( level, i, pLevel );
+					pLevel += size_t( w ) * h * layer.GetTexelSize();
+				}
+			}
 		}
 	}
 	catch ( ... )
@@ -334,7 +574,956 @@ std::auto_ptr< Glx::MipMappedTexture > TextureLoader::LoadMipMapped( char const
 		pTexture = 0;
 	}
 
-	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+	return std::auto_ptr< ArrayTexture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function loads a texture from a TGA file. The file format must be 24-bit or 32-bit truecolor, or 8-bit or
+/// 16-bit grayscale, and may be run-length encoded. The image is decoded in CPU memory, copied into a pixel buffer
+/// object, and the texture is created from the buffer, so the transfer to the GPU can overlap with decoding the next
+/// file.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	pRing			Pixel buffers to stream the data through
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the loaded texture.
+///
+/// @warning	This function may throw a ConstructorFailedException, <tt>std::runtime_error</tt>, or a
+///				<tt>std::bad_alloc</tt>.
+
+std::auto_ptr< Glx::Texture > TextureLoader::Load( char const * sFileName,
+												   PixelBufferRing * pRing,
+												   GLenum wrap				/* = GL_REPEAT*/,
+												   GLenum minFiltering		/* = GL_LINEAR*/,
+												   GLenum magFiltering		/* = GL_LINEAR*/,
+												   GLuint id				/* = 0*/ )
+{
+	assert( pRing != 0 );
+
+	Glx::Texture *	pTexture	= 0;
+
+	try
+	{
+		ScratchArena * const	pArena	= GetScratchArena();
+		ScratchArena::Scope		scope( pArena );
+		Image					image;
+
+		// Load the image data into a pixel buffer
+
+		LoadTgaImageIntoPixelBuffer( sFileName, s_LoadFlags, pRing, pArena, &image );
+
+		// Create the texture. The data comes from the bound pixel buffer.
+
+		ScopedUnpackAlignment	alignment;
+
+		pTexture = new Glx::Texture( image.GetWidth(), image.GetHeight(),
+									 0,
+									 image.GetFormat(), GL_UNSIGNED_BYTE, wrap, minFiltering, magFiltering,
+									 id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	pRing->Unbind();
+
+	return std::auto_ptr< Glx::Texture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function loads a mip-mapped texture from a TGA file. The file format must be 24-bit or 32-bit truecolor, or
+/// 8-bit or 16-bit grayscale, and may be run-length encoded. Each level is decoded in CPU memory, copied into a pixel
+/// buffer object, and uploaded from the buffer, so the transfer of one level to the GPU can overlap with decoding the
+/// next level.
+///
+/// @param	pasFileNames	Array of the names of the files to load
+/// @param	nLevels			Number of names in the array
+/// @param	pRing			Pixel buffers to stream the data through
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the loaded texture.
+///
+/// @warning	This function may throw a ConstructorFailedException, <tt>std::runtime_error</tt>, or a
+///				<tt>std::bad_alloc</tt>.
+
+std::auto_ptr< Glx::MipMappedTexture > TextureLoader::LoadMipMapped( char const * const * pasFileNames,
+																	 int nLevels,
+																	 PixelBufferRing * pRing,
+												   					 GLenum wrap			/* = GL_REPEAT*/,
+												   					 GLenum minFiltering	/* = GL_LINEAR_MIPMAP_LINEAR*/,
+												   					 GLenum magFiltering	/* = GL_LINEAR*/,
+												   					 GLuint id				/* = 0*/ )
+{
+	assert( nLevels > 0 );
+	assert( pRing != 0 );
+
+	Glx::MipMappedTexture *	pTexture	= 0;
+
+	try
+	{
+		ScopedUnpackAlignment	alignment;
+		GLenum					format;
+		int						texelSize;
+		int						width;
+		int						height;
+
+		for ( int i = 0; i < nLevels; i++ )
+		{
+			ScratchArena * const	pArena	= GetScratchArena();
+			ScratchArena::Scope		scope( pArena );
+			Image					level;
+
+			LoadTgaImageIntoPixelBuffer( pasFileNames[ i ], s_LoadFlags, pRing, pArena, &level );
+
+			// The highest resolution mip level determines the size and format of the texture
+
+			if ( i == 0 )
+			{
+				format		= level.GetFormat();
+				texelSize	= level.GetTexelSize();
+				width		= level.GetWidth();
+				height		= level.GetHeight();
+
+				pTexture = new Glx::MipMappedTexture( width, height,
+													  format, GL_UNSIGNED_BYTE,
+													  wrap, minFiltering, magFiltering,
+													  id );
+				if ( pTexture == 0 ) throw std::bad_alloc();
+			}
+			else
+			{
+				CheckMipLevel( level, i, format, texelSize, width, height );
+			}
+
+			// The data comes from the bound pixel buffer
+
+			pTexture->AddMipMap( i, 0 );
+		}
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	pRing->Unbind();
+
+	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function loads level 0 of a baked texture file (see BakedTextureFile). The file is memory-mapped and the
+/// pixels are uploaded directly from it, without being converted. Compressed data is uploaded with
+/// @c glCompressedTexImage2D.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the loaded texture.
+
+std::auto_ptr< Glx::Texture > TextureLoader::LoadBaked( char const * sFileName,
+														GLenum wrap				/* = GL_REPEAT*/,
+														GLenum minFiltering		/* = GL_LINEAR*/,
+														GLenum magFiltering		/* = GL_LINEAR*/,
+														GLuint id				/* = 0*/ )
+{
+	Glx::Texture *	pTexture	= 0;
+
+	try
+	{
+		BakedTextureFile		file( sFileName );
+		ScopedUnpackAlignment	alignment;
+
+		if ( file.IsCompressed() )
+		{
+			if ( !DxtCompressor::IsUploadSupported() ) throw std::runtime_error( "Texture compression is not supported" );
+
+			// Create the texture without any data and then replace level 0 with the compressed data
+
+			pTexture = new Glx::Texture( file.GetWidth(), file.GetHeight(),
+										 0,
+										 GL_RGBA, GL_UNSIGNED_BYTE,
+										 wrap, minFiltering, magFiltering,
+										 id );
+			if ( pTexture == 0 ) throw std::bad_alloc();
+
+			pTexture->Apply();
+			DxtCompressor::Upload( 0, file.GetWidth(), file.GetHeight(), file.GetFormat(),
+								   file.GetLevelInfo( 0 ).size, file.GetLevelData( 0 ) );
+		}
+		else
+		{
+			pTexture = new Glx::Texture( file.GetWidth(), file.GetHeight(),
+										 file.GetLevelData( 0 ),
+										 file.GetFormat(), file.GetType(),
+										 wrap, minFiltering, magFiltering,
+										 id );
+			if ( pTexture == 0 ) throw std::bad_alloc();
+		}
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::Texture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function loads a baked texture file (see BakedTextureFile). The file is memory-mapped and each level in the
+/// file is uploaded directly from it, without being converted. If the file contains only level 0, the rest of the
+/// levels are generated as they are by LoadMipMapped(). If an uncompressed file contains some but not all of the
+/// levels, the texture's @c GL_TEXTURE_MAX_LEVEL is set to the last level in the file. A compressed file must contain
+/// every level.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the loaded texture.
+
+std::auto_ptr< Glx::MipMappedTexture > TextureLoader::LoadBakedMipMapped( char const * sFileName,
+																		  GLenum wrap			/* = GL_REPEAT*/,
+																		  GLenum minFiltering	/* = GL_LINEAR_MIPMAP_LINEAR*/,
+																		  GLenum magFiltering	/* = GL_LINEAR*/,
+																		  GLuint id				/* = 0*/ )
+{
+	Glx::MipMappedTexture *	pTexture	= 0;
+
+	try
+	{
+		BakedTextureFile		file( sFileName );
+		ScopedUnpackAlignment	alignment;
+
+		if ( file.IsCompressed() )
+		{
+			if ( !DxtCompressor::IsUploadSupported() ) throw std::runtime_error( "Texture compression is not supported" );
+
+			// Compressed levels can't be generated here, so they must all be in the file
+
+			if ( file.GetLevelCount() < MipMapGenerator::GetLevelCount( file.GetWidth(), file.GetHeight() ) )
+			{
+				throw std::runtime_error( "Compressed baked texture is missing mip levels" );
+			}
+
+			pTexture = new Glx::MipMappedTexture( file.GetWidth(), file.GetHeight(),
+												  GL_RGBA, GL_UNSIGNED_BYTE,
+												  wrap, minFiltering, magFiltering,
+												  id );
+			if ( pTexture == 0 ) throw std::bad_alloc();
+
+			pTexture->Apply();
+
+			for ( int i = 0; i < file.GetLevelCount(); i++ )
+			{
+				BakedTextureFile::LevelInfo const &	level	= file.GetLevelInfo( i );
+
+				DxtCompressor::Upload( i, level.width, level.height, file.GetFormat(), level.size, file.GetLevelData( i ) );
+			}
+
+			return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+		}
+
+		pTexture = new Glx::MipMappedTexture( file.GetWidth(), file.GetHeight(),
+											  file.GetFormat(), file.GetType(),
+											  wrap, minFiltering, magFiltering,
+											  id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+
+		if ( file.GetLevelCount() > 1 )
+		{
+			for ( int i = 0; i < file.GetLevelCount(); i++ )
+			{
+				pTexture->AddMipMap( i, file.GetLevelData( i ) );
+			}
+
+			// If the file doesn't have a full chain, then the texture is incomplete unless it is limited to the
+			// levels that are present.
+
+			if ( file.GetLevelCount() < MipMapGenerator::GetLevelCount( file.GetWidth(), file.GetHeight() ) )
+			{
+				pTexture->Apply();
+				glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, file.GetLevelCount() - 1 );
+			}
+		}
+		else
+		{
+			GetMipMapGenerator().BuildAllMipMaps( pTexture,
+												  file.GetLevelData( 0 ), file.GetWidth(), file.GetHeight(), file.GetTexelSize(),
+												  GetScratchArena() );
+		}
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function loads a texture from a TGA file (see Load()) and compresses it with a DxtCompressor using the
+/// quality set by SetCompressionQuality(). The compressed image is uploaded with @c glCompressedTexImage2D.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	format			Compressed format. BC1 ignores alpha.
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the loaded texture, or 0 if S3TC compression is not supported.
+
+std::auto_ptr< Glx::Texture > TextureLoader::LoadCompressed( char const * sFileName,
+															 DxtCompressor::Format format	/* = DxtCompressor::FORMAT_BC1*/,
+															 GLenum wrap					/* = GL_REPEAT*/,
+															 GLenum minFiltering			/* = GL_LINEAR*/,
+															 GLenum magFiltering			/* = GL_LINEAR*/,
+															 GLuint id						/* = 0*/ )
+{
+	Glx::Texture *	pTexture	= 0;
+
+	try
+	{
+		if ( !DxtCompressor::IsUploadSupported() ) throw std::runtime_error( "Texture compression is not supported" );
+
+		ScratchArena * const	pArena	= GetScratchArena();
+		ScratchArena::Scope		scope( pArena );
+		Image					image;
+
+		// Load the image data
+
+		image.LoadTga( sFileName, s_LoadFlags, pArena );
+
+		// Compress it
+
+		size_t const			size			= DxtCompressor::GetCompressedSize( image.GetWidth(), image.GetHeight(), format );
+		auto_array_ptr< uint8 >	qaCompressed;
+		uint8 * const			pCompressed		= ScratchArena::AllocateBuffer( pArena, size, qaCompressed );
+
+		GetDxtCompressor().Compress( image.GetData(), image.GetWidth(), image.GetHeight(), image.GetFormat(),
+									 format, pCompressed );
+
+		// Create the texture without any data and then replace level 0 with the compressed image
+
+		pTexture = new Glx::Texture( image.GetWidth(), image.GetHeight(),
+									 0,
+									 image.GetFormat(), GL_UNSIGNED_BYTE,
+									 wrap, minFiltering, magFiltering,
+									 id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+
+		pTexture->Apply();
+		DxtCompressor::Upload( 0, image.GetWidth(), image.GetHeight(), DxtCompressor::GetInternalFormat( format ), size, pCompressed );
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::Texture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function loads a mip-mapped texture from a TGA file (see LoadMipMapped()). Each mip level is compressed with
+/// a DxtCompressor using the quality set by SetCompressionQuality() and uploaded with @c glCompressedTexImage2D.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	format			Compressed format. BC1 ignores alpha.
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the loaded texture, or 0 if S3TC compression is not supported.
+
+std::auto_ptr< Glx::MipMappedTexture >
+TextureLoader::LoadCompressedMipMapped( char const * sFileName,
+										DxtCompressor::Format format	/* = DxtCompressor::FORMAT_BC1*/,
+										GLenum wrap						/* = GL_REPEAT*/,
+										GLenum minFiltering				/* = GL_LINEAR_MIPMAP_LINEAR*/,
+										GLenum magFiltering				/* = GL_LINEAR*/,
+										GLuint id						/* = 0*/ )
+{
+	Glx::MipMappedTexture *	pTexture	= 0;
+
+	try
+	{
+		if ( !DxtCompressor::IsUploadSupported() ) throw std::runtime_error( "Texture compression is not supported" );
+
+		ScratchArena * const	pArena	= GetScratchArena();
+		ScratchArena::Scope		scope( pArena );
+		Image					image;
+
+		// Load the image data and generate the mip levels
+
+		image.LoadTga( sFileName, s_LoadFlags, pArena );
+
+		size_t const			chainSize	= MipMapGenerator::GetChainSize( image.GetWidth(), image.GetHeight(), image.GetTexelSize() );
+		auto_array_ptr< uint8 >	qaChain;
+		uint8 * const			pChain		= ScratchArena::AllocateBuffer( pArena, chainSize, qaChain );
+
+		GetMipMapGenerator().BuildChain( image.GetData(), image.GetWidth(), image.GetHeight(), image.GetTexelSize(), pChain );
+
+		// Create the texture
+
+		pTexture = new Glx::MipMappedTexture( image.GetWidth(), image.GetHeight(),
+											  image.GetFormat(), GL_UNSIGNED_BYTE,
+											  wrap, minFiltering, magFiltering,
+											  id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+
+		pTexture->Apply();
+
+		// Compress and upload each level. Level 0 is the largest, so its buffer is big enough for every level.
+
+		GLenum const			internalFormat	= DxtCompressor::GetInternalFormat( format );
+		size_t const			maxSize			= DxtCompressor::GetCompressedSize( image.GetWidth(), image.GetHeight(), format );
+		auto_array_ptr< uint8 >	qaCompressed;
+		uint8 * const			pCompressed		= ScratchArena::AllocateBuffer( pArena, maxSize, qaCompressed );
+
+		DxtCompressor &	compressor	= GetDxtCompressor();
+		uint8 const *	pLevel		= image.GetData();
+		uint8 const *	pNextLevel	= pChain;
+		int				width		= image.GetWidth();
+		int				height		= image.GetHeight();
+
+		for ( int i = 0; ; i++ )
+		{
+			compressor.Compress( pLevel, width, height, image.GetFormat(), format, pCompressed );
+			DxtCompressor::Upload( i, width, height, internalFormat,
+								   DxtCompressor::GetCompressedSize( width, height, format ), pCompressed );
+
+			if ( width == 1 && height == 1 )
+			{
+				break;
+			}
+
+			width		= std::max( width / 2, 1 );
+			height		= std::max( height / 2, 1 );
+			pLevel		= pNextLevel;
+			pNextLevel	+= size_t( width ) * height * image.GetTexelSize();
+		}
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function decodes a TGA file into CPU memory using the current load options, without touching GL. It can be
+/// called by any thread, and the image can be uploaded later with Upload() or UploadMipMapped() by the thread that
+/// owns the GL context. The file format must be 24-bit or 32-bit truecolor, or 8-bit or 16-bit grayscale, and may be
+/// run-length encoded.
+///
+/// @param	sFileName		Name of the file to load
+///
+/// @return		An @c std::auto_ptr to the image, or 0 if it could not be loaded.
+
+std::auto_ptr< Image > TextureLoader::Decode( char const * sFileName )
+{
+	std::auto_ptr< Image >	qImage;
+
+	try
+	{
+		qImage.reset( new Image );
+		qImage->LoadTga( sFileName, s_LoadFlags );
+	}
+	catch ( ... )
+	{
+		qImage.reset();
+	}
+
+	return qImage;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function is the upload step of Load(). It must be called by the thread that owns the GL context.
+///
+/// @param	image			The decoded image
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the texture, or 0 if it could not be created.
+
+std::auto_ptr< Glx::Texture > TextureLoader::Upload( Image const & image,
+													 GLenum wrap			/* = GL_REPEAT*/,
+													 GLenum minFiltering	/* = GL_LINEAR*/,
+													 GLenum magFiltering	/* = GL_LINEAR*/,
+													 GLuint id				/* = 0*/ )
+{
+	Glx::Texture *	pTexture	= 0;
+
+	try
+	{
+		ScopedUnpackAlignment	alignment;
+
+		pTexture = new Glx::Texture( image.GetWidth(), image.GetHeight(),
+									 image.GetData(),
+									 image.GetFormat(), GL_UNSIGNED_BYTE, wrap, minFiltering, magFiltering,
+									 id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::Texture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function is the upload step of LoadMipMapped(). It must be called by the thread that owns the GL context. The
+/// mip levels are generated by a MipMapGenerator using the
+/// filter set by SetMipMapFilter() and the mode set by SetGammaCorrectMipMaps().
+///
+/// @param	image			The decoded image
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the texture, or 0 if it could not be created.
+
+std::auto_ptr< Glx::MipMappedTexture > TextureLoader::UploadMipMapped( Image const & image,
+																	   GLenum wrap			/* = GL_REPEAT*/,
+																	   GLenum minFiltering	/* = GL_LINEAR_MIPMAP_LINEAR*/,
+																	   GLenum magFiltering	/* = GL_LINEAR*/,
+																	   GLuint id			/* = 0*/ )
+{
+	Glx::MipMappedTexture *	pTexture	= 0;
+
+	try
+	{
+		ScratchArena * const	pArena	= GetScratchArena();
+		ScratchArena::Scope		scope( pArena );
+
+		pTexture = new Glx::MipMappedTexture( image.GetWidth(), image.GetHeight(),
+											  image.GetFormat(), GL_UNSIGNED_BYTE,
+											  wrap, minFiltering, magFiltering,
+											  id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+
+		// Generate and upload the mip levels
+
+		GetMipMapGenerator().BuildAllMipMaps( pTexture,
+											  image.GetData(), image.GetWidth(), image.GetHeight(), image.GetTexelSize(),
+											  pArena );
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This function uploads mip levels that have already been built, so a thread other than the one that owns the GL
+/// context can build them with its own MipMapGenerator. It must be called by the thread that owns the GL context.
+///
+/// @param	image			The decoded image (level 0)
+/// @param	pChain			Levels 1 through n, built from @a image by MipMapGenerator::BuildChain()
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+/// @param	id				Texture id. If 0 is specified, then an id is generated.
+///
+/// @return		An @c std::auto_ptr to the texture, or 0 if it could not be created.
+
+std::auto_ptr< Glx::MipMappedTexture > TextureLoader::UploadMipMapped( Image const & image,
+																	   uint8 const * pChain,
+																	   GLenum wrap			/* = GL_REPEAT*/,
+																	   GLenum minFiltering	/* = GL_LINEAR_MIPMAP_LINEAR*/,
+																	   GLenum magFiltering	/* = GL_LINEAR*/,
+																	   GLuint id			/* = 0*/ )
+{
+	Glx::MipMappedTexture *	pTexture	= 0;
+
+	try
+	{
+		ScopedUnpackAlignment	alignment;
+
+		pTexture = new Glx::MipMappedTexture( image.GetWidth(), image.GetHeight(),
+											  image.GetFormat(), GL_UNSIGNED_BYTE,
+											  wrap, minFiltering, magFiltering,
+											  id );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+
+		pTexture->AddMipMap( 0, image.GetData() );
+		MipMapGenerator::UploadChain( pTexture, pChain, image.GetWidth(), image.GetHeight(), image.GetTexelSize() );
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return std::auto_ptr< Glx::MipMappedTexture >( pTexture );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The hash is a 64-bit MurmurHash (MurmurHash64A) of the pixels, seeded with the size and format. It is not
+/// cryptographic, but it reads the pixels 8 bytes at a time, so it is much faster than decoding them. Images with
+/// different content have the same hash with a probability of about 1 in 2^64.
+///
+/// @param	image	The decoded image
+
+uint64 TextureLoader::HashImage( Image const & image )
+{
+	uint64 const	m	= ( uint64( 0xc6a4a793 ) << 32 ) | 0x5bd1e995;
+	int const		r	= 47;
+
+	size_t const			size	= image.GetSize();
+	uint8 const *			p		= image.GetData();
+	uint8 const * const		pEnd	= p + ( size & ~size_t( 7 ) );
+
+	uint64	h	= ( uint64( image.GetWidth() ) << 40 ) ^ ( uint64( image.GetHeight() ) << 16 ) ^ image.GetFormat() ^
+				  ( size * m );
+
+	for ( ; p < pEnd; p += 8 )
+	{
+		uint64	k;
+
+		memcpy( &k, p, sizeof( k ) );
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
+	}
+
+	// Mix in the last few bytes
+
+	switch ( size & 7 )
+	{
+	case 7: h ^= uint64( p[ 6 ] ) << 48;
+	case 6: h ^= uint64( p[ 5 ] ) << 40;
+	case 5: h ^= uint64( p[ 4 ] ) << 32;
+	case 4: h ^= uint64( p[ 3 ] ) << 24;
+	case 3: h ^= uint64( p[ 2 ] ) << 16;
+	case 2: h ^= uint64( p[ 1 ] ) << 8;
+	case 1: h ^= uint64( p[ 0 ] );
+			h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If enabled (the default), files are memory-mapped. Images that are already in the order and format that GL
+/// expects are then uploaded directly from the mapped file, and other images are converted directly from it.
+///
+/// @param	enable	If @c true, files are memory-mapped
+
+void TextureLoader::SetMemoryMapping( bool enable )
+{
+	SetLoadFlag( TGA_LOAD_MAP, enable );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+bool TextureLoader::IsMemoryMapping()
+{
+	return ( s_LoadFlags & TGA_LOAD_MAP ) != 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// 24-bit data is slow to upload on most drivers and requires @c GL_UNPACK_ALIGNMENT to be 1. If enabled, 24-bit
+/// images are expanded to opaque 32-bit BGRA when they are loaded.
+///
+/// @param	enable	If @c true, 24-bit images are expanded
+
+void TextureLoader::SetExpandToBgra( bool enable )
+{
+	SetLoadFlag( TGA_LOAD_EXPAND_TO_BGRA, enable );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// This is for drivers that do not support @c GL_EXT_bgra. If enabled, all images are converted to 32-bit RGBA.
+///
+/// @param	enable	If @c true, images are converted to RGBA
+
+void TextureLoader::SetRgbaOrder( bool enable )
+{
+	SetLoadFlag( TGA_LOAD_RGBA_ORDER, enable );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	enable	If @c true, the color components of 32-bit images are multiplied by alpha when loaded
+
+void TextureLoader::SetPremultipliedAlpha( bool enable )
+{
+	SetLoadFlag( TGA_LOAD_PREMULTIPLY_ALPHA, enable );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	filter	The filter used to build each mip level from the previous level. The default is
+///					MipMapGenerator::FILTER_BOX.
+
+void TextureLoader::SetMipMapFilter( MipMapGenerator::Filter filter )
+{
+	s_MipMapFilter = filter;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Averaging sRGB-encoded values directly darkens the smaller mip levels. If enabled, the color components are
+/// converted to linear space before they are filtered. Alpha is always filtered as is.
+///
+/// @param	enable	If @c true, mip maps are generated in linear space
+
+void TextureLoader::SetGammaCorrectMipMaps( bool enable )
+{
+	s_bGammaCorrectMipMaps = enable;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	quality		The quality used by LoadCompressed() and LoadCompressedMipMapped(). The default is
+///						DxtCompressor::QUALITY_FAST.
+
+void TextureLoader::SetCompressionQuality( DxtCompressor::Quality quality )
+{
+	// The quality of the shared compressor is fixed when it is created, so it must be recreated
+
+	if ( quality != s_CompressionQuality )
+	{
+		s_qDxtCompressor.reset();
+	}
+
+	s_CompressionQuality = quality;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If enabled, images and mip levels are staged in the loading thread's ScratchArena (see
+/// ScratchArena::GetThreadArena()) instead of being allocated from the heap for each load. The arena's memory is
+/// reused by the next load, and its peak usage shows how much staging memory a batch of loads needs. A caller can
+/// supply the arena with ScratchArena::SetThreadArena(). The default is disabled.
+///
+/// @param	enable	If @c true, images are staged in a ScratchArena
+
+void TextureLoader::SetUseScratchArena( bool enable )
+{
+	s_bUseScratchArena = enable;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void TextureLoader::SetLoadFlag( unsigned flag, bool enable )
+{
+	if ( enable )
+	{
+		s_LoadFlags |= flag;
+	}
+	else
+	{
+		s_LoadFlags &= ~flag;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+ScratchArena * TextureLoader::GetScratchArena()
+{
+	return s_bUseScratchArena ? &ScratchArena::GetThreadArena() : 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// The generator's worker threads are created the first time it is needed and are reused by every load after that,
+// rather than being created and destroyed for each image. Like the rest of the loader, it must only be used by the
+// thread that owns the GL context.
+
+MipMapGenerator & TextureLoader::GetMipMapGenerator()
+{
+	if ( s_qMipMapGenerator.get() == 0 )
+	{
+		s_qMipMapGenerator.reset( new MipMapGenerator( s_MipMapFilter, s_bGammaCorrectMipMaps ) );
+	}
+
+	s_qMipMapGenerator->SetFilter( s_MipMapFilter );
+	s_qMipMapGenerator->SetGammaCorrect( s_bGammaCorrectMipMaps );
+
+	return *s_qMipMapGenerator;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+// Like the mip map generator, the compressor's worker threads are created the first time it is needed and are reused
+// by every compressed load after that. It is recreated only if SetCompressionQuality() changes the quality.
+
+DxtCompressor & TextureLoader::GetDxtCompressor()
+{
+	if ( s_qDxtCompressor.get() == 0 )
+	{
+		s_qDxtCompressor.reset( new DxtCompressor( s_CompressionQuality ) );
+	}
+
+	return *s_qDxtCompressor;
 }
 
 
@@ -21,10 +21,18 @@
 #include <gl/gl.h>
 #include "Glx/Texture.h"
 #include "Glx/MipMappedTexture.h"
+#include "DxtCompressor.h"
+#include "MipMapGenerator.h"
+#include "Misc/Types.h"
 
 namespace GlObjects
 {
 
+class ArrayTexture;
+class Image;
+class PixelBufferRing;
+class ScratchArena;
+
 
 /********************************************************************************************************************/
 /*																													*/
@@ -32,6 +40,9 @@ namespace GlObjects
 /********************************************************************************************************************/
 
 /// A class that loads a TGA file into a texture
+///
+/// A load can also be done in two steps. Decode() reads the file into an Image without touching GL, so it can be
+/// done on any thread, and Upload() or UploadMipMapped() then creates the texture on the thread that owns the context.
 
 class TextureLoader
 {
@@ -50,13 +61,162 @@ public:
 																 GLenum magFiltering	= GL_LINEAR,
 																 GLuint id				= 0 );
 
-	/// Loads a mip-mapped texture with custom mip levels
+	/// Loads a mip-mapped texture with custom mip levels, decoding the levels concurrently
+	static std::auto_ptr< Glx::MipMappedTexture > LoadMipMapped( char const * const * pasFileNames,
+																 int nLevels,
+																 GLenum wrap			= GL_REPEAT,
+																 GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
+																 GLenum magFiltering	= GL_LINEAR,
+																 GLuint id				= 0 );
+
+	/// Loads a set of same-sized images into the layers of a texture array
+	static std::auto_ptr< ArrayTexture > LoadArray( char const * const * pasFileNames,
+													int nLayers,
+													bool bMipMapped			= false,
+													GLenum wrap				= GL_REPEAT,
+													GLenum minFiltering		= GL_LINEAR,
+													GLenum magFiltering		= GL_LINEAR,
+													GLuint id				= 0 );
+
+	/// Loads a texture, streaming the data through a pixel buffer object
+	static std::auto_ptr< Glx::Texture > Load( char const * sFileName,
+											   PixelBufferRing * pRing,
+											   GLenum wrap				= GL_REPEAT,
+											   GLenum minFiltering		= GL_LINEAR,
+											   GLenum magFiltering		= GL_LINEAR,
+											   GLuint id				= 0 );
+
+	/// Loads a mip-mapped texture with custom mip levels, streaming the data through a pixel buffer object
 	static std::auto_ptr< Glx::MipMappedTexture > LoadMipMapped( char const * const * pasFileNames,
 																 int nLevels,
+																 PixelBufferRing * pRing,
 																 GLenum wrap			= GL_REPEAT,
 																 GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
 																 GLenum magFiltering	= GL_LINEAR,
 																 GLuint id				= 0 );
+
+	/// Loads a texture from a baked texture file
+	static std::auto_ptr< Glx::Texture > LoadBaked( char const * sFileName,
+													GLenum wrap				= GL_REPEAT,
+													GLenum minFiltering		= GL_LINEAR,
+													GLenum magFiltering		= GL_LINEAR,
+													GLuint id				= 0 );
+
+	/// Loads a mip-mapped texture from a baked texture file
+	static std::auto_ptr< Glx::MipMappedTexture > LoadBakedMipMapped( char const * sFileName,
+																	  GLenum wrap			= GL_REPEAT,
+																	  GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
+																	  GLenum magFiltering	= GL_LINEAR,
+																	  GLuint id				= 0 );
+
+	/// Loads a texture and compresses it
+	static std::auto_ptr< Glx::Texture > LoadCompressed( char const * sFileName,
+														 DxtCompressor::Format format	= DxtCompressor::FORMAT_BC1,
+														 GLenum wrap					= GL_REPEAT,
+														 GLenum minFiltering			= GL_LINEAR,
+														 GLenum magFiltering			= GL_LINEAR,
+														 GLuint id						= 0 );
+
+	/// Loads a mip-mapped texture and compresses each level
+	static std::auto_ptr< Glx::MipMappedTexture >
+		LoadCompressedMipMapped( char const * sFileName,
+								 DxtCompressor::Format format	= DxtCompressor::FORMAT_BC1,
+								 GLenum wrap					= GL_REPEAT,
+								 GLenum minFiltering			= GL_LINEAR_MIPMAP_LINEAR,
+								 GLenum magFiltering			= GL_LINEAR,
+								 GLuint id						= 0 );
+
+	/// Decodes a TGA file into CPU memory
+	static std::auto_ptr< Image > Decode( char const * sFileName );
+
+	/// Creates a texture from a decoded image
+	static std::auto_ptr< Glx::Texture > Upload( Image const & image,
+												 GLenum wrap			= GL_REPEAT,
+												 GLenum minFiltering	= GL_LINEAR,
+												 GLenum magFiltering	= GL_LINEAR,
+												 GLuint id				= 0 );
+
+	/// Creates a mip-mapped texture from a decoded image, generating its mip levels
+	static std::auto_ptr< Glx::MipMappedTexture > UploadMipMapped( Image const & image,
+																   GLenum wrap			= GL_REPEAT,
+																   GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
+																   GLenum magFiltering	= GL_LINEAR,
+																   GLuint id			= 0 );
+
+	/// Creates a mip-mapped texture from a decoded image and mip levels built by MipMapGenerator::BuildChain()
+	static std::auto_ptr< Glx::MipMappedTexture > UploadMipMapped( Image const & image,
+																   uint8 const * pChain,
+																   GLenum wrap			= GL_REPEAT,
+																   GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
+																   GLenum magFiltering	= GL_LINEAR,
+																   GLuint id			= 0 );
+
+	/// Returns a 64-bit hash of the size, format, and pixels of a decoded image
+	static uint64 HashImage( Image const & image );
+
+	/// Enables or disables loading by memory-mapping the file
+	static void SetMemoryMapping( bool enable );
+
+	/// Returns @c true if files are loaded by memory-mapping them
+	static bool IsMemoryMapping();
+
+	/// Enables or disables expanding 24-bit images to 32-bit BGRA
+	static void SetExpandToBgra( bool enable );
+
+	/// Enables or disables storing textures in RGBA order rather than BGR(A)
+	static void SetRgbaOrder( bool enable );
+
+	/// Enables or disables premultiplying the color of 32-bit images by alpha
+	static void SetPremultipliedAlpha( bool enable );
+
+	/// Returns the current load options (a combination of TgaLoadFlags)
+	static unsigned GetLoadFlags()					{ return s_LoadFlags; }
+
+	/// Sets the filter used to generate mip maps
+	static void SetMipMapFilter( MipMapGenerator::Filter filter );
+
+	/// Returns the filter used to generate mip maps
+	static MipMapGenerator::Filter GetMipMapFilter()	{ return s_MipMapFilter; }
+
+	/// Enables or disables generating mip maps in linear space
+	static void SetGammaCorrectMipMaps( bool enable );
+
+	/// Returns @c true if mip maps are generated in linear space
+	static bool IsGammaCorrectMipMaps()				{ return s_bGammaCorrectMipMaps; }
+
+	/// Sets the quality of texture compression
+	static void SetCompressionQuality( DxtCompressor::Quality quality );
+
+	/// Returns the quality of texture compression
+	static DxtCompressor::Quality GetCompressionQuality()	{ return s_CompressionQuality; }
+
+	/// Enables or disables staging images in the calling thread's ScratchArena
+	static void SetUseScratchArena( bool enable );
+
+	/// Returns @c true if images are staged in the calling thread's ScratchArena
+	static bool IsUsingScratchArena()				{ return s_bUseScratchArena; }
+
+private:
+
+	// Sets or clears load options
+	static void SetLoadFlag( unsigned flag, bool enable );
+
+	// Returns the arena that images are staged in, or 0 if they are allocated from the heap
+	static ScratchArena * GetScratchArena();
+
+	// Returns the generator used to build mip levels, configured with the current filter
+	static MipMapGenerator & GetMipMapGenerator();
+
+	// Returns the compressor used to compress textures, created with the current quality
+	static DxtCompressor & GetDxtCompressor();
+
+	static unsigned					s_LoadFlags;				///< How files are loaded (a combination of TgaLoadFlags)
+	static MipMapGenerator::Filter	s_MipMapFilter;				///< Filter used to generate mip maps
+	static bool						s_bGammaCorrectMipMaps;		///< If true, mip maps are generated in linear space
+	static DxtCompressor::Quality	s_CompressionQuality;		///< Quality of texture compression
+	static bool						s_bUseScratchArena;			///< If true, images are staged in a ScratchArena
+	static std::auto_ptr< MipMapGenerator >	s_qMipMapGenerator;	///< Shared by every load, or 0 until it is needed
+	static std::auto_ptr< DxtCompressor >	s_qDxtCompressor;	///< Shared by every load, or 0 until it is needed
 };
 
 
@@ -0,0 +1,477 @@
+/** @file *//********************************************************************************************************
+
+                                                TextureStreamer.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureStreamer.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "TextureStreamer.h"
+
+#include "BakedTextureFile.h"
+#include "DxtCompressor.h"
+#include "MipMapGenerator.h"
+#include "ScopedUnpackAlignment.h"
+
+#include "Glx/MipMappedTexture.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <stdexcept>
+
+// These are not defined by the OpenGL 1.1 headers
+
+#if !defined( GL_TEXTURE_BASE_LEVEL )
+#define GL_TEXTURE_BASE_LEVEL	0x813C
+#endif
+
+#if !defined( GL_TEXTURE_MAX_LEVEL )
+#define GL_TEXTURE_MAX_LEVEL	0x813D
+#endif
+
+namespace
+{
+
+// Returns true if the first texture has a higher priority than the second
+
+bool HigherPriority( GlObjects::StreamingTexture const * pA, GlObjects::StreamingTexture const * pB )
+{
+	return pA->GetPriority() > pB->GetPriority();
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pStreamer		The streamer that manages this texture
+/// @param	sFileName		Name of the baked texture file
+/// @param	tailSize		Levels no wider or taller than this are uploaded immediately and are never released
+/// @param	wrap			Wrap mode
+/// @param	minFiltering	Minification filter
+/// @param	magFiltering	Magnification filter
+///
+/// @warning	This function may throw a ConstructorFailedException, <tt>std::runtime_error</tt>, or a
+///				<tt>std::bad_alloc</tt>.
+
+StreamingTexture::StreamingTexture( TextureStreamer * pStreamer, char const * sFileName, int tailSize,
+									GLenum wrap, GLenum minFiltering, GLenum magFiltering )
+	: m_pStreamer( pStreamer ),
+	m_qFile( new BakedTextureFile( sFileName ) ),
+	m_TailLevel( 0 ),
+	m_ResidentLevel( 0 ),
+	m_DesiredLevel( 0 ),
+	m_TargetLevel( 0 ),
+	m_Priority( 0.0f )
+{
+	BakedTextureFile const &	file	= *m_qFile;
+	int const					nLevels	= file.GetLevelCount();
+
+	// Levels can't be generated as they are streamed, so they must all be in the file
+
+	if ( nLevels < MipMapGenerator::GetLevelCount( file.GetWidth(), file.GetHeight() ) )
+	{
+		throw std::runtime_error( "Streamed baked texture is missing mip levels" );
+	}
+
+	if ( file.IsCompressed() && !DxtCompressor::IsUploadSupported() )
+	{
+		throw std::runtime_error( "Texture compression is not supported" );
+	}
+
+	// Find the largest level of the tail
+
+	m_TailLevel = nLevels - 1;
+
+	for ( int i = 0; i < nLevels; i++ )
+	{
+		BakedTextureFile::LevelInfo const &	level	= file.GetLevelInfo( i );
+
+		if ( int( level.width ) <= tailSize && int( level.height ) <= tailSize )
+		{
+			m_TailLevel = i;
+			break;
+		}
+	}
+
+	// Create the texture. None of the levels are resident yet.
+
+	if ( file.IsCompressed() )
+	{
+		m_qTexture.reset( new Glx::MipMappedTexture( file.GetWidth(), file.GetHeight(),
+													 GL_RGBA, GL_UNSIGNED_BYTE,
+													 wrap, minFiltering, magFiltering,
+													 0 ) );
+	}
+	else
+	{
+		m_qTexture.reset( new Glx::MipMappedTexture( file.GetWidth(), file.GetHeight(),
+													 file.GetFormat(), file.GetType(),
+													 wrap, minFiltering, magFiltering,
+													 0 ) );
+	}
+	if ( m_qTexture.get() == 0 ) throw std::bad_alloc();
+
+	m_qTexture->Apply();
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, nLevels - 1 );
+
+	m_ResidentLevel	= nLevels;
+	m_DesiredLevel	= 0;
+	m_TargetLevel	= m_TailLevel;
+
+	// Upload the tail, smallest level first
+
+	while ( m_ResidentLevel > m_TailLevel )
+	{
+		UploadNextLevel();
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The texture is removed from its streamer.
+
+StreamingTexture::~StreamingTexture()
+{
+	if ( m_pStreamer != 0 )
+	{
+		m_pStreamer->Remove( this );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Levels finer than this are never uploaded, regardless of the budget. The level should be chosen according to how
+/// large the texture appears on the screen. The default is 0.
+///
+/// @param	level	The finest level that is wanted. It is clamped to the range [0, largest level in the tail].
+
+void StreamingTexture::SetDesiredLevel( int level )
+{
+	m_DesiredLevel = std::max( 0, std::min( level, m_TailLevel ) );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+int StreamingTexture::GetLevelCount() const
+{
+	return m_qFile->GetLevelCount();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void StreamingTexture::Apply() const
+{
+	m_qTexture->Apply();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+size_t StreamingTexture::GetSize( int level ) const
+{
+	size_t	size	= 0;
+
+	for ( int i = level; i < m_qFile->GetLevelCount(); i++ )
+	{
+		size += m_qFile->GetLevelInfo( i ).size;
+	}
+
+	return size;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The level is uploaded straight from the mapped file, and then the base level is lowered to include it.
+
+void StreamingTexture::UploadNextLevel()
+{
+	assert( m_ResidentLevel > 0 );
+
+	int const							level	= m_ResidentLevel - 1;
+	BakedTextureFile::LevelInfo const &	info	= m_qFile->GetLevelInfo( level );
+	ScopedUnpackAlignment				alignment;
+
+	if ( m_qFile->IsCompressed() )
+	{
+		m_qTexture->Apply();
+		DxtCompressor::Upload( level, info.width, info.height, m_qFile->GetFormat(), info.size, m_qFile->GetLevelData( level ) );
+	}
+	else
+	{
+		m_qTexture->AddMipMap( level, m_qFile->GetLevelData( level ) );
+	}
+
+	SetBaseLevel( level );
+	m_ResidentLevel = level;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The base level is raised first so that the texture remains complete, and then each released level is replaced by
+/// an empty image so that its memory is freed.
+
+void StreamingTexture::DropLevels( int level )
+{
+	assert( level > m_ResidentLevel && level <= m_TailLevel );
+
+	SetBaseLevel( level );
+
+	for ( int i = m_ResidentLevel; i < level; i++ )
+	{
+		glTexImage2D( GL_TEXTURE_2D, i, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
+	}
+
+	m_ResidentLevel = level;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void StreamingTexture::SetBaseLevel( int level )
+{
+	m_qTexture->Apply();
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	budget		Maximum number of bytes of texture memory used by the levels of the textures. The mip tails
+///						are always resident, even if they exceed the budget.
+/// @param	tailSize	Levels no wider or taller than this are uploaded when a texture is loaded and are never
+///						released.
+
+TextureStreamer::TextureStreamer( size_t budget, int tailSize /* = 64*/ )
+	: m_Budget( budget ),
+	m_TailSize( tailSize )
+{
+	assert( tailSize > 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The textures are not destroyed. They remain usable, but their levels are no longer streamed.
+
+TextureStreamer::~TextureStreamer()
+{
+	for ( TextureList::iterator ppTexture = m_Textures.begin(); ppTexture != m_Textures.end(); ++ppTexture )
+	{
+		( *ppTexture )->m_pStreamer = 0;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The file must be a baked texture file containing every mip level (see BakedTextureFile). The mip tail is uploaded
+/// before this function returns, and the finer levels are uploaded by later calls to Update(). The caller owns the
+/// returned texture and must delete it.
+///
+/// @param	sFileName		Name of the file to load
+/// @param	wrap			Wrap mode. The value can be any valid value for the @c GL_TEXTURE_WRAP_S texture parameter.
+/// @param	minFiltering	Filtering mode used when texels are "minified". The value can be any valid value for the
+///							@c GL_TEXTURE_MIN_FILTER texture parameter.
+/// @param	magFiltering	Filtering mode used when texels are "magnified". The value can be any valid value for the
+///							@c GL_TEXTURE_MAG_FILTER texture parameter.
+///
+/// @return		The texture, or 0 if it could not be loaded
+
+StreamingTexture * TextureStreamer::Load( char const * sFileName,
+										  GLenum wrap			/* = GL_REPEAT*/,
+										  GLenum minFiltering	/* = GL_LINEAR_MIPMAP_LINEAR*/,
+										  GLenum magFiltering	/* = GL_LINEAR*/ )
+{
+	StreamingTexture *	pTexture	= 0;
+
+	try
+	{
+		pTexture = new StreamingTexture( this, sFileName, m_TailSize, wrap, minFiltering, magFiltering );
+		if ( pTexture == 0 ) throw std::bad_alloc();
+
+		m_Textures.push_back( pTexture );
+	}
+	catch ( ... )
+	{
+		delete pTexture;
+		pTexture = 0;
+	}
+
+	return pTexture;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The budget is divided among the textures in order of priority. Each texture gets as many of its levels finer than
+/// the tail (down to its desired level) as fit in what is left of the budget. Then, levels that no longer fit are
+/// released immediately, and up to @p maxUploads levels are uploaded, one per texture, in order of priority.
+///
+/// @param	maxUploads	Maximum number of levels to upload. If -1, every texture is given its next level.
+///
+/// @return		The number of levels uploaded
+
+int TextureStreamer::Update( int maxUploads /* = 1*/ )
+{
+	TextureList	sorted( m_Textures );
+
+	std::stable_sort( sorted.begin(), sorted.end(), HigherPriority );
+
+	// The mip tails are always resident
+
+	size_t	tailSize	= 0;
+
+	for ( TextureList::const_iterator ppTexture = sorted.begin(); ppTexture != sorted.end(); ++ppTexture )
+	{
+		tailSize += ( *ppTexture )->GetSize( ( *ppTexture )->m_TailLevel );
+	}
+
+	size_t	available	= ( m_Budget > tailSize ) ? m_Budget - tailSize : 0;
+
+	// Divide the rest of the budget
+
+	for ( TextureList::const_iterator ppTexture = sorted.begin(); ppTexture != sorted.end(); ++ppTexture )
+	{
+		StreamingTexture * const	pTexture	= *ppTexture;
+		int							target		= pTexture->m_TailLevel;
+
+		while ( target > pTexture->m_DesiredLevel )
+		{
+			size_t const	size	= pTexture->m_qFile->GetLevelInfo( target - 1 ).size;
+
+			if ( size > available ) break;
+
+			available -= size;
+			--target;
+		}
+
+		pTexture->m_TargetLevel = target;
+	}
+
+	// Release the levels that no longer fit before uploading any, so the budget is never exceeded
+
+	for ( TextureList::const_iterator ppTexture = sorted.begin(); ppTexture != sorted.end(); ++ppTexture )
+	{
+		StreamingTexture * const	pTexture	= *ppTexture;
+
+		if ( pTexture->m_ResidentLevel < pTexture->m_TargetLevel )
+		{
+			pTexture->DropLevels( pTexture->m_TargetLevel );
+		}
+	}
+
+	// Upload the next level of the most important textures
+
+	int	nUploads	= 0;
+
+	for ( TextureList::const_iterator ppTexture = sorted.begin();
+		  ppTexture != sorted.end() && ( maxUploads < 0 || nUploads < maxUploads );
+		  ++ppTexture )
+	{
+		StreamingTexture * const	pTexture	= *ppTexture;
+
+		if ( pTexture->m_ResidentLevel > pTexture->m_TargetLevel )
+		{
+			pTexture->UploadNextLevel();
+			++nUploads;
+		}
+	}
+
+	return nUploads;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+size_t TextureStreamer::GetResidentSize() const
+{
+	size_t	size	= 0;
+
+	for ( TextureList::const_iterator ppTexture = m_Textures.begin(); ppTexture != m_Textures.end(); ++ppTexture )
+	{
+		size += ( *ppTexture )->GetResidentSize();
+	}
+
+	return size;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+void TextureStreamer::Remove( StreamingTexture * pTexture )
+{
+	TextureList::iterator	ppTexture	= std::find( m_Textures.begin(), m_Textures.end(), pTexture );
+
+	if ( ppTexture != m_Textures.end() )
+	{
+		m_Textures.erase( ppTexture );
+	}
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,182 @@
+#if !defined( GLOBJECTS_TEXTURESTREAMER_H_INCLUDED )
+#define GLOBJECTS_TEXTURESTREAMER_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                 TextureStreamer.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TextureStreamer.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <gl/gl.h>
+
+namespace Glx
+{
+	class MipMappedTexture;
+}
+
+namespace GlObjects
+{
+
+class BakedTextureFile;
+class TextureStreamer;
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// A mip-mapped texture whose levels are streamed in and out by a TextureStreamer.
+///
+/// Only the levels from the resident level through the smallest level are in texture memory. The texture's
+/// @c GL_TEXTURE_BASE_LEVEL is clamped to the resident level, so the texture can always be used, just at a lower
+/// resolution until the finer levels have been uploaded.
+
+class StreamingTexture
+{
+	friend class TextureStreamer;
+
+public:
+
+	/// Destructor
+	~StreamingTexture();
+
+	/// Sets the priority of the texture. Textures with higher priorities get their finer levels first.
+	void SetPriority( float priority )			{ m_Priority = priority; }
+
+	/// Returns the priority of the texture
+	float GetPriority() const					{ return m_Priority; }
+
+	/// Sets the finest level that is wanted
+	void SetDesiredLevel( int level );
+
+	/// Returns the finest level that is wanted
+	int GetDesiredLevel() const					{ return m_DesiredLevel; }
+
+	/// Returns the finest level in texture memory
+	int GetResidentLevel() const				{ return m_ResidentLevel; }
+
+	/// Returns the number of levels in the texture
+	int GetLevelCount() const;
+
+	/// Returns the number of bytes of texture memory used by the resident levels
+	size_t GetResidentSize() const				{ return GetSize( m_ResidentLevel ); }
+
+	/// Binds the texture
+	void Apply() const;
+
+private:
+
+	// Constructor
+	StreamingTexture( TextureStreamer * pStreamer, char const * sFileName, int tailSize,
+					  GLenum wrap, GLenum minFiltering, GLenum magFiltering );
+
+	// Prevent copying
+	StreamingTexture( StreamingTexture const & );
+	StreamingTexture & operator =( StreamingTexture const & );
+
+	// Returns the number of bytes used by the levels from the given level through the smallest level
+	size_t GetSize( int level ) const;
+
+	// Uploads the next finer level
+	void UploadNextLevel();
+
+	// Releases the levels finer than the given level
+	void DropLevels( int level );
+
+	// Sets the base level of the texture
+	void SetBaseLevel( int level );
+
+	TextureStreamer *						m_pStreamer;		///< The streamer that manages this texture
+	std::auto_ptr< BakedTextureFile >		m_qFile;			///< The source of the levels
+	std::auto_ptr< Glx::MipMappedTexture >	m_qTexture;			///< The texture
+	int										m_TailLevel;		///< The finest level that is always resident
+	int										m_ResidentLevel;	///< The finest level in texture memory
+	int										m_DesiredLevel;		///< The finest level that is wanted
+	int										m_TargetLevel;		///< The finest level that fits in the budget
+	float									m_Priority;			///< Priority of the finer levels
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Streams the mip levels of textures in and out of texture memory according to a budget.
+///
+/// The source of each texture is a baked texture file (see BakedTextureFile) that contains every mip level. When a
+/// texture is loaded, only its mip tail (the levels no larger than the tail size) is uploaded, so it can be used right
+/// away. Each call to Update() divides the budget among the textures in order of priority, releases the levels that no
+/// longer fit, and uploads a limited number of finer levels. The priorities are supplied by the caller, for example
+/// the reciprocal of the distance from the camera to the object using the texture.
+///
+/// The streamer and its textures must only be used by the thread that owns the GL context.
+
+class TextureStreamer
+{
+	friend class StreamingTexture;
+
+public:
+
+	/// Constructor
+	TextureStreamer( size_t budget, int tailSize = 64 );
+
+	/// Destructor
+	~TextureStreamer();
+
+	/// Loads the mip tail of a texture and starts streaming the rest
+	StreamingTexture * Load( char const * sFileName,
+							 GLenum wrap			= GL_REPEAT,
+							 GLenum minFiltering	= GL_LINEAR_MIPMAP_LINEAR,
+							 GLenum magFiltering	= GL_LINEAR );
+
+	/// Releases and uploads levels. Must be called periodically (for example, once per frame).
+	int Update( int maxUploads = 1 );
+
+	/// Sets the maximum amount of texture memory used by the textures' levels
+	void SetBudget( size_t budget )				{ m_Budget = budget; }
+
+	/// Returns the maximum amount of texture memory used by the textures' levels
+	size_t GetBudget() const					{ return m_Budget; }
+
+	/// Returns the amount of texture memory currently used by the textures' levels
+	size_t GetResidentSize() const;
+
+	/// Returns the number of textures being streamed
+	int GetTextureCount() const					{ return int( m_Textures.size() ); }
+
+private:
+
+	typedef std::vector< StreamingTexture * > TextureList;
+
+	// Prevent copying
+	TextureStreamer( TextureStreamer const & );
+	TextureStreamer & operator =( TextureStreamer const & );
+
+	// Stops streaming a texture (called when the texture is destroyed)
+	void Remove( StreamingTexture * pTexture );
+
+	size_t			m_Budget;			///< Maximum texture memory used by the levels
+	int				m_TailSize;			///< Levels no wider or taller than this are always resident
+	TextureList		m_Textures;			///< The textures being streamed
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_TEXTURESTREAMER_H_INCLUDED )
@@ -0,0 +1,342 @@
+/** @file *//********************************************************************************************************
+
+                                                    TgaImage.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TgaImage.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include "TgaImage.h"
+
+#include "MappedTgaFile.h"
+#include "PixelConverter.h"
+#include "TgaRleDecoder.h"
+
+#include "Misc/auto_array_ptr.h"
+#include "Misc/Types.h"
+#include "TgaFile/TgaFile.h"
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+namespace
+{
+
+// Returns the number of bytes per pixel of an image with the given characteristics. Throws std::runtime_error if the
+// format is not supported.
+
+int GetTrueColorTexelSize( int depth, int alphaDepth )
+{
+	if ( depth == 32 && alphaDepth == 8 )
+	{
+		return 4;
+	}
+	else if ( depth == 24 && alphaDepth == 0 )
+	{
+		return 3;
+	}
+	else
+	{
+		throw std::runtime_error( "Invalid pixel format" );
+	}
+}
+
+// Returns the number of bytes per pixel of a grayscale image with the given characteristics. Throws
+// std::runtime_error if the format is not supported.
+
+int GetGrayscaleTexelSize( int depth, int alphaDepth )
+{
+	if ( depth == 16 && alphaDepth == 8 )
+	{
+		return 2;
+	}
+	else if ( depth == 8 && alphaDepth == 0 )
+	{
+		return 1;
+	}
+	else
+	{
+		throw std::runtime_error( "Invalid pixel format" );
+	}
+}
+
+// Returns true if the image type is one that is loaded from the mapped file
+
+bool IsSupportedImageType( int imageType )
+{
+	return imageType == GlObjects::MappedTgaFile::IMAGE_TRUECOLOR ||
+		   imageType == GlObjects::MappedTgaFile::IMAGE_GRAYSCALE ||
+		   imageType == GlObjects::MappedTgaFile::IMAGE_RLE_TRUECOLOR ||
+		   imageType == GlObjects::MappedTgaFile::IMAGE_RLE_GRAYSCALE;
+}
+
+// The conversions that are applied to the data in a file
+
+struct Conversion
+{
+	int		texelSize;		// Bytes per pixel after conversion
+	GLenum	format;			// GL format after conversion
+	bool	bExpand;		// Expand BGR to BGRA
+	bool	bPremultiply;	// Premultiply by alpha
+	bool	bSwizzle;		// Swap red and blue
+};
+
+// Determines the conversions to apply to data with the given texel size
+
+Conversion GetConversion( int texelSize, unsigned flags )
+{
+	Conversion	c;
+
+	c.bExpand		= ( texelSize == 3 ) && ( flags & ( GlObjects::TGA_LOAD_EXPAND_TO_BGRA | GlObjects::TGA_LOAD_RGBA_ORDER ) ) != 0;
+	c.texelSize		= c.bExpand ? 4 : texelSize;
+	c.bPremultiply	= ( texelSize == 4 ) && ( flags & GlObjects::TGA_LOAD_PREMULTIPLY_ALPHA ) != 0;
+	c.bSwizzle		= ( c.texelSize == 4 ) && ( flags & GlObjects::TGA_LOAD_RGBA_ORDER ) != 0;
+
+	switch ( c.texelSize )
+	{
+	case 1:		c.format = GL_LUMINANCE;						break;
+	case 2:		c.format = GL_LUMINANCE_ALPHA;					break;
+	case 3:		c.format = GL_BGR_EXT;							break;
+	default:	c.format = c.bSwizzle ? GL_RGBA : GL_BGRA_EXT;	break;
+	}
+
+	return c;
+}
+
+// Returns a buffer for the image data, either from the allocator or owned by the image
+
+uint8 * AllocateImageBuffer( GlObjects::TgaImage * pImage, GlObjects::TgaImageAllocator * pAllocator, size_t size )
+{
+	uint8 *	pBuffer;
+
+	if ( pAllocator != 0 )
+	{
+		pBuffer = pAllocator->Allocate( size );
+	}
+	else
+	{
+		pImage->qaBuffer = auto_array_ptr< uint8 >( new uint8[ size ] );
+		pBuffer = pImage->qaBuffer.get();
+	}
+	if ( pBuffer == 0 ) throw std::bad_alloc();
+
+	return pBuffer;
+}
+
+// Applies the conversions that can be done in place
+
+void ConvertInPlace( uint8 * pData, size_t nPixels, Conversion const & conversion )
+{
+	if ( conversion.bPremultiply )
+	{
+		GlObjects::PixelConverter::PremultiplyAlpha( pData, pData, nPixels );
+	}
+
+	if ( conversion.bSwizzle )
+	{
+		GlObjects::PixelConverter::SwizzleBgraToRgba( pData, pData, nPixels );
+	}
+}
+
+// Loads the image from the mapped file in pImage->qMappedFile. Uncompressed bottom-left images with no conversions
+// are used in place. Other images are decoded and converted directly from the mapped file into a buffer. Returns false
+// if the mapped file can't be used.
+
+bool LoadMappedImage( GlObjects::TgaImage * pImage, unsigned flags, GlObjects::TgaImageAllocator * pAllocator )
+{
+	using GlObjects::MappedTgaFile;
+	using GlObjects::PixelConverter;
+	using GlObjects::TgaRleDecoder;
+
+	MappedTgaFile const * const	pMappedFile	= pImage->qMappedFile.get();
+
+	if ( !IsSupportedImageType( pMappedFile->m_ImageType ) ||
+		 ( pMappedFile->m_Order != MappedTgaFile::ORDER_BOTTOMLEFT && pMappedFile->m_Order != MappedTgaFile::ORDER_TOPLEFT ) )
+	{
+		return false;
+	}
+
+	bool const			bGrayscale	= ( pMappedFile->m_ImageType == MappedTgaFile::IMAGE_GRAYSCALE ||
+										pMappedFile->m_ImageType == MappedTgaFile::IMAGE_RLE_GRAYSCALE );
+	bool const			bRle		= ( pMappedFile->m_ImageType == MappedTgaFile::IMAGE_RLE_TRUECOLOR ||
+										pMappedFile->m_ImageType == MappedTgaFile::IMAGE_RLE_GRAYSCALE );
+	int const			width		= pMappedFile->m_Width;
+	int const			height		= pMappedFile->m_Height;
+	size_t const		nPixels		= size_t( width ) * height;
+	int const			texelSize	= bGrayscale ? GetGrayscaleTexelSize( pMappedFile->m_Depth, pMappedFile->m_AlphaDepth )
+											 : GetTrueColorTexelSize( pMappedFile->m_Depth, pMappedFile->m_AlphaDepth );
+	Conversion const	conversion	= GetConversion( texelSize, flags );
+	bool const			bFlip		= ( pMappedFile->m_Order == MappedTgaFile::ORDER_TOPLEFT );
+	uint8 const * const	pPixels		= pMappedFile->GetPixels();
+
+	if ( !bRle && pMappedFile->GetPixelDataSize() < nPixels * texelSize )
+	{
+		return false;
+	}
+
+	pImage->width		= width;
+	pImage->height		= height;
+	pImage->format		= conversion.format;
+	pImage->texelSize	= conversion.texelSize;
+
+	if ( !bRle && !bFlip && !conversion.bExpand && !conversion.bPremultiply && !conversion.bSwizzle )
+	{
+		pImage->pData = pPixels;
+		return true;
+	}
+
+	uint8 * const			pBuffer	= AllocateImageBuffer( pImage, pAllocator, nPixels * conversion.texelSize );
+	uint8 const *			pSource	= pPixels;
+	auto_array_ptr< uint8 >	qaDecoded;
+
+	// Decode compressed data. If it is going to be expanded, it is decoded into a temporary buffer first.
+
+	if ( bRle )
+	{
+		uint8 *	pDecoded	= pBuffer;
+
+		if ( conversion.bExpand )
+		{
+			qaDecoded = auto_array_ptr< uint8 >( new uint8[ nPixels * texelSize ] );
+			if ( qaDecoded.get() == 0 ) throw std::bad_alloc();
+			pDecoded = qaDecoded.get();
+		}
+
+		TgaRleDecoder::Decode( pPixels, pMappedFile->GetPixelDataSize(), texelSize, pDecoded, nPixels );
+		pSource = pDecoded;
+	}
+
+	if ( conversion.bExpand )
+	{
+		PixelConverter::ExpandBgrToBgra( pSource, pBuffer, nPixels );
+	}
+	else if ( pSource != pBuffer )
+	{
+		memcpy( pBuffer, pSource, nPixels * texelSize );
+	}
+
+	if ( bFlip )
+	{
+		PixelConverter::FlipVertical( pBuffer, size_t( width ) * conversion.texelSize, height );
+	}
+
+	ConvertInPlace( pBuffer, nPixels, conversion );
+
+	pImage->pData = pBuffer;
+	pImage->qMappedFile.reset();
+	return true;
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// If @c TGA_LOAD_MAP is specified and the pixels in the file are already in the order and format that GL expects
+/// (uncompressed, bottom-left origin, and no conversions requested), then the file is mapped and the data is used in
+/// place. Otherwise, the data is read and converted into a buffer. The file format must be 24-bit or 32-bit truecolor,
+/// or 8-bit or 16-bit (with alpha) grayscale, and it may be run-length encoded. Grayscale images are loaded as
+/// @c GL_LUMINANCE or @c GL_LUMINANCE_ALPHA.
+///
+/// @param	sFileName	Name of the file to load
+/// @param	flags		How to load the file. The value is any combination of TgaLoadFlags.
+/// @param	pImage		Where to put the loaded image
+/// @param	pAllocator	If not 0, supplies the memory the data is read into when it can't be used in place. If 0,
+///						the memory is allocated and owned by the image.
+///
+/// @warning	This function may throw a ConstructorFailedException, <tt>std::runtime_error</tt>, or a
+///				<tt>std::bad_alloc</tt>.
+
+void LoadTgaImage( char const * sFileName, unsigned flags, TgaImage * pImage, TgaImageAllocator * pAllocator/* = 0*/ )
+{
+	// Try the mapped path first
+
+	if ( ( flags & TGA_LOAD_MAP ) != 0 )
+	{
+		try
+		{
+			pImage->qMappedFile.reset( new MappedTgaFile( sFileName ) );
+		}
+		catch ( std::runtime_error const & )
+		{
+			// Fall back to reading the file
+		}
+
+		if ( pImage->qMappedFile.get() != 0 && LoadMappedImage( pImage, flags, pAllocator ) )
+		{
+			return;
+		}
+
+		// The mapping can't be used
+
+		pImage->qMappedFile.reset();
+	}
+
+	// Read the data
+
+	bool		ok;
+	TgaFile		file( sFileName );
+
+	// TgaFile only reads uncompressed truecolor data. Other formats are decoded from a mapping of the file.
+
+	if ( file.m_ImageType != TgaFile::IMAGE_TRUECOLOR )
+	{
+		pImage->qMappedFile.reset( new MappedTgaFile( sFileName ) );
+		if ( !LoadMappedImage( pImage, flags, pAllocator ) ) throw std::runtime_error( "Invalid pixel format" );
+		return;
+	}
+
+	size_t const		nPixels		= size_t( file.m_Width ) * file.m_Height;
+	int const			texelSize	= GetTrueColorTexelSize( file.m_Depth, file.m_AlphaDepth );
+	Conversion const	conversion	= GetConversion( texelSize, flags );
+	uint8 *				pBuffer;
+
+	if ( conversion.bExpand )
+	{
+		// The file must be read into a temporary buffer and then expanded into the image buffer
+
+		auto_array_ptr< uint8 >	qaFileData( new uint8[ nPixels * texelSize ] );
+		if ( qaFileData.get() == 0 ) throw std::bad_alloc();
+
+		ok = file.Read( qaFileData.get(), TgaFile::ORDER_BOTTOMLEFT );
+		if ( !ok ) throw std::runtime_error( "TGAFile read failed" );
+
+		pBuffer = AllocateImageBuffer( pImage, pAllocator, nPixels * conversion.texelSize );
+		PixelConverter::ExpandBgrToBgra( qaFileData.get(), pBuffer, nPixels );
+	}
+	else
+	{
+		pBuffer = AllocateImageBuffer( pImage, pAllocator, nPixels * conversion.texelSize );
+
+		ok = file.Read( pBuffer, TgaFile::ORDER_BOTTOMLEFT );
+		if ( !ok ) throw std::runtime_error( "TGAFile read failed" );
+	}
+
+	ConvertInPlace( pBuffer, nPixels, conversion );
+
+	pImage->width		= file.m_Width;
+	pImage->height		= file.m_Height;
+	pImage->format		= conversion.format;
+	pImage->texelSize	= conversion.texelSize;
+	pImage->pData		= pBuffer;
+}
+
+
+} // namespace GlObjects
@@ -0,0 +1,81 @@
+#if !defined( GLOBJECTS_TGAIMAGE_H_INCLUDED )
+#define GLOBJECTS_TGAIMAGE_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                     TgaImage.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TgaImage.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <windows.h>
+#include <memory>
+#include <gl/gl.h>
+#include "MappedTgaFile.h"
+#include "Misc/auto_array_ptr.h"
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// The pixel data of a TGA file, ready to be uploaded.
+///
+/// The data is either mapped directly from the file or read into a buffer. Loading does not touch GL, so it can be
+/// done on any thread.
+
+struct TgaImage
+{
+	int									width;			///< Width in pixels
+	int									height;			///< Height in pixels
+	GLenum								format;			///< GL format of the data
+	int									texelSize;		///< Bytes per pixel
+	std::auto_ptr< MappedTgaFile >		qMappedFile;	///< Set if the data is in the mapped file
+	auto_array_ptr< uint8 >				qaBuffer;		///< Set if the data was read into a buffer that it owns
+	uint8 const *						pData;			///< The pixel data
+};
+
+/// Options for LoadTgaImage
+
+enum TgaLoadFlags
+{
+	TGA_LOAD_MAP				= 0x01,		///< Memory-map the file and use the data in place if possible
+	TGA_LOAD_EXPAND_TO_BGRA		= 0x02,		///< Expand 24-bit BGR data to 32-bit BGRA
+	TGA_LOAD_RGBA_ORDER			= 0x04,		///< Store data in RGBA order instead of BGR(A) (implies expansion)
+	TGA_LOAD_PREMULTIPLY_ALPHA	= 0x08		///< Multiply the color components of 32-bit data by alpha
+};
+
+/// Supplies the memory that an image is read into when it can't be used in place
+
+class TgaImageAllocator
+{
+public:
+
+	/// Destructor
+	virtual ~TgaImageAllocator() {}
+
+	/// Returns a buffer of at least @a size bytes, or 0 if it can't be allocated
+	virtual uint8 * Allocate( size_t size ) = 0;
+};
+
+/// Loads the pixel data of a TGA file
+void LoadTgaImage( char const * sFileName, unsigned flags, TgaImage * pImage, TgaImageAllocator * pAllocator = 0 );
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_TGAIMAGE_H_INCLUDED )
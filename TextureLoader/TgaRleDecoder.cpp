@@ -0,0 +1,117 @@
+/** @file *//********************************************************************************************************
+
+                                                  TgaRleDecoder.cpp
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TgaRleDecoder.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "TgaRleDecoder.h"
+
+#include "Misc/Types.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+
+// Fills pDst with n copies of the texelSize-byte pixel at pPixel
+
+inline void FillRun( uint8 * pDst, uint8 const * pPixel, int texelSize, size_t n )
+{
+	size_t const	size	= n * texelSize;
+
+	if ( texelSize == 1 )
+	{
+		memset( pDst, *pPixel, size );
+		return;
+	}
+
+	// Copy the pixel once and then double the filled area until the run is complete
+
+	memcpy( pDst, pPixel, texelSize );
+
+	size_t	filled	= texelSize;
+
+	while ( filled < size )
+	{
+		size_t const	copy	= ( filled < size - filled ) ? filled : size - filled;
+
+		memcpy( pDst + filled, pDst, copy );
+		filled += copy;
+	}
+}
+
+} // anonymous namespace
+
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// @param	pSrc		Encoded data
+/// @param	srcSize		Number of bytes available at @a pSrc
+/// @param	texelSize	Bytes per pixel (1 to 4)
+/// @param	pDst		Where to put the decoded pixels. It must hold at least <tt>nPixels * texelSize</tt> bytes.
+/// @param	nPixels		Number of pixels to decode
+///
+/// @warning	This function throws a <tt>std::runtime_error</tt> if the data is truncated or a packet extends past
+///				the end of the image.
+
+size_t TgaRleDecoder::Decode( uint8 const * pSrc, size_t srcSize, int texelSize, uint8 * pDst, size_t nPixels )
+{
+	assert( texelSize >= 1 && texelSize <= 4 );
+
+	uint8 const * const	pSrcBegin	= pSrc;
+	uint8 const * const	pSrcEnd		= pSrc + srcSize;
+	uint8 * const		pDstEnd		= pDst + nPixels * texelSize;
+
+	while ( pDst < pDstEnd )
+	{
+		if ( pSrc >= pSrcEnd ) throw std::runtime_error( "Truncated RLE data" );
+
+		int const		header	= *pSrc++;
+		size_t const	n		= ( header & 0x7f ) + 1;
+		size_t const	size	= n * texelSize;
+
+		if ( size > size_t( pDstEnd - pDst ) ) throw std::runtime_error( "Invalid RLE data" );
+
+		if ( ( header & 0x80 ) != 0 )
+		{
+			// Run packet: one pixel repeated n times
+
+			if ( size_t( pSrcEnd - pSrc ) < size_t( texelSize ) ) throw std::runtime_error( "Truncated RLE data" );
+
+			FillRun( pDst, pSrc, texelSize, n );
+			pSrc += texelSize;
+		}
+		else
+		{
+			// Literal packet: n pixels
+
+			if ( size_t( pSrcEnd - pSrc ) < size ) throw std::runtime_error( "Truncated RLE data" );
+
+			memcpy( pDst, pSrc, size );
+			pSrc += size;
+		}
+
+		pDst += size;
+	}
+
+	return pSrc - pSrcBegin;
+}
+
+
+} // namespace GlObjects
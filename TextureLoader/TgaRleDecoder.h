@@ -0,0 +1,49 @@
+#if !defined( GLOBJECTS_TGARLEDECODER_H_INCLUDED )
+#define GLOBJECTS_TGARLEDECODER_H_INCLUDED
+
+#pragma once
+
+/** @file *//********************************************************************************************************
+
+                                                   TgaRleDecoder.h
+
+						                    Copyright 2003, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/GlObjects/TextureLoader/TgaRleDecoder.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include <cstddef>
+#include "Misc/Types.h"
+
+namespace GlObjects
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/*																													*/
+/********************************************************************************************************************/
+
+/// Decodes the run-length encoded pixel data of a TGA file.
+///
+/// Each packet is handled as a whole: literal packets are copied with a single memcpy and runs are filled by
+/// repeatedly doubling the filled area, so the cost is per packet rather than per pixel. Packets may cross scan
+/// lines.
+
+class TgaRleDecoder
+{
+public:
+
+	/// Decodes @a nPixels pixels of @a texelSize bytes each. Returns the number of source bytes consumed.
+	static size_t Decode( uint8 const * pSrc, size_t srcSize, int texelSize, uint8 * pDst, size_t nPixels );
+};
+
+
+} // namespace GlObjects
+
+
+#endif // !defined( GLOBJECTS_TGARLEDECODER_H_INCLUDED )